@@ -0,0 +1,1270 @@
+#include "DataSourceConsumer.h"
+#include "DataSourceController.h"
+#include "DataSourceConvert.h"
+#include "DataSourceEmulator.h"
+#include "DataSourceFramePool.h"
+#include "DataSourceFrameRecorder.h"
+#include "DataSourceLatencyHistogram.h"
+#include "DataSourceReplay.h"
+#include "DataSourceSegmentWriter.h"
+#include "DataSourceSharedRing.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Набір вимірів для кваліфікації обладнання і пошуку регресій.
+// Результат - JSON в stdout або в файл (--out).
+//
+// DataSourceBench [--out file] [--work-dir dir] [--duration-ms N] [--iterations N]
+//                 [--max-sources N] [--rates MB,MB,...] [--disk-mb N] [--no-e2e]
+//                 [--policy block|drop-newest|drop-oldest|spill] [--depth N] [--auto-tune] [--budget-mb N]
+//                 [--workers N] [--batch-frames N] [--codec none|shuffle-lz] [--format f32|f16|bf16|i16]
+//                 [--replay record_name|file] [--replay-speed X] [--signal const|sine|chirp|noise]
+
+using namespace DATA_SOURCE_TASK;
+
+namespace
+{
+
+// 200 Гц, як у прикладі
+constexpr double BENCH_FRAME_RATE {FRAME_RATE_PER_SEC};
+
+// Розмір кадру для мікротестів: 100 МБ/с при 200 Гц
+constexpr int BENCH_FRAME_SIZE {500000};
+
+// Блок запису на диск
+constexpr std::size_t BENCH_DISK_BLOCK {4 * 1024 * 1024};
+
+// Префікс файлів, які створює тест
+const std::string BENCH_FILE_PREFIX {"bench_"};
+
+struct bench_options
+{
+    std::string out_file;
+    std::string work_dir       = "DataSourceBench.tmp";
+    int duration_ms            = 2000;
+    int iterations             = 2000;
+    int max_sources            = 4;
+    std::vector<double> rates  = {10., 25., 50., 100.}; // МБ/с
+    std::uint64_t disk_mb      = 256;
+    bool end_to_end            = true;
+    queue_config queue;        // черга в наскрізних тестах
+    pacer_config pacing;       // темп і пакетне читання в наскрізних тестах
+    RECORD_CODEC codec = RECORD_CODEC::RECORD_CODEC_NONE; // кодування архіву в тестах реєстратора і наскрізних
+    RECORD_FORMAT format = RECORD_FORMAT::RECORD_FORMAT_FLOAT32; // формат архіву в тестах реєстратора і наскрізних
+    std::string replay;        // запис для відтворення: базове ім'я сегментів реєстратора або файл
+    double replay_speed = 0.;  // 0 - якнайшвидше
+    EMULATOR_SIGNAL signal = EMULATOR_SIGNAL::EMULATOR_SIGNAL_CONSTANT; // сигнал емуляторів
+};
+
+/// \brief Результат одного виміру
+struct bench_result
+{
+    std::string name;
+    std::vector<std::pair<std::string, std::string>> params; // значення вже в JSON
+    std::vector<std::pair<std::string, double>> metrics;
+    bool has_latency = false;
+    latency_snapshot latency;
+};
+
+std::string jsonString(const std::string & value)
+{
+    std::string out = "\"";
+
+    for (const char c : value)
+    {
+        if (c == '"' || c == '\\')
+            out += '\\';
+
+        out += c;
+    }
+
+    return out + "\"";
+}
+
+std::string jsonNumber(const double & value)
+{
+    std::ostringstream ss;
+    ss.precision(12);
+    ss << value;
+
+    return ss.str();
+}
+
+void writeJson(std::ostream & os, const bench_options & options, const std::vector<bench_result> & results)
+{
+    os << "{\n";
+    os << "  \"benchmark\": \"DataSourceBench\",\n";
+    os << "  \"version\": 1,\n";
+    os << "  \"simd_level\": " << jsonString(simdLevelName(detectedSimdLevel())) << ",\n";
+    os << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+    os << "  \"config\": {\"duration_ms\": " << options.duration_ms << ", \"iterations\": " << options.iterations
+       << ", \"max_sources\": " << options.max_sources << ", \"disk_mb\": " << options.disk_mb << "},\n";
+    os << "  \"results\": [\n";
+
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        const bench_result & r = results[i];
+
+        os << "    {\"name\": " << jsonString(r.name) << ", \"params\": {";
+
+        for (std::size_t p = 0; p < r.params.size(); ++p)
+            os << (p ? ", " : "") << jsonString(r.params[p].first) << ": " << r.params[p].second;
+
+        os << "}, \"metrics\": {";
+
+        for (std::size_t m = 0; m < r.metrics.size(); ++m)
+            os << (m ? ", " : "") << jsonString(r.metrics[m].first) << ": " << jsonNumber(r.metrics[m].second);
+
+        os << "}";
+
+        if (r.has_latency)
+        {
+            os << ", \"latency_ns\": {\"count\": " << r.latency.count << ", \"min\": " << r.latency.min_ns
+               << ", \"mean\": " << r.latency.mean_ns << ", \"p50\": " << r.latency.p50_ns
+               << ", \"p90\": " << r.latency.p90_ns << ", \"p99\": " << r.latency.p99_ns
+               << ", \"p999\": " << r.latency.p999_ns << ", \"max\": " << r.latency.max_ns << "}";
+        }
+
+        os << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+
+    os << "  ]\n";
+    os << "}\n";
+}
+
+/// \brief frames/s, bytes/s, ns/frame для count кадрів по frame_bytes за elapsed_ns
+void addThroughput(
+    bench_result & result,
+    const std::uint64_t & count,
+    const double & frame_bytes,
+    const std::int64_t & elapsed_ns)
+{
+    const double seconds = elapsed_ns > 0 ? elapsed_ns / 1e9 : 1e-9;
+
+    result.metrics.emplace_back("frames", static_cast<double>(count));
+    result.metrics.emplace_back("frames_per_sec", count / seconds);
+    result.metrics.emplace_back("bytes_per_sec", count * frame_bytes / seconds);
+    result.metrics.emplace_back("ns_per_frame", count ? elapsed_ns / static_cast<double>(count) : 0.);
+}
+
+void setLatency(bench_result & result, const DataSourceLatencyHistogram & histogram)
+{
+    result.has_latency = true;
+    result.latency     = histogram.snapshot();
+}
+
+std::string filePath(const bench_options & options, const std::string & name)
+{
+    return options.work_dir + "/" + BENCH_FILE_PREFIX + name;
+}
+
+/// \brief Видаляємо файли тесту з робочого каталогу
+void cleanupFiles(const bench_options & options)
+{
+#ifndef WIN32
+    DIR * dir = opendir(options.work_dir.c_str());
+
+    if (!dir)
+        return;
+
+    while (struct dirent * entry = readdir(dir))
+    {
+        const std::string name = entry->d_name;
+
+        if (name.compare(0, BENCH_FILE_PREFIX.size(), BENCH_FILE_PREFIX) == 0)
+            std::remove((options.work_dir + "/" + name).c_str());
+    }
+
+    closedir(dir);
+#else
+    static_cast<void>(options);
+#endif
+}
+
+/// \brief Заповнюємо кадр з заголовком і пилкоподібним сигналом
+void fillFrame(DataSourceBufferInterface & buffer, const PAYLOAD_TYPE & p_type, const std::uint16_t & counter)
+{
+    const int type_size    = payloadTypeSize(p_type);
+    const int payload_size = ((buffer.size() - FRAME_HEADER_SIZE) / type_size) * type_size;
+
+    buffer.setHeader(FRAME_MAGIC_WORD);
+    buffer.setFrameCounter(counter);
+    buffer.setSourceID(1);
+    buffer.setPayloadType(p_type);
+    buffer.setPayloadSize(payload_size);
+
+    char * payload = buffer.payload();
+
+    for (int i = 0; i < payload_size; ++i)
+        payload[i] = static_cast<char>(i * 7);
+
+    // float відліки мають бути скінченними
+    if (p_type == PAYLOAD_TYPE::PAYLOAD_TYPE_32_BIT_IEEE_FLOAT)
+    {
+        float * values = reinterpret_cast<float *>(payload);
+
+        for (int i = 0; i < payload_size / FLOAT_SIZE; ++i)
+            values[i] = static_cast<float>((i % 2001) - 1000) / 1000.f;
+    }
+}
+
+const char * payloadTypeName(const PAYLOAD_TYPE & p_type)
+{
+    switch (p_type)
+    {
+    case PAYLOAD_TYPE::PAYLOAD_TYPE_8_BIT_UINT:
+        return "u8";
+    case PAYLOAD_TYPE::PAYLOAD_TYPE_16_BIT_INT:
+        return "i16";
+    case PAYLOAD_TYPE::PAYLOAD_TYPE_32_BIT_INT:
+        return "i32";
+    case PAYLOAD_TYPE::PAYLOAD_TYPE_32_BIT_IEEE_FLOAT:
+        return "f32";
+    default:
+        break;
+    }
+
+    return "unsupported";
+}
+
+const char * queuePolicyName(const QUEUE_POLICY & policy)
+{
+    switch (policy)
+    {
+    case QUEUE_POLICY::QUEUE_POLICY_BLOCK:
+        return "block";
+    case QUEUE_POLICY::QUEUE_POLICY_DROP_NEWEST:
+        return "drop-newest";
+    case QUEUE_POLICY::QUEUE_POLICY_DROP_OLDEST:
+        return "drop-oldest";
+    case QUEUE_POLICY::QUEUE_POLICY_SPILL:
+        return "spill";
+    default:
+        break;
+    }
+
+    return "unknown";
+}
+
+const PAYLOAD_TYPE BENCH_PAYLOAD_TYPES[] = {
+    PAYLOAD_TYPE::PAYLOAD_TYPE_8_BIT_UINT,
+    PAYLOAD_TYPE::PAYLOAD_TYPE_16_BIT_INT,
+    PAYLOAD_TYPE::PAYLOAD_TYPE_32_BIT_INT,
+    PAYLOAD_TYPE::PAYLOAD_TYPE_32_BIT_IEEE_FLOAT,
+};
+
+/// \brief convertToFloat для кожного типу даних і кожного набору інструкцій
+void benchConvert(const bench_options & options, std::vector<bench_result> & results)
+{
+    DataSourceFramePool src_pool(BENCH_FRAME_SIZE, 1, UINT8_SIZE);
+    std::vector<float> dst(BENCH_FRAME_SIZE);
+
+    const DATA_SOURCE_SIMD_LEVEL saved = simdLevel();
+
+    for (const PAYLOAD_TYPE p_type : BENCH_PAYLOAD_TYPES)
+    {
+        DataSourceFrameHandle frame = src_pool.acquire();
+        fillFrame(*frame, p_type, 0);
+
+        const int payload_size = frame->payloadSize();
+
+        for (int level = 0; level <= static_cast<int>(detectedSimdLevel()); ++level)
+        {
+            setSimdLevel(static_cast<DATA_SOURCE_SIMD_LEVEL>(level));
+
+            DataSourceLatencyHistogram histogram;
+            Timer total;
+            Timer timer;
+
+            for (int i = 0; i < options.iterations; ++i)
+            {
+                timer.reset();
+                convertToFloat(p_type, frame->payload(), payload_size, dst.data());
+                histogram.record(timer.elapsedNs());
+            }
+
+            const std::int64_t elapsed_ns = total.elapsedNs();
+
+            bench_result result;
+            result.name = "convert_to_float";
+            result.params.emplace_back("payload_type", jsonString(payloadTypeName(p_type)));
+            result.params.emplace_back("simd", jsonString(simdLevelName(static_cast<DATA_SOURCE_SIMD_LEVEL>(level))));
+            result.params.emplace_back("payload_bytes", std::to_string(payload_size));
+            addThroughput(result, options.iterations, payload_size, elapsed_ns);
+            setLatency(result, histogram);
+
+            results.push_back(result);
+        }
+    }
+
+    setSimdLevel(saved);
+}
+
+const char * emulatorSignalName(const EMULATOR_SIGNAL & signal)
+{
+    switch (signal)
+    {
+    case EMULATOR_SIGNAL::EMULATOR_SIGNAL_SINE:
+        return "sine";
+    case EMULATOR_SIGNAL::EMULATOR_SIGNAL_CHIRP:
+        return "chirp";
+    case EMULATOR_SIGNAL::EMULATOR_SIGNAL_NOISE:
+        return "noise";
+    default:
+        return "const";
+    }
+}
+
+/// \brief Швидкість емулятора без збоїв: позичені кадри (acquire/commit) і копія (read)
+void benchEmulator(const bench_options & options, std::vector<bench_result> & results)
+{
+    emulator_config config;
+    config.signal = options.signal;
+    config.faults.clear();
+
+    DataSourceFileEmulator emulator(PAYLOAD_TYPE::PAYLOAD_TYPE_16_BIT_INT, BENCH_FRAME_SIZE, config);
+    std::vector<char> buffer(BENCH_FRAME_SIZE);
+
+    for (const bool is_copy : {false, true})
+    {
+        DataSourceLatencyHistogram histogram;
+        Timer total;
+        Timer timer;
+
+        for (int i = 0; i < options.iterations; ++i)
+        {
+            timer.reset();
+
+            if (is_copy)
+            {
+                emulator.read(buffer.data(), BENCH_FRAME_SIZE);
+            }
+            else
+            {
+                const read_block block = emulator.acquire(buffer.data(), BENCH_FRAME_SIZE);
+                emulator.commit(block, block.size);
+            }
+
+            histogram.record(timer.elapsedNs());
+        }
+
+        const std::int64_t elapsed_ns = total.elapsedNs();
+
+        bench_result result;
+        result.name = is_copy ? "emulator_read" : "emulator_acquire";
+        result.params.emplace_back("signal", jsonString(emulatorSignalName(options.signal)));
+        result.params.emplace_back("frame_bytes", std::to_string(BENCH_FRAME_SIZE));
+        addThroughput(result, options.iterations, BENCH_FRAME_SIZE, elapsed_ns);
+        setLatency(result, histogram);
+
+        results.push_back(result);
+    }
+}
+
+const RECORD_FORMAT BENCH_RECORD_FORMATS[] = {
+    RECORD_FORMAT::RECORD_FORMAT_FLOAT16,
+    RECORD_FORMAT::RECORD_FORMAT_BFLOAT16,
+    RECORD_FORMAT::RECORD_FORMAT_INT16,
+};
+
+/// \brief convertToRecord для кожного формату запису і кожного набору інструкцій
+void benchRecordFormat(const bench_options & options, std::vector<bench_result> & results)
+{
+    std::vector<float> src(BENCH_FRAME_SIZE);
+    std::vector<char> dst(BENCH_FRAME_SIZE * FLOAT_SIZE);
+
+    for (int i = 0; i < BENCH_FRAME_SIZE; ++i)
+        src[i] = static_cast<float>((i % 2001) - 1000) / 1000.f;
+
+    const DATA_SOURCE_SIMD_LEVEL saved = simdLevel();
+
+    for (const RECORD_FORMAT format : BENCH_RECORD_FORMATS)
+    {
+        for (int level = 0; level <= static_cast<int>(detectedSimdLevel()); ++level)
+        {
+            setSimdLevel(static_cast<DATA_SOURCE_SIMD_LEVEL>(level));
+
+            DataSourceLatencyHistogram histogram;
+            Timer total;
+            Timer timer;
+
+            for (int i = 0; i < options.iterations; ++i)
+            {
+                timer.reset();
+                convertToRecord(format, src.data(), BENCH_FRAME_SIZE, dst.data(), INT16_RECORD_SCALE);
+                histogram.record(timer.elapsedNs());
+            }
+
+            const std::int64_t elapsed_ns = total.elapsedNs();
+
+            bench_result result;
+            result.name = "convert_to_record";
+            result.params.emplace_back("format", jsonString(recordFormatName(format)));
+            result.params.emplace_back("simd", jsonString(simdLevelName(static_cast<DATA_SOURCE_SIMD_LEVEL>(level))));
+            result.params.emplace_back("frame_elements", std::to_string(BENCH_FRAME_SIZE));
+            addThroughput(result, options.iterations, BENCH_FRAME_SIZE * FLOAT_SIZE, elapsed_ns);
+            setLatency(result, histogram);
+
+            results.push_back(result);
+        }
+    }
+
+    setSimdLevel(saved);
+}
+
+/// \brief validateFrame і putNewFrame процесора кадрів
+void benchProcessor(const bench_options & options, std::vector<bench_result> & results)
+{
+    recorder_config rec_config;
+    rec_config.record_prefix = filePath(options, "processor_");
+
+    for (const PAYLOAD_TYPE p_type : BENCH_PAYLOAD_TYPES)
+    {
+        const int type_size = payloadTypeSize(p_type);
+
+        // Пули мають пережити процесор: в його черзі можуть лишитись наші кадри
+        DataSourceFramePool src_pool(BENCH_FRAME_SIZE, DEFAULT_QUEUE_DEPTH + 2, UINT8_SIZE);
+        DataSourceFramePool flt_pool(
+            FRAME_HEADER_SIZE + (BENCH_FRAME_SIZE - FRAME_HEADER_SIZE) * FLOAT_SIZE, 1, FLOAT_SIZE);
+
+        // Процесор з потоком обробки, який поки що простоює: черга порожня
+        DataSourceFrameProcessor processor(BENCH_FRAME_SIZE, queue_config(), rec_config);
+
+        {
+            DataSourceFrameHandle frame     = src_pool.acquire();
+            DataSourceFrameHandle flt_frame = flt_pool.acquire();
+
+            fillFrame(*frame, p_type, 0);
+
+            DataSourceLatencyHistogram histogram;
+            Timer total;
+            Timer timer;
+
+            for (int i = 0; i < options.iterations; ++i)
+            {
+                frame->setFrameCounter(static_cast<std::uint16_t>(i));
+
+                timer.reset();
+                processor.validateFrame(*frame, *flt_frame);
+                histogram.record(timer.elapsedNs());
+            }
+
+            bench_result result;
+            result.name = "validate_frame";
+            result.params.emplace_back("payload_type", jsonString(payloadTypeName(p_type)));
+            result.params.emplace_back("frame_bytes", std::to_string(BENCH_FRAME_SIZE));
+            addThroughput(result, options.iterations, BENCH_FRAME_SIZE, total.elapsedNs());
+            setLatency(result, histogram);
+
+            results.push_back(result);
+        }
+
+        // putNewFrame: постановка в чергу, кадри обробляє і записує потік процесора
+        DataSourceLatencyHistogram histogram;
+        std::uint64_t accepted = 0;
+        std::uint64_t retries  = 0;
+
+        Timer total;
+        Timer timer;
+
+        for (int i = 0; i < options.iterations; ++i)
+        {
+            DataSourceFrameHandle frame = src_pool.acquire();
+
+            // всі кадри в черзі - чекаємо, поки потік обробки поверне
+            while (!frame)
+            {
+                std::this_thread::yield();
+                frame = src_pool.acquire();
+            }
+
+            fillFrame(*frame, p_type, static_cast<std::uint16_t>(i));
+
+            const int frame_bytes = FRAME_HEADER_SIZE + (BENCH_FRAME_SIZE - FRAME_HEADER_SIZE) / type_size * type_size;
+
+            // переповнення черги - кадр лишається у нас, пробуємо ще раз
+            while (frame)
+            {
+                timer.reset();
+                processor.putNewFrame(frame, frame_bytes);
+                histogram.record(timer.elapsedNs());
+
+                if (frame)
+                {
+                    ++retries;
+                    std::this_thread::yield();
+                }
+            }
+
+            ++accepted;
+        }
+
+        const std::int64_t elapsed_ns = total.elapsedNs();
+
+        bench_result result;
+        result.name = "put_new_frame";
+        result.params.emplace_back("payload_type", jsonString(payloadTypeName(p_type)));
+        result.params.emplace_back("frame_bytes", std::to_string(BENCH_FRAME_SIZE));
+        result.params.emplace_back("queue_depth", std::to_string(processor.queueDepth()));
+        addThroughput(result, accepted, BENCH_FRAME_SIZE, elapsed_ns);
+        result.metrics.emplace_back("queue_full_retries", static_cast<double>(retries));
+        setLatency(result, histogram);
+
+        results.push_back(result);
+
+        cleanupFiles(options);
+    }
+}
+
+/// \brief DataSourceFrameRecorder::putNewFrame: розкладання float кадрів по блоках запису
+void benchRecorder(const bench_options & options, std::vector<bench_result> & results)
+{
+    const int num_elements = BENCH_FRAME_SIZE - FRAME_HEADER_SIZE;
+
+    DataSourceFramePool flt_pool(FRAME_HEADER_SIZE + num_elements * FLOAT_SIZE, 1, FLOAT_SIZE);
+    DataSourceFrameHandle flt_frame = flt_pool.acquire();
+    fillFrame(*flt_frame, PAYLOAD_TYPE::PAYLOAD_TYPE_32_BIT_IEEE_FLOAT, 0);
+
+    const int total_elements = flt_frame->payloadSize() / FLOAT_SIZE;
+
+    const RECORD_MODE modes[]       = {RECORD_MODE::RECORD_MODE_ARCHIVE, RECORD_MODE::RECORD_MODE_FLIGHT_RING};
+    const char * const mode_names[] = {"archive", "flight_ring"};
+
+    for (int m = 0; m < 2; ++m)
+    {
+        recorder_config rec_config;
+        rec_config.mode             = modes[m];
+        rec_config.flight_ring_size = 64ull * 1024ull * 1024ull;
+        rec_config.codec            = options.codec;
+        rec_config.format           = options.format;
+
+        DataSourceLatencyHistogram histogram;
+        DataSourceLatencyHistogram write_histogram;
+
+        std::uint64_t dropped = 0;
+        std::uint64_t written = 0;
+        std::uint64_t raw     = 0;
+        std::int64_t elapsed_ns = 0;
+
+        {
+            DataSourceFrameRecorder recorder(
+                filePath(options, std::string("recorder_") + mode_names[m]),
+                total_elements,
+                rec_config,
+                &write_histogram);
+
+            Timer total;
+            Timer timer;
+
+            for (int i = 0; i < options.iterations; ++i)
+            {
+                flt_frame->setFrameCounter(static_cast<std::uint16_t>(i));
+
+                timer.reset();
+                recorder.putNewFrame(*flt_frame, total_elements);
+                histogram.record(timer.elapsedNs());
+            }
+
+            elapsed_ns = total.elapsedNs();
+
+            // лічильники записаних байт - після того, як потік запису допише готові буфери
+            recorder.stop();
+
+            dropped = recorder.droppedSamples();
+            written = recorder.bytesWritten();
+            raw     = recorder.rawBytesWritten();
+        }
+
+        bench_result result;
+        result.name = "recorder_put_new_frame";
+        result.params.emplace_back("mode", jsonString(mode_names[m]));
+        result.params.emplace_back("codec", jsonString(recordCodecName(options.codec)));
+        result.params.emplace_back("format", jsonString(recordFormatName(options.format)));
+        result.params.emplace_back("frame_elements", std::to_string(total_elements));
+        addThroughput(result, options.iterations, total_elements * FLOAT_SIZE, elapsed_ns);
+        result.metrics.emplace_back("dropped_samples", static_cast<double>(dropped));
+        result.metrics.emplace_back("bytes_written", static_cast<double>(written));
+        result.metrics.emplace_back("compression_ratio", written ? static_cast<double>(raw) / written : 0.);
+        result.metrics.emplace_back("disk_write_p99_ns", static_cast<double>(write_histogram.snapshot().p99_ns));
+        setLatency(result, histogram);
+
+        results.push_back(result);
+
+        cleanupFiles(options);
+    }
+}
+
+// Читачі кільця спільної пам'яті в тесті публікації
+constexpr int BENCH_SHARED_READERS {2};
+
+/// \brief Публікація перетворених кадрів в кільце спільної пам'яті, читачі без копіювання в окремих потоках
+void benchSharedRing(const bench_options & options, std::vector<bench_result> & results)
+{
+    const int num_elements = BENCH_FRAME_SIZE - FRAME_HEADER_SIZE;
+
+    DataSourceFramePool flt_pool(FRAME_HEADER_SIZE + num_elements * FLOAT_SIZE, 1, FLOAT_SIZE);
+    DataSourceFrameHandle flt_frame = flt_pool.acquire();
+    fillFrame(*flt_frame, PAYLOAD_TYPE::PAYLOAD_TYPE_32_BIT_IEEE_FLOAT, 0);
+
+    const int total_elements = flt_frame->payloadSize() / FLOAT_SIZE;
+    const std::string name   = "/" + BENCH_FILE_PREFIX + "shared_ring";
+
+    DataSourceSharedRingWriter writer(name, 1, static_cast<std::uint32_t>(num_elements));
+
+    if (!writer.isOpen())
+        return;
+
+    std::atomic<bool> is_done {false};
+    std::atomic<std::uint64_t> read_frames {0};
+    std::atomic<std::uint64_t> lost_frames {0};
+    std::vector<std::thread> readers;
+
+    for (int r = 0; r < BENCH_SHARED_READERS; ++r)
+    {
+        readers.emplace_back([&]() {
+            DataSourceSharedRingReader reader(name);
+            shared_frame_view view;
+            std::uint64_t frames = 0;
+            float sum = 0.f;
+
+            for (;;)
+            {
+                const bool is_last = is_done;
+
+                if (!reader.acquire(view))
+                {
+                    if (is_last)
+                        break;
+
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                // читач торкається кожної кеш-лінії кадру
+                for (std::uint32_t i = 0; i < view.elements; i += CACHE_LINE_SIZE / FLOAT_SIZE)
+                    sum += view.samples[i];
+
+                if (reader.release(view))
+                    ++frames;
+            }
+
+            read_frames += frames;
+            lost_frames += reader.lost();
+
+            static_cast<void>(sum);
+        });
+    }
+
+    // читачі відкрили кільце до першого кадру
+    while (writer.readers().size() < static_cast<std::size_t>(BENCH_SHARED_READERS))
+        std::this_thread::yield();
+
+    DataSourceLatencyHistogram histogram;
+    Timer total;
+    Timer timer;
+
+    for (int i = 0; i < options.iterations; ++i)
+    {
+        flt_frame->setFrameCounter(static_cast<std::uint16_t>(i));
+
+        timer.reset();
+        writer.publish(*flt_frame, total_elements, PAYLOAD_TYPE::PAYLOAD_TYPE_16_BIT_INT);
+        histogram.record(timer.elapsedNs());
+    }
+
+    const std::int64_t elapsed_ns = total.elapsedNs();
+
+    is_done = true;
+
+    for (auto & reader : readers)
+        reader.join();
+
+    bench_result result;
+    result.name = "shared_ring_publish";
+    result.params.emplace_back("readers", std::to_string(BENCH_SHARED_READERS));
+    result.params.emplace_back("slots", std::to_string(DEFAULT_SHARED_RING_SLOTS));
+    result.params.emplace_back("frame_elements", std::to_string(total_elements));
+    addThroughput(result, options.iterations, total_elements * FLOAT_SIZE, elapsed_ns);
+    result.metrics.emplace_back("reader_frames", static_cast<double>(read_frames) / BENCH_SHARED_READERS);
+    result.metrics.emplace_back("reader_lost", static_cast<double>(lost_frames) / BENCH_SHARED_READERS);
+    setLatency(result, histogram);
+
+    results.push_back(result);
+}
+
+// Розсилка кадрів споживачам: швидкі споживачі, один повільний і темп публікації
+constexpr int BENCH_FAST_CONSUMERS {3};
+constexpr int BENCH_SLOW_CONSUMER_MS {5};
+constexpr int BENCH_FANOUT_INTERVAL_US {500};
+
+/// \brief Споживач, що читає кожну кеш-лінію кадру і за потреби імітує повільну обробку
+class BenchConsumer final : public DataSourceConsumer
+{
+public:
+    explicit BenchConsumer(const int & delay_ms):
+        m_delay_ms {delay_ms}
+    {
+    }
+
+    void consume(const frame_view & view) override
+    {
+        for (int i = 0; i < view.elements; i += CACHE_LINE_SIZE / FLOAT_SIZE)
+            m_sum += view.samples()[i];
+
+        if (m_delay_ms)
+            std::this_thread::sleep_for(std::chrono::milliseconds(m_delay_ms));
+    }
+
+private:
+    const int m_delay_ms;
+    float m_sum = 0.f;
+};
+
+/// \brief Розсилка одного кадру кільком споживачам без копіювання; повільний споживач не має гальмувати решту
+void benchConsumerFanout(const bench_options & options, std::vector<bench_result> & results)
+{
+    const int num_elements = BENCH_FRAME_SIZE - FRAME_HEADER_SIZE;
+
+    DataSourceFramePool flt_pool(
+        FRAME_HEADER_SIZE + num_elements * FLOAT_SIZE, 1, FLOAT_SIZE, 1 + MAX_CONSUMER_FRAMES);
+
+    DataSourceLatencyHistogram histogram;
+    std::uint64_t exhausted = 0;
+    std::vector<consumer_stats> stats;
+    std::int64_t elapsed_ns = 0;
+
+    const int frames = std::min(options.iterations, 2000);
+
+    {
+        DataSourceConsumerHub hub;
+
+        for (int c = 0; c <= BENCH_FAST_CONSUMERS; ++c)
+        {
+            consumer_config config;
+            config.name = c < BENCH_FAST_CONSUMERS ? "fast" : "slow";
+
+            hub.add(std::make_shared<BenchConsumer>(c < BENCH_FAST_CONSUMERS ? 0 : BENCH_SLOW_CONSUMER_MS), config);
+            flt_pool.grow(config.depth + 1);
+        }
+
+        Timer total;
+        Timer timer;
+
+        auto next = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < frames; ++i)
+        {
+            DataSourceFrameHandle flt_frame = flt_pool.acquire();
+
+            if (!flt_frame)
+            {
+                ++exhausted;
+                continue;
+            }
+
+            fillFrame(*flt_frame, PAYLOAD_TYPE::PAYLOAD_TYPE_32_BIT_IEEE_FLOAT, static_cast<std::uint16_t>(i));
+
+            timer.reset();
+            hub.publish(flt_frame, num_elements, PAYLOAD_TYPE::PAYLOAD_TYPE_16_BIT_INT);
+            histogram.record(timer.elapsedNs());
+
+            next += std::chrono::microseconds(BENCH_FANOUT_INTERVAL_US);
+            std::this_thread::sleep_until(next);
+        }
+
+        elapsed_ns = total.elapsedNs();
+
+        // черги швидких споживачів дочитуються
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        stats = hub.stats();
+    }
+
+    double fast_delivered = 0.;
+    double fast_dropped   = 0.;
+    double fast_queue_p99 = 0.;
+    double slow_dropped   = 0.;
+
+    for (const auto & consumer : stats)
+    {
+        if (consumer.name == "fast")
+        {
+            fast_delivered += consumer.delivered;
+            fast_dropped += consumer.dropped;
+            fast_queue_p99 = std::max(fast_queue_p99, static_cast<double>(consumer.queue_latency.p99_ns));
+        }
+        else
+        {
+            slow_dropped += consumer.dropped;
+        }
+    }
+
+    bench_result result;
+    result.name = "consumer_fanout";
+    result.params.emplace_back("fast_consumers", std::to_string(BENCH_FAST_CONSUMERS));
+    result.params.emplace_back("slow_consumer_ms", std::to_string(BENCH_SLOW_CONSUMER_MS));
+    result.params.emplace_back("interval_us", std::to_string(BENCH_FANOUT_INTERVAL_US));
+    addThroughput(result, frames, num_elements * FLOAT_SIZE, elapsed_ns);
+    result.metrics.emplace_back("fast_delivered", fast_delivered / BENCH_FAST_CONSUMERS);
+    result.metrics.emplace_back("fast_dropped", fast_dropped / BENCH_FAST_CONSUMERS);
+    result.metrics.emplace_back("fast_queue_p99_ns", fast_queue_p99);
+    result.metrics.emplace_back("slow_dropped", slow_dropped);
+    result.metrics.emplace_back("pool_exhausted", static_cast<double>(exhausted));
+    setLatency(result, histogram);
+
+    results.push_back(result);
+}
+
+/// \brief Послідовний запис сегментним записувачем, з O_DIRECT і через page cache
+void benchDisk(const bench_options & options, std::vector<bench_result> & results)
+{
+    std::vector<char, DataSourceAlignedAllocator<char>> block(BENCH_DISK_BLOCK);
+
+    for (std::size_t i = 0; i < block.size(); ++i)
+        block[i] = static_cast<char>(i);
+
+    const std::uint64_t blocks = std::max<std::uint64_t>(1, options.disk_mb * 1024 * 1024 / BENCH_DISK_BLOCK);
+
+    for (const bool direct : {true, false})
+    {
+        DataSourceLatencyHistogram histogram;
+        std::uint64_t ok          = 0;
+        bool is_direct            = false;
+        std::int64_t elapsed_ns   = 0;
+
+        {
+            DataSourceSegmentWriter writer(
+                filePath(options, direct ? "disk_direct" : "disk_buffered"),
+                DEFAULT_SEGMENT_SIZE,
+                0,
+                direct);
+
+            Timer total;
+            Timer timer;
+
+            for (std::uint64_t i = 0; i < blocks; ++i)
+            {
+                timer.reset();
+
+                if (writer.write(block.data(), block.size()))
+                    ++ok;
+
+                histogram.record(timer.elapsedNs());
+            }
+
+            is_direct = writer.isDirect();
+
+            // close() входить в замір: для page cache це момент, коли дані ще не на диску
+            writer.close();
+            elapsed_ns = total.elapsedNs();
+        }
+
+        bench_result result;
+        result.name = "disk_write";
+        result.params.emplace_back("direct_io_requested", direct ? "true" : "false");
+        result.params.emplace_back("direct_io", is_direct ? "true" : "false");
+        result.params.emplace_back("block_bytes", std::to_string(BENCH_DISK_BLOCK));
+        addThroughput(result, ok, BENCH_DISK_BLOCK, elapsed_ns);
+        setLatency(result, histogram);
+
+        results.push_back(result);
+
+        cleanupFiles(options);
+    }
+}
+
+/// \brief Наскрізний тест: емулятор -> контролер -> обробка -> запис, для кожної швидкості і к-сті джерел
+void benchEndToEnd(const bench_options & options, std::vector<bench_result> & results)
+{
+    for (const double rate_mb : options.rates)
+    {
+        // за такт читається batch_frames кадрів, частота кадрів - BENCH_FRAME_RATE * batch_frames
+        const int frame_size =
+            static_cast<int>(rate_mb * 1000. * 1000. / BENCH_FRAME_RATE / options.pacing.batch_frames);
+
+        for (int sources = 1; sources <= options.max_sources; sources *= 2)
+        {
+            std::vector<std::shared_ptr<DataSource>> data_sources;
+            std::vector<std::unique_ptr<DataSourceController>> controllers;
+
+            for (int s = 0; s < sources; ++s)
+            {
+                recorder_config rec_config;
+                rec_config.record_prefix = filePath(options, "e2e_" + std::to_string(s) + "_");
+                rec_config.codec         = options.codec;
+                rec_config.format        = options.format;
+
+                // кожне джерело - свій шум, збої - однакові від запуску до запуску
+                emulator_config emu_config;
+                emu_config.signal = options.signal;
+                emu_config.seed   = static_cast<std::uint64_t>(s) + 1;
+
+                data_sources.push_back(std::make_shared<DataSourceFileEmulator>(
+                    PAYLOAD_TYPE::PAYLOAD_TYPE_8_BIT_UINT, frame_size, emu_config));
+                controllers.emplace_back(
+                    new DataSourceController(
+                        data_sources.back(),
+                        frame_size,
+                        options.queue,
+                        rec_config,
+                        options.pacing));
+            }
+
+            Timer total;
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(options.duration_ms));
+
+            const std::int64_t elapsed_ns = total.elapsedNs();
+
+            std::uint64_t frames   = 0;
+            std::uint64_t overruns = 0;
+            std::uint64_t drops    = 0;
+            std::uint64_t memory   = 0;
+            std::size_t max_depth  = 0;
+            std::uint64_t bad      = 0;
+            std::uint64_t loss     = 0;
+
+            // Затримки всіх джерел: беремо найгірше джерело по p99
+            latency_snapshot worst[static_cast<int>(LATENCY_STAGE::LATENCY_STAGE_SIZE)];
+
+            for (const auto & controller : controllers)
+            {
+                frames += controller->latency(LATENCY_STAGE::LATENCY_STAGE_CONVERT).count;
+                overruns += controller->getOverruns();
+                drops += controller->getPolicyDrops();
+                memory += controller->memoryUsage();
+                max_depth = std::max(max_depth, controller->queueDepth());
+                bad += controller->getBadFrames();
+                loss += controller->getPacketsLoss();
+
+                for (int st = 0; st < static_cast<int>(LATENCY_STAGE::LATENCY_STAGE_SIZE); ++st)
+                {
+                    const latency_snapshot lat = controller->latency(static_cast<LATENCY_STAGE>(st));
+
+                    if (lat.p99_ns >= worst[st].p99_ns)
+                        worst[st] = lat;
+                }
+            }
+
+            controllers.clear();
+            data_sources.clear();
+
+            bench_result result;
+            result.name = "end_to_end";
+            result.params.emplace_back("target_mb_per_sec", jsonNumber(rate_mb));
+            result.params.emplace_back("sources", std::to_string(sources));
+            result.params.emplace_back("queue_policy", jsonString(queuePolicyName(options.queue.policy)));
+            result.params.emplace_back("auto_tune", options.queue.auto_tune ? "true" : "false");
+            result.params.emplace_back(
+                "workers",
+                std::to_string(
+                    options.queue.worker_pool ? options.queue.worker_pool->threads()
+                                              : DataSourceWorkerPool::shared()->threads()));
+            result.params.emplace_back("frame_bytes", std::to_string(frame_size));
+            result.params.emplace_back("batch_frames", std::to_string(options.pacing.batch_frames));
+            result.params.emplace_back("codec", jsonString(recordCodecName(options.codec)));
+            result.params.emplace_back("signal", jsonString(emulatorSignalName(options.signal)));
+            result.params.emplace_back("format", jsonString(recordFormatName(options.format)));
+            addThroughput(result, frames, frame_size, elapsed_ns);
+            result.metrics.emplace_back("target_bytes_per_sec", rate_mb * 1000. * 1000. * sources);
+            result.metrics.emplace_back("overruns", static_cast<double>(overruns));
+            result.metrics.emplace_back("policy_drops", static_cast<double>(drops));
+            result.metrics.emplace_back("queue_depth", static_cast<double>(max_depth));
+            result.metrics.emplace_back("memory_bytes", static_cast<double>(memory));
+            result.metrics.emplace_back("bad_frames", static_cast<double>(bad));
+            result.metrics.emplace_back("packets_loss", static_cast<double>(loss));
+
+            for (int st = 0; st < static_cast<int>(LATENCY_STAGE::LATENCY_STAGE_SIZE); ++st)
+            {
+                std::string key = latencyStageName(static_cast<LATENCY_STAGE>(st));
+
+                for (char & c : key)
+                    if (c == ' ' || c == '/')
+                        c = '_';
+
+                result.metrics.emplace_back(key + "_p50_ns", static_cast<double>(worst[st].p50_ns));
+                result.metrics.emplace_back(key + "_p99_ns", static_cast<double>(worst[st].p99_ns));
+                result.metrics.emplace_back(key + "_p999_ns", static_cast<double>(worst[st].p999_ns));
+                result.metrics.emplace_back(key + "_max_ns", static_cast<double>(worst[st].max_ns));
+            }
+
+            results.push_back(result);
+
+            cleanupFiles(options);
+
+            std::cerr << "end_to_end " << rate_mb << " MB/s x " << sources << ": " << frames << " frames" << std::endl;
+        }
+    }
+}
+
+/// \brief Відтворення запису через контролер: обробка і запис реальних даних без емулятора
+void benchReplay(const bench_options & options, std::vector<bench_result> & results)
+{
+    std::vector<std::string> files = DataSourceReplay::captureSegments(options.replay);
+
+    if (files.empty())
+        files.push_back(options.replay);
+
+    replay_config config;
+    config.speed = options.replay_speed;
+
+    auto replay = std::make_shared<DataSourceReplay>(files, config);
+
+    if (!replay->frameSize())
+    {
+        std::cerr << "replay: nothing to read in " << options.replay << std::endl;
+        return;
+    }
+
+    recorder_config rec_config;
+    rec_config.record_prefix = filePath(options, "replay_");
+    rec_config.codec         = options.codec;
+    rec_config.format        = options.format;
+
+    std::unique_ptr<DataSourceController> controller(new DataSourceController(
+        replay, replay->frameSize(), options.queue, rec_config, DataSourceReplay::pacing(options.pacing)));
+
+    Timer total;
+
+    // до кінця запису і поки обробка не наздожене читання
+    std::uint64_t processed = 0;
+
+    while (total.elapsed() < options.duration_ms * 100.)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        const std::uint64_t count = controller->latency(LATENCY_STAGE::LATENCY_STAGE_CONVERT).count;
+
+        if (replay->isFinished() && count == processed)
+            break;
+
+        processed = count;
+    }
+
+    const std::int64_t elapsed_ns = total.elapsedNs();
+
+    const latency_snapshot convert = controller->latency(LATENCY_STAGE::LATENCY_STAGE_CONVERT);
+    const std::uint64_t drops      = controller->getPolicyDrops();
+    const std::uint64_t bad        = controller->getBadFrames();
+    const std::uint64_t loss       = controller->getPacketsLoss();
+
+    controller.reset();
+
+    bench_result result;
+    result.name = "replay";
+    result.params.emplace_back("record", jsonString(options.replay));
+    result.params.emplace_back("files", std::to_string(files.size()));
+    result.params.emplace_back("speed", jsonNumber(options.replay_speed));
+    result.params.emplace_back("queue_policy", jsonString(queuePolicyName(options.queue.policy)));
+    result.params.emplace_back("frame_bytes", std::to_string(replay->frameSize()));
+    result.params.emplace_back("codec", jsonString(recordCodecName(options.codec)));
+    result.params.emplace_back("format", jsonString(recordFormatName(options.format)));
+    addThroughput(result, convert.count, replay->frameSize(), elapsed_ns);
+    result.metrics.emplace_back("frames_replayed", static_cast<double>(replay->framesReplayed()));
+    result.metrics.emplace_back("bytes_replayed", static_cast<double>(replay->bytesReplayed()));
+    result.metrics.emplace_back("policy_drops", static_cast<double>(drops));
+    result.metrics.emplace_back("bad_frames", static_cast<double>(bad));
+    result.metrics.emplace_back("packets_loss", static_cast<double>(loss));
+    result.has_latency = true;
+    result.latency     = convert;
+
+    results.push_back(result);
+
+    cleanupFiles(options);
+
+    std::cerr << "replay: " << replay->framesReplayed() << " frames read, " << convert.count << " processed"
+              << std::endl;
+}
+
+bool parseOptions(int argc, char ** argv, bench_options & options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const bool has_value  = i + 1 < argc;
+
+        if (arg == "--out" && has_value)
+            options.out_file = argv[++i];
+        else if (arg == "--work-dir" && has_value)
+            options.work_dir = argv[++i];
+        else if (arg == "--duration-ms" && has_value)
+            options.duration_ms = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--iterations" && has_value)
+            options.iterations = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--max-sources" && has_value)
+            options.max_sources = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--disk-mb" && has_value)
+            options.disk_mb = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--no-e2e")
+            options.end_to_end = false;
+        else if (arg == "--depth" && has_value)
+            options.queue.depth = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--auto-tune")
+            options.queue.auto_tune = true;
+        else if (arg == "--budget-mb" && has_value)
+            options.queue.memory_budget = static_cast<std::uint64_t>(std::max(0, std::atoi(argv[++i]))) * 1024 * 1024;
+        else if (arg == "--workers" && has_value)
+            options.queue.worker_pool = std::make_shared<DataSourceWorkerPool>(std::max(0, std::atoi(argv[++i])));
+        else if (arg == "--batch-frames" && has_value)
+            options.pacing.batch_frames = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--codec" && has_value)
+            options.codec = std::string(argv[++i]) == "shuffle-lz" ? RECORD_CODEC::RECORD_CODEC_SHUFFLE_LZ
+                                                                   : RECORD_CODEC::RECORD_CODEC_NONE;
+        else if (arg == "--format" && has_value)
+        {
+            const std::string format = argv[++i];
+
+            if (format == "f16")
+                options.format = RECORD_FORMAT::RECORD_FORMAT_FLOAT16;
+            else if (format == "bf16")
+                options.format = RECORD_FORMAT::RECORD_FORMAT_BFLOAT16;
+            else if (format == "i16")
+                options.format = RECORD_FORMAT::RECORD_FORMAT_INT16;
+            else
+                options.format = RECORD_FORMAT::RECORD_FORMAT_FLOAT32;
+        }
+        else if (arg == "--replay" && has_value)
+            options.replay = argv[++i];
+        else if (arg == "--replay-speed" && has_value)
+            options.replay_speed = std::max(0., std::atof(argv[++i]));
+        else if (arg == "--signal" && has_value)
+        {
+            const std::string signal = argv[++i];
+
+            if (signal == "sine")
+                options.signal = EMULATOR_SIGNAL::EMULATOR_SIGNAL_SINE;
+            else if (signal == "chirp")
+                options.signal = EMULATOR_SIGNAL::EMULATOR_SIGNAL_CHIRP;
+            else if (signal == "noise")
+                options.signal = EMULATOR_SIGNAL::EMULATOR_SIGNAL_NOISE;
+            else
+                options.signal = EMULATOR_SIGNAL::EMULATOR_SIGNAL_CONSTANT;
+        }
+        else if (arg == "--policy" && has_value)
+        {
+            const std::string policy = argv[++i];
+
+            if (policy == "block")
+                options.queue.policy = QUEUE_POLICY::QUEUE_POLICY_BLOCK;
+            else if (policy == "drop-oldest")
+                options.queue.policy = QUEUE_POLICY::QUEUE_POLICY_DROP_OLDEST;
+            else if (policy == "spill")
+                options.queue.policy = QUEUE_POLICY::QUEUE_POLICY_SPILL;
+            else
+                options.queue.policy = QUEUE_POLICY::QUEUE_POLICY_DROP_NEWEST;
+        }
+        else if (arg == "--rates" && has_value)
+        {
+            options.rates.clear();
+
+            std::stringstream ss(argv[++i]);
+            std::string item;
+
+            while (std::getline(ss, item, ','))
+            {
+                const double rate = std::atof(item.c_str());
+
+                if (rate > 0.)
+                    options.rates.push_back(rate);
+            }
+        }
+        else
+        {
+            std::cerr << "usage: " << argv[0]
+                      << " [--out file] [--work-dir dir] [--duration-ms N] [--iterations N] [--max-sources N]"
+                         " [--rates MB,MB,...] [--disk-mb N] [--no-e2e]"
+                         " [--policy block|drop-newest|drop-oldest|spill] [--depth N] [--auto-tune] [--budget-mb N]"
+                         " [--workers N] [--batch-frames N] [--codec none|shuffle-lz] [--format f32|f16|bf16|i16]"
+                         " [--replay record_name|file] [--replay-speed X] [--signal const|sine|chirp|noise]"
+                      << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    bench_options options;
+
+    if (!parseOptions(argc, argv, options))
+        return -1;
+
+#ifndef WIN32
+    mkdir(options.work_dir.c_str(), 0755);
+#endif
+
+    std::vector<bench_result> results;
+
+    try
+    {
+        std::cerr << "convert_to_float" << std::endl;
+        benchConvert(options, results);
+
+        std::cerr << "emulator_acquire / emulator_read" << std::endl;
+        benchEmulator(options, results);
+
+        std::cerr << "convert_to_record" << std::endl;
+        benchRecordFormat(options, results);
+
+        std::cerr << "validate_frame / put_new_frame" << std::endl;
+        benchProcessor(options, results);
+
+        std::cerr << "recorder_put_new_frame" << std::endl;
+        benchRecorder(options, results);
+
+        std::cerr << "shared_ring_publish" << std::endl;
+        benchSharedRing(options, results);
+
+        std::cerr << "consumer_fanout" << std::endl;
+        benchConsumerFanout(options, results);
+
+        std::cerr << "disk_write" << std::endl;
+        benchDisk(options, results);
+
+        if (options.end_to_end)
+            benchEndToEnd(options, results);
+
+        if (!options.replay.empty())
+        {
+            std::cerr << "replay" << std::endl;
+            benchReplay(options, results);
+        }
+    }
+    catch (const std::exception & ex)
+    {
+        std::cerr << "An exception occured: " << ex.what() << std::endl;
+        cleanupFiles(options);
+        return -1;
+    }
+
+    if (options.out_file.empty())
+    {
+        writeJson(std::cout, options, results);
+    }
+    else
+    {
+        std::ofstream out(options.out_file);
+        writeJson(out, options, results);
+    }
+
+    return 0;
+}
@@ -1,11 +1,17 @@
+#include "DataSourceConsumer.h"
 #include "DataSourceController.h"
 #include "DataSourceEmulator.h"
+#include "DataSourceMetricsExporter.h"
 
 #include <signal.h>
 
+#include <atomic>
+#include <cmath>
+
 #include <iostream>
 #include <sstream>
 #include <ostream>
+#include <string>
 
 // 10 МБ/с = 1250000 байт/с - мінімальна пропускна здатність
 // 100 МБ/с = 12500000 байт/с - максимальна пропускна здатність
@@ -27,6 +33,27 @@ static constexpr int MAX_FRAME_SIZE {static_cast<int>((12500000) / DATA_SOURCE_T
 
 bool g_main_loop {true};
 
+// Етап ЦОС поза потоком обробки: СКЗ відліків останнього кадру
+class RmsConsumer final : public DATA_SOURCE_TASK::DataSourceConsumer
+{
+public:
+    void consume(const DATA_SOURCE_TASK::frame_view & view) override
+    {
+        const float * samples = view.samples();
+        double sum            = 0.;
+
+        for (int i = 0; i < view.elements; ++i)
+            sum += static_cast<double>(samples[i]) * samples[i];
+
+        m_rms = view.elements ? std::sqrt(sum / view.elements) : 0.;
+    }
+
+    inline double rms() const { return m_rms; }
+
+private:
+    std::atomic<double> m_rms {0.};
+};
+
 void exit_handler(int s)
 {
     std::cout << "Signal caught - " << s << std::endl;
@@ -35,8 +62,22 @@ void exit_handler(int s)
 
 int main(int argc, char ** argv)
 {
-    static_cast<void>(argc);
-    static_cast<void>(argv);
+    // --metrics-file <шлях> / --metrics-socket <шлях>: експорт метрик в форматі Prometheus
+    DATA_SOURCE_TASK::exporter_config export_config;
+    // --shm-prefix <префікс>: перетворені кадри в спільній пам'яті /<префікс><ІД джерела>
+    DATA_SOURCE_TASK::shared_ring_config shared_ring;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const std::string arg = argv[i];
+
+        if (arg == "--metrics-file")
+            export_config.file_path = argv[i + 1];
+        else if (arg == "--metrics-socket")
+            export_config.socket_path = argv[i + 1];
+        else if (arg == "--shm-prefix")
+            shared_ring.name_prefix = argv[i + 1];
+    }
 
     signal(SIGINT, &exit_handler);
 
@@ -50,7 +91,28 @@ int main(int argc, char ** argv)
 
         // Клас контролер для різних типів даних з різних джерел.
         std::unique_ptr<DATA_SOURCE_TASK::DataSourceController> data_source_processor
-            = std::make_unique<DATA_SOURCE_TASK::DataSourceController>(data_source, MAX_FRAME_SIZE);
+            = std::make_unique<DATA_SOURCE_TASK::DataSourceController>(data_source,
+                                                                       MAX_FRAME_SIZE,
+                                                                       DATA_SOURCE_TASK::queue_config(),
+                                                                       DATA_SOURCE_TASK::recorder_config(),
+                                                                       DATA_SOURCE_TASK::pacer_config(),
+                                                                       shared_ring);
+
+        // споживач отримує ті ж кадри float, що й реєстратор, без копіювання
+        const auto rms = std::make_shared<RmsConsumer>();
+
+        DATA_SOURCE_TASK::consumer_config rms_config;
+        rms_config.name = "rms";
+
+        data_source_processor->addConsumer(rms, rms_config);
+
+        std::unique_ptr<DATA_SOURCE_TASK::DataSourceMetricsExporter> exporter;
+
+        if (!export_config.file_path.empty() || !export_config.socket_path.empty())
+        {
+            exporter = std::make_unique<DATA_SOURCE_TASK::DataSourceMetricsExporter>(export_config);
+            exporter->add("emulator", &data_source_processor->metrics());
+        }
 
         // Таймер оновлення виводу в консоль
         DATA_SOURCE_TASK::Timer display_update_timer;
@@ -63,10 +125,18 @@ int main(int argc, char ** argv)
             // Читимо консоль перед новим виводом даних
             system(CLEAR_CONSOLE);
 
-            // грубий лічильник оброблених кадрів
-            static int prev_counter = -1;
+            // узгоджений знімок лічильників: всі значення з однієї публікації потоку обробки
+            using DATA_SOURCE_TASK::METRIC_COUNTER;
+            using DATA_SOURCE_TASK::METRIC_GAUGE;
+
+            static DATA_SOURCE_TASK::metrics_snapshot prev_metrics;
+
+            const DATA_SOURCE_TASK::metrics_snapshot metrics = data_source_processor->metricsSnapshot();
 
-            int diff_frames = data_source_processor->framesTotal() - (prev_counter == -1 ? 0 : prev_counter);
+            const std::uint64_t diff_frames = metrics.counter(METRIC_COUNTER::METRIC_COUNTER_FRAMES)
+                - prev_metrics.counter(METRIC_COUNTER::METRIC_COUNTER_FRAMES);
+            const std::uint64_t diff_bytes = metrics.counter(METRIC_COUNTER::METRIC_COUNTER_BYTES)
+                - prev_metrics.counter(METRIC_COUNTER::METRIC_COUNTER_BYTES);
 
             static std::stringstream ss;
             ss.clear();
@@ -78,6 +148,13 @@ int main(int argc, char ** argv)
             ss << "Elapsed time for frame read: " << data_source_processor->elapsed() << " ms\n";
             ss << "-----------------------------------------------\n";
 
+            const DATA_SOURCE_TASK::pacer_stats pacing = data_source_processor->pacerStats();
+            ss << "Read period overruns: " << pacing.overruns << "\n";
+            ss << "-----------------------------------------------\n";
+            ss << "Read wake-up jitter (mean / max): " << pacing.mean_jitter_ns / 1000. << " / "
+               << pacing.max_jitter_ns / 1000. << " us\n";
+            ss << "-----------------------------------------------\n";
+
             // Заголовок, к-сть обробленних кадрів, к-сть втрачених і відсоток втрачених кадрів за ~1сек
             ss << "Frame head: " << std::hex << data_source_processor->header() << std::dec << "\n";
             ss << "-----------------------------------------------\n";
@@ -85,29 +162,65 @@ int main(int argc, char ** argv)
             ss << "-----------------------------------------------\n";
             ss << "Processed frames: " << diff_frames << "\n";
             ss << "-----------------------------------------------\n";
-            ss << "Bad frames: " << data_source_processor->getBadFrames() << "\n";
+            ss << "Bad frames: " << metrics.counter(METRIC_COUNTER::METRIC_COUNTER_BAD_FRAMES) << "\n";
+            ss << "-----------------------------------------------\n";
+            ss << "Frames loss: " << metrics.counter(METRIC_COUNTER::METRIC_COUNTER_PACKETS_LOSS) << "\n";
+            ss << "-----------------------------------------------\n";
+            ss << "Broken stream frames: " << metrics.counter(METRIC_COUNTER::METRIC_COUNTER_BROKEN_FRAMES) << "\n";
+            ss << "-----------------------------------------------\n";
+            ss << "Queue occupancy: " << metrics.gauge(METRIC_GAUGE::METRIC_GAUGE_QUEUE_OCCUPANCY) << " / "
+               << metrics.gauge(METRIC_GAUGE::METRIC_GAUGE_QUEUE_DEPTH) << "\n";
             ss << "-----------------------------------------------\n";
-            ss << "Frames loss: " << data_source_processor->getPacketsLoss() << "\n";
+            ss << "Buffers memory: " << metrics.gauge(METRIC_GAUGE::METRIC_GAUGE_MEMORY_BYTES) / (1024. * 1024.)
+               << " MiB\n";
             ss << "-----------------------------------------------\n";
-            ss << "Broken stream frames: " << data_source_processor->getBrokenFrames() << "\n";
+            ss << "Queue overruns: " << metrics.counter(METRIC_COUNTER::METRIC_COUNTER_OVERRUNS)
+               << " (dropped newest: " << metrics.counter(METRIC_COUNTER::METRIC_COUNTER_DROPPED_NEWEST)
+               << ", dropped oldest: " << metrics.counter(METRIC_COUNTER::METRIC_COUNTER_DROPPED_OLDEST)
+               << ", spilled: " << metrics.counter(METRIC_COUNTER::METRIC_COUNTER_SPILLED) << ")\n";
             ss << "-----------------------------------------------\n";
-            ss << "Percentage loss: "
-               << (100. * data_source_processor->getPacketsLoss()) / data_source_processor->framesTotal() << " %\n";
+            const std::uint64_t loss = metrics.counter(METRIC_COUNTER::METRIC_COUNTER_PACKETS_LOSS);
+            const std::uint64_t frames = metrics.counter(METRIC_COUNTER::METRIC_COUNTER_FRAMES);
+            ss << "Percentage loss: " << (frames + loss ? (100. * loss) / (frames + loss) : 0.) << " %\n";
             ss << "-----------------------------------------------\n";
 
-            // Груба частота кадрів, Мб/сек
+            // Частота кадрів за ~1сек, Мб/сек
             constexpr float byte_sec_2_bit_sec_conv {8. / (1000. * 1000.)};
-            ss << "Download speed: " << (diff_frames * MAX_FRAME_SIZE) * byte_sec_2_bit_sec_conv << " Mb/sec\n";
+            ss << "Download speed: " << diff_bytes * byte_sec_2_bit_sec_conv << " Mb/sec\n";
             ss << "-----------------------------------------------\n";
 
             // Час перетворення на float
-            ss << "Elapsed time for frame validation: " << data_source_processor->validationElapsed() << " ms\n";
+            ss << "Elapsed time for frame validation: "
+               << metrics.gauge(METRIC_GAUGE::METRIC_GAUGE_PROCESS_NS) / 1000000. << " ms\n";
             ss << "-----------------------------------------------\n";
             // Час запису в файл
             ss << "Elapsed time for frame record: " << data_source_processor->saveFrameElapsed() << " ms\n";
             ss << "-----------------------------------------------\n";
 
-            prev_counter = data_source_processor->framesTotal();
+            // Розподіл затримок по етапах, мкс
+            ss << "Latency, us (p50 / p99 / p99.9 / max):\n";
+            for (int i = 0; i < static_cast<int>(DATA_SOURCE_TASK::LATENCY_STAGE::LATENCY_STAGE_SIZE); ++i)
+            {
+                const auto stage = static_cast<DATA_SOURCE_TASK::LATENCY_STAGE>(i);
+                const DATA_SOURCE_TASK::latency_snapshot & lat = metrics.latency[i];
+
+                ss << "  " << DATA_SOURCE_TASK::latencyStageName(stage) << ": " << lat.p50_ns / 1000. << " / "
+                   << lat.p99_ns / 1000. << " / " << lat.p999_ns / 1000. << " / " << lat.max_ns / 1000. << "\n";
+            }
+            ss << "-----------------------------------------------\n";
+
+            // Споживачі: черга, втрати і затримки, мкс
+            ss << "Signal RMS: " << rms->rms() << "\n";
+            for (const DATA_SOURCE_TASK::consumer_stats & consumer : data_source_processor->consumerStats())
+            {
+                ss << "  consumer " << consumer.name << ": " << consumer.occupancy << " / " << consumer.depth
+                   << ", delivered " << consumer.delivered << ", dropped " << consumer.dropped << ", queue p99 "
+                   << consumer.queue_latency.p99_ns / 1000. << ", consume p99 "
+                   << consumer.consume_latency.p99_ns / 1000. << "\n";
+            }
+            ss << "-----------------------------------------------\n";
+
+            prev_metrics = metrics;
 
             std::cout << ss.rdbuf() << std::endl;
 
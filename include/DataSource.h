@@ -6,6 +6,21 @@
 namespace DATA_SOURCE_TASK
 {
 
+/// \brief Порція даних джерела між DataSource::acquire() і DataSource::commit()
+struct read_block
+{
+    const char * data = nullptr; // початок даних: буфер викликаючого або позичений буфер джерела
+    int size          = 0;       // к-сть байт або код DATA_SOURCE_ERROR
+    bool is_lent      = false;   // дані в буфері джерела, дійсні до commit()
+};
+
+/// \brief Буфер одного кадру пакетного читання DataSource::readBatch(), як iovec
+struct read_vector
+{
+    char * data = nullptr; // буфер викликаючого
+    int size    = 0;       // на вході - розмір буфера, на виході - к-сть записаних байт
+};
+
 /// \brief Абстрактний клас певного джерела даних
 class DataSource
 {
@@ -25,10 +40,33 @@ public:
     /// \return
     virtual int read(char * data, int size) = 0;
 
+    /// \brief Пакетне читання: до count кадрів за один виклик
+    /// (одне блокування, для реальних джерел - один системний виклик).
+    /// За замовчуванням - read() для кожного буфера.
+    /// \param frames - буфери кадрів, size кожного оновлюється к-стю записаних байт
+    /// \param count - к-сть буферів
+    /// \return к-сть заповнених буферів або код DATA_SOURCE_ERROR, якщо не заповнено жодного
+    virtual int readBatch(read_vector * frames, int count);
+
+    /// \brief Наступна порція даних без зайвого копіювання.
+    /// Джерело або пише прямо в buffer (кадр з пулу викликаючого), або позичає власний буфер (read_block::is_lent).
+    /// Кожен acquire() завершується commit(). За замовчуванням - read() в buffer.
+    /// \param buffer - буфер викликаючого
+    /// \param size - розмір буфера, більше байт джерело не видає
+    /// \return
+    virtual read_block acquire(char * buffer, int size);
+
+    /// \brief Завершуємо порцію, отриману acquire().
+    /// \param block - результат acquire()
+    /// \param consumed - к-сть байт, які забрав викликаючий. Решта позиченого блоку видається наступним acquire().
+    virtual void commit(const read_block & block, int consumed);
+
+    /// \brief Час останнього читання
+    /// \return мілісекунди
     inline double readElapsed() { return m_elapsed; }
 
 protected:
-    std::atomic<int> m_elapsed;
+    std::atomic<double> m_elapsed;
 };
 
 } // namespace DATA_SOURCE_TASK
@@ -0,0 +1,69 @@
+#ifndef DATASOURCEALIGNEDALLOCATOR_H
+#define DATASOURCEALIGNEDALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace DATA_SOURCE_TASK
+{
+
+// Вирівнювання для запису з O_DIRECT (розмір сторінки / логічного блоку диска).
+static constexpr std::size_t DIRECT_IO_ALIGNMENT {4096};
+
+/// \brief Алокатор з вирівнюванням початку масиву на Alignment байт.
+/// Для std::vector, дані якого пишуться на диск напряму або читаються вирівняними SIMD інструкціями.
+template<typename T, std::size_t Alignment = DIRECT_IO_ALIGNMENT>
+class DataSourceAlignedAllocator
+{
+public:
+    using value_type = T;
+
+    template<typename U>
+    struct rebind
+    {
+        using other = DataSourceAlignedAllocator<U, Alignment>;
+    };
+
+    DataSourceAlignedAllocator() noexcept = default;
+
+    template<typename U>
+    DataSourceAlignedAllocator(const DataSourceAlignedAllocator<U, Alignment> &) noexcept
+    {
+    }
+
+    T * allocate(std::size_t n)
+    {
+        // Перед вирівняним блоком зберігаємо адресу, отриману від operator new
+        char * raw = static_cast<char *>(::operator new(n * sizeof(T) + Alignment + sizeof(void *)));
+
+        std::uintptr_t aligned = reinterpret_cast<std::uintptr_t>(raw + sizeof(void *));
+        aligned                = (aligned + Alignment - 1) & ~(static_cast<std::uintptr_t>(Alignment) - 1);
+
+        reinterpret_cast<void **>(aligned)[-1] = raw;
+
+        return reinterpret_cast<T *>(aligned);
+    }
+
+    void deallocate(T * p, std::size_t) noexcept
+    {
+        if (p)
+            ::operator delete(reinterpret_cast<void **>(p)[-1]);
+    }
+};
+
+template<typename T, typename U, std::size_t Alignment>
+bool operator==(const DataSourceAlignedAllocator<T, Alignment> &, const DataSourceAlignedAllocator<U, Alignment> &)
+{
+    return true;
+}
+
+template<typename T, typename U, std::size_t Alignment>
+bool operator!=(const DataSourceAlignedAllocator<T, Alignment> &, const DataSourceAlignedAllocator<U, Alignment> &)
+{
+    return false;
+}
+
+} // namespace DATA_SOURCE_TASK
+
+#endif // DATASOURCEALIGNEDALLOCATOR_H
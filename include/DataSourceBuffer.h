@@ -19,8 +19,7 @@ public:
         buffer.clear();
         buffer.swap(other.buffer);
 
-        m_frame   = reinterpret_cast<struct frame *>(buffer.data());
-        m_payload = reinterpret_cast<char *>(buffer.data() + FRAME_HEADER_SIZE);
+        attach(buffer.data());
 
         return *this;
     }
@@ -30,8 +29,7 @@ public:
         buffer.clear();
         buffer.swap(other.buffer);
 
-        m_frame   = reinterpret_cast<struct frame *>(buffer.data());
-        m_payload = reinterpret_cast<char *>(buffer.data() + FRAME_HEADER_SIZE);
+        attach(buffer.data());
     }
 
     DataSourceBufferInterface(DataSourceBufferInterface && other) noexcept
@@ -39,8 +37,7 @@ public:
         buffer.clear();
         buffer.swap(other.buffer);
 
-        m_frame   = reinterpret_cast<struct frame *>(buffer.data());
-        m_payload = reinterpret_cast<char *>(buffer.data() + FRAME_HEADER_SIZE);
+        attach(buffer.data());
     }
 
     virtual ~DataSourceBufferInterface() = default;
@@ -144,19 +141,29 @@ public:
 
     /// \brief Вказівник на дані кадру
     /// \return
-    inline char * data() { return buffer.data(); }
+    inline char * data() { return m_data; }
 
     /// \brief К-сть відліків сигналу
     /// \return
     std::uint32_t totalElements() const { return m_elements_num; };
 
 protected:
-    std::vector<char> buffer;         // весь масив даних
+    /// \brief Прив'язуємо вказівники заголовку і відліків до пам'яті кадру
+    /// \param data - початок кадру
+    void attach(char * data)
+    {
+        m_data    = data;
+        m_frame   = reinterpret_cast<struct frame *>(data);
+        m_payload = data ? data + FRAME_HEADER_SIZE : nullptr;
+    }
+
+    std::vector<char> buffer;         // весь масив даних, якщо кадр володіє пам'яттю
     std::uint32_t m_frame_size   = 0; // розмір всього блоку даних
     std::uint32_t m_elements_num = 0; // к-сть відліків сигналу
     std::uint8_t m_type_size     = 0; // sizeof(uint8_t), sizeof(uint16_t) ...
-    struct frame * m_frame;           // вказівник на заголовок
-    char * m_payload;                 // вказівник на дані оцифрованих відліків
+    char * m_data          = nullptr; // вказівник на початок кадру
+    struct frame * m_frame = nullptr; // вказівник на заголовок
+    char * m_payload       = nullptr; // вказівник на дані оцифрованих відліків
 };
 
 // Простий алокатор
@@ -172,9 +179,8 @@ public:
         m_elements_num = (m_frame_size - FRAME_HEADER_SIZE) / m_type_size;
         buffer.resize(m_frame_size);
 
-        m_frame   = reinterpret_cast<struct frame *>(buffer.data());
+        attach(buffer.data());
         m_frame->payload_size = (m_frame_size - FRAME_HEADER_SIZE);
-        m_payload = reinterpret_cast<char *>(buffer.data() + FRAME_HEADER_SIZE);
     }
 
     virtual ~DataSourceBuffer() {}
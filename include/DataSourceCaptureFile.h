@@ -0,0 +1,215 @@
+#ifndef DATASOURCECAPTUREFILE_H
+#define DATASOURCECAPTUREFILE_H
+
+#include "DataSourceAlignedAllocator.h"
+#include "DataSourceCodec.h"
+#include "DataSourceSegmentWriter.h"
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace DATA_SOURCE_TASK
+{
+
+// Ідентифікатори файлу запису і його індексу ("DSCF", "DSIX")
+static constexpr std::uint32_t CAPTURE_FILE_MAGIC {0x46435344};
+static constexpr std::uint32_t CAPTURE_INDEX_MAGIC {0x58495344};
+static constexpr std::uint16_t CAPTURE_FILE_VERSION {2}; // 2 - block_header::frame_offset
+
+// Зміщення першого блоку від початку файлу (заголовок займає окрему сторінку, вирівняну для O_DIRECT).
+static constexpr std::uint64_t CAPTURE_DATA_OFFSET {DIRECT_IO_ALIGNMENT};
+
+/// \brief Заголовок файлу запису. Лежить на початку кожного сегменту, займає CAPTURE_DATA_OFFSET байт.
+struct capture_file_header
+{
+    std::uint32_t magic          = CAPTURE_FILE_MAGIC;
+    std::uint16_t version        = CAPTURE_FILE_VERSION;
+    std::uint16_t header_size    = sizeof(capture_file_header);
+    std::uint64_t data_offset    = CAPTURE_DATA_OFFSET; // зміщення першого блоку
+    std::uint64_t created_ns     = 0;                   // час створення сегменту (system_clock), нс
+    std::uint32_t segment_index  = 0;                   // номер сегменту
+    std::uint32_t frame_elements = 0;                   // к-сть відліків в кадрі
+    std::uint16_t source_id      = 0;                   // ІД джерела
+    std::uint8_t payload_type    = 0;                   // PAYLOAD_TYPE джерела
+    std::uint8_t format          = 0;                   // RECORD_FORMAT відліків
+    std::uint8_t codec           = 0;                   // RECORD_CODEC з налаштувань
+    std::uint8_t reserved[27]    = {};
+};
+
+/// \brief Запис індексу: де лежить блок і які кадри в ньому
+struct capture_index_entry
+{
+    std::uint64_t offset       = 0; // зміщення блоку від початку файлу
+    std::uint32_t block_size   = 0; // розмір блоку з заголовком, байт
+    std::uint32_t sample_count = 0; // к-сть відліків
+    std::uint64_t first_frame  = 0; // лічильник першого кадру без переповнення
+    std::uint64_t last_frame   = 0; // лічильник останнього кадру без переповнення
+    std::uint64_t first_ns     = 0; // час надходження першого кадру, нс
+    std::uint64_t last_ns      = 0; // час надходження останнього кадру, нс
+};
+
+/// \brief Кінець сегменту: останні байти файлу. Індекс - entry_count записів з index_offset.
+struct capture_file_footer
+{
+    std::uint32_t magic        = CAPTURE_INDEX_MAGIC;
+    std::uint32_t entry_count  = 0; // к-сть записів індексу
+    std::uint64_t index_offset = 0; // зміщення індексу, він же кінець останнього блоку
+    std::uint64_t reserved[2]  = {0, 0};
+};
+
+static_assert(sizeof(capture_file_header) == 64, "capture file header layout must be stable on disk");
+static_assert(sizeof(capture_index_entry) == 48, "capture index entry layout must be stable on disk");
+static_assert(sizeof(capture_file_footer) == 32, "capture file footer layout must be stable on disk");
+
+/// \brief Ім'я файлу індексу, який пишеться поруч із сегментом під час запису: <name>.bin -> <name>.idx
+/// \param file_name - ім'я сегменту
+/// \return
+std::string captureIndexName(const std::string & file_name);
+
+/// \brief Запис закодованих блоків у файли-контейнери поверх DataSourceSegmentWriter.
+/// Кожен сегмент починається заголовком capture_file_header, далі блоки (block_header + дані), при закритті
+/// сегменту дописується індекс блоків і capture_file_footer в останніх байтах файлу.
+/// Поки сегмент відкритий, записи індексу після кожного блоку дописуються ще й у captureIndexName(),
+/// тож незавершений після аварії сегмент читається без сканування. Після запису футера цей файл видаляється.
+/// Всі записи вирівняні на DIRECT_IO_ALIGNMENT, O_DIRECT зберігається.
+/// Не потокобезпечний, використовується з одного потоку запису.
+class DataSourceCaptureWriter
+{
+public:
+    /// \brief Конструктор. Файл відкривається при першому записі.
+    /// \param base_name - базове ім'я файлів сегментів
+    /// \param segment_size - максимальний розмір сегменту, байт
+    /// \param segment_seconds - максимальний вік сегменту, с. 0 - без обмеження
+    /// \param frame_elements - к-сть відліків в кадрі, для заголовку файлу
+    /// \param codec - кодування з налаштувань, для заголовку файлу
+    /// \param segment_counter - спільний лічильник номерів сегментів, nullptr - власна нумерація з 0
+    DataSourceCaptureWriter(
+        const std::string & base_name,
+        const std::uint64_t & segment_size = DEFAULT_SEGMENT_SIZE,
+        const std::uint32_t & segment_seconds = 0,
+        const std::uint32_t & frame_elements = 0,
+        const RECORD_CODEC & codec = RECORD_CODEC::RECORD_CODEC_NONE,
+        const std::shared_ptr<std::atomic<std::uint32_t>> & segment_counter = nullptr);
+
+    DATA_SOURCE_NON_COPYABLE(DataSourceCaptureWriter)
+
+    ~DataSourceCaptureWriter();
+
+    /// \brief Дописуємо блок, за потреби закривши сегмент і відкривши наступний
+    /// \param block - блок з заголовком block_header (DataSourceBlockCodec::encoded())
+    /// \param size - розмір блоку, байт
+    /// \return false при помилці запису
+    bool write(const char * block, const std::size_t & size);
+
+    /// \brief Дописуємо індекс і футер, закриваємо сегмент. Наступний запис відкриє наступний сегмент.
+    void close();
+
+    /// \brief Ім'я поточного сегменту
+    /// \return
+    inline const std::string & segmentName() const { return m_writer.segmentName(); }
+
+    /// \brief Всього записано байт блоків, без заголовків файлів і індексів
+    /// \return
+    inline std::uint64_t bytesWritten() const { return m_bytes_written; }
+
+private:
+    /// \brief Відкриваємо сегмент: заголовок файлу з опису першого блоку і файл індексу
+    bool openSegment(const block_header & first);
+
+    std::uint32_t m_frame_elements = 0;
+    RECORD_CODEC m_codec           = RECORD_CODEC::RECORD_CODEC_NONE;
+    std::uint64_t m_bytes_written  = 0;
+
+    DataSourceSegmentWriter m_writer;
+
+    std::vector<capture_index_entry> m_index;                    // індекс поточного сегменту
+    std::vector<char, DataSourceAlignedAllocator<char>> m_page; // заголовок файлу або індекс з футером
+    std::string m_index_name;
+    std::FILE * m_index_file = nullptr;
+};
+
+/// \brief Читання файлу-контейнера (одного сегменту).
+/// Індекс береться з футера; якщо запис не завершено - з captureIndexName(), інакше блоки скануються
+/// за заголовками. Пошук блоків за кадром або часом - бінарний по індексу.
+/// readBlock() можна викликати з кількох потоків одночасно, тож великий запис читається паралельно.
+class DataSourceCaptureReader
+{
+public:
+    /// \brief Конструктор. Відкриває файл і завантажує індекс.
+    /// \param file_name - ім'я сегменту
+    explicit DataSourceCaptureReader(const std::string & file_name);
+
+    DATA_SOURCE_NON_COPYABLE(DataSourceCaptureReader)
+
+    ~DataSourceCaptureReader();
+
+    /// \brief Чи вдалось відкрити файл і прочитати заголовок
+    /// \return
+    bool isOpen() const;
+
+    /// \brief Чи індекс прочитано з футера (сегмент закрито штатно)
+    /// \return
+    inline bool isComplete() const { return m_is_complete; }
+
+    /// \brief Заголовок файлу
+    /// \return
+    inline const capture_file_header & header() const { return m_header; }
+
+    /// \brief К-сть блоків
+    /// \return
+    inline std::size_t blockCount() const { return m_index.size(); }
+
+    /// \brief Запис індексу блоку
+    /// \param index - номер блоку
+    /// \return
+    inline const capture_index_entry & entry(const std::size_t & index) const { return m_index[index]; }
+
+    /// \brief Перший блок, що містить кадр frame або пізніші
+    /// \param frame - лічильник кадру без переповнення
+    /// \return номер блоку, blockCount() - таких немає
+    std::size_t findFrame(const std::uint64_t & frame) const;
+
+    /// \brief Перший блок, що містить кадри, які надійшли не раніше time_ns
+    /// \param time_ns - час (system_clock), нс
+    /// \return номер блоку, blockCount() - таких немає
+    std::size_t findTime(const std::uint64_t & time_ns) const;
+
+    /// \brief Читаємо і декодуємо блок
+    /// \param index - номер блоку
+    /// \param samples - відліки float
+    /// \param header - заголовок блоку, якщо потрібен
+    /// \return false, якщо блок не прочитано або він пошкоджений
+    bool readBlock(const std::size_t & index, std::vector<float> & samples, block_header * header = nullptr) const;
+
+private:
+    /// \brief Читаємо size байт з offset
+    bool readAt(const std::uint64_t & offset, char * data, const std::size_t & size) const;
+
+    /// \brief Індекс з футера
+    bool loadFooter(const std::uint64_t & file_size);
+
+    /// \brief Індекс з файлу, що писався під час запису
+    bool loadIndexFile(const std::uint64_t & file_size);
+
+    /// \brief Індекс за заголовками блоків
+    void scanBlocks(const std::uint64_t & file_size);
+
+    std::string m_file_name;
+    capture_file_header m_header;
+    std::vector<capture_index_entry> m_index;
+    bool m_is_header   = false;
+    bool m_is_complete = false;
+
+#ifdef WIN32
+    std::FILE * m_file = nullptr;
+    mutable std::mutex m_file_lock;
+#else
+    int m_fd = -1;
+#endif
+};
+
+} // namespace DATA_SOURCE_TASK
+
+#endif // DATASOURCECAPTUREFILE_H
@@ -0,0 +1,113 @@
+#ifndef DATASOURCECODEC_H
+#define DATASOURCECODEC_H
+
+#include "DataSourceAlignedAllocator.h"
+#include "DataSourceConvert.h"
+#include "globals.h"
+
+#include <vector>
+
+namespace DATA_SOURCE_TASK
+{
+
+// Ідентифікатор початку закодованого блоку в файлі запису, "DSBK"
+static constexpr std::uint32_t BLOCK_MAGIC_WORD {0x4b425344};
+
+// Кодування блоків запису
+enum class RECORD_CODEC : std::uint8_t
+{
+    RECORD_CODEC_NONE = 0,   // без стиснення: реєстратор пише блоки як RECORD_CODEC_RAW
+    RECORD_CODEC_RAW,        // сирі відліки з заголовком блоку: кодування не дало виграшу
+    RECORD_CODEC_SHUFFLE_LZ, // XOR з попереднім відліком, перестановка байтів по площинах, LZ-стиснення
+};
+
+/// \brief Заголовок закодованого блоку. Блок займає block_size байт: заголовок, дані, вирівнювання нулями.
+/// Крім розмірів, описує відліки блоку: джерело, діапазон кадрів і час, щоб блоки можна було шукати без декодування.
+struct block_header
+{
+    std::uint32_t magic_word   = BLOCK_MAGIC_WORD;
+    std::uint8_t codec         = 0; // RECORD_CODEC
+    std::uint8_t element_size  = 0; // розмір відліку до кодування, байт
+    std::uint16_t header_size  = 0; // розмір заголовку, байт
+    std::uint32_t raw_size     = 0; // розмір даних до кодування, байт
+    std::uint32_t encoded_size = 0; // розмір закодованих даних після заголовку, байт
+    std::uint32_t block_size   = 0; // розмір блоку з заголовком і вирівнюванням, байт
+    std::uint8_t format        = 0; // RECORD_FORMAT відліків
+    std::uint8_t payload_type  = 0; // PAYLOAD_TYPE відліків джерела до перетворення
+    std::uint16_t source_id    = 0; // ІД джерела
+    float scale                = 1.f; // множник RECORD_FORMAT_INT16: відлік = значення / scale
+    std::uint32_t sample_count = 0;   // к-сть відліків в блоці
+    std::uint64_t first_frame  = 0;   // лічильник першого кадру блоку без переповнення (молодші 16 біт - frame_counter)
+    std::uint64_t last_frame   = 0;   // лічильник останнього кадру блоку
+    std::uint64_t first_ns     = 0;   // час надходження першого кадру (system_clock), нс
+    std::uint64_t last_ns      = 0;   // час надходження останнього кадру (system_clock), нс
+    std::uint32_t frame_offset = 0;   // відліки до початку першого нового кадру: хвіст first_frame з попереднього блоку
+    std::uint32_t reserved     = 0;
+};
+
+static_assert(sizeof(block_header) == 72, "block header layout must be stable on disk");
+
+/// \brief Назва кодування
+/// \param codec
+/// \return
+const char * recordCodecName(const RECORD_CODEC & codec);
+
+/// \brief Кодер блоків відліків без втрат.
+/// Відліки XOR-яться з попередніми (повільний сигнал дає нулі в старших байтах), байти переставляються
+/// по площинах (всі молодші, потім наступні), після чого LZ77 з хеш-таблицею шукає повтори в межах 64 КБ.
+/// Якщо стиснення не дає виграшу, блок пишеться як RECORD_CODEC_RAW.
+/// Буфери повторно використовуються між блоками. Не потокобезпечний.
+class DataSourceBlockCodec
+{
+public:
+    /// \brief Конструктор
+    /// \param codec - кодування
+    /// \param alignment - вирівнювання розміру блоку (O_DIRECT), 1 - без вирівнювання
+    explicit DataSourceBlockCodec(
+        const RECORD_CODEC & codec = RECORD_CODEC::RECORD_CODEC_SHUFFLE_LZ,
+        const std::size_t & alignment = DIRECT_IO_ALIGNMENT);
+
+    DATA_SOURCE_NON_COPYABLE(DataSourceBlockCodec)
+
+    /// \brief Кодуємо блок
+    /// \param data - відліки
+    /// \param size - розмір, байт
+    /// \param meta - опис відліків (element_size, формат, джерело, кадри, час), копіюється в заголовок.
+    /// Кодування і розміри заповнює кодер.
+    /// \return розмір блоку з заголовком і вирівнюванням, дані - encoded()
+    std::size_t encode(const char * data, const std::uint32_t & size, const block_header & meta);
+
+    /// \brief Результат останнього encode(), вирівняний на DIRECT_IO_ALIGNMENT
+    /// \return
+    inline const char * encoded() const { return m_block.data(); }
+
+    /// \brief Кодування
+    /// \return
+    inline RECORD_CODEC codec() const { return m_codec; }
+
+    /// \brief Розбір заголовку блоку
+    /// \param data - початок блоку
+    /// \param size - доступно байт
+    /// \param header - результат
+    /// \return false, якщо це не заголовок блоку або блок не вміщається в size
+    static bool readHeader(const char * data, const std::size_t & size, block_header & header);
+
+    /// \brief Декодуємо блок
+    /// \param data - початок блоку з заголовком
+    /// \param size - доступно байт
+    /// \param out - результат, raw_size байт
+    /// \return false, якщо блок пошкоджений
+    bool decode(const char * data, const std::size_t & size, std::vector<char> & out);
+
+private:
+    RECORD_CODEC m_codec;
+    std::size_t m_alignment;
+
+    std::vector<char> m_shuffled;                                 // XOR і перестановка байтів
+    std::vector<std::uint32_t> m_hash;                            // позиції 4-байтових послідовностей для LZ
+    std::vector<char, DataSourceAlignedAllocator<char>> m_block; // заголовок + закодовані дані
+};
+
+} // namespace DATA_SOURCE_TASK
+
+#endif // DATASOURCECODEC_H
@@ -0,0 +1,172 @@
+#ifndef DATASOURCECONSUMER_H
+#define DATASOURCECONSUMER_H
+
+#include "DataSourceEvent.h"
+#include "DataSourceFramePool.h"
+#include "DataSourceLatencyHistogram.h"
+#include "DataSourceRing.h"
+#include "globals.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace DATA_SOURCE_TASK
+{
+
+// Глибина черги споживача за замовчуванням, кадрів
+static constexpr std::size_t DEFAULT_CONSUMER_DEPTH {16};
+
+// Межа кадрів float, які можуть тримати черги всіх споживачів процесора
+static constexpr std::size_t MAX_CONSUMER_FRAMES {1024};
+
+// Підписка на всі джерела
+static constexpr int CONSUMER_ANY_SOURCE {-1};
+
+/// \brief Перетворений кадр для споживача: спільний для всіх споживачів, лише для читання.
+/// Копія не копіює відліки. Кадр повертається в пул, коли його відпустять всі споживачі.
+struct frame_view
+{
+    DataSourceSharedFrame frame; // кадр float з заголовком вхідного кадру
+    int elements             = 0;
+    PAYLOAD_TYPE source_type = PAYLOAD_TYPE::PAYLOAD_TYPE_UNSUPPORTED; // тип відліків джерела до перетворення
+    std::chrono::steady_clock::time_point published;                   // передача споживачам
+
+    inline const float * samples() const { return reinterpret_cast<const float *>(frame->payload()); }
+    inline std::uint8_t sourceId() const { return frame->sourceId(); }
+    inline std::uint16_t frameCounter() const { return frame->frameCounter(); }
+};
+
+/// \brief Споживач перетворених кадрів (етап ЦОС, експорт, власний запис тощо)
+class DataSourceConsumer
+{
+public:
+    virtual ~DataSourceConsumer() = default;
+
+    /// \brief Обробка кадру. Викликається з власного потоку споживача, кадри - в порядку обробки.
+    /// Копію view можна тримати і після виклику, але поки вона жива, кадр не повертається в пул.
+    /// \param view - кадр
+    virtual void consume(const frame_view & view) = 0;
+};
+
+/// \brief Підписка споживача
+struct consumer_config
+{
+    std::string name;                                                  // ім'я для статистики
+    int source_id            = CONSUMER_ANY_SOURCE;                    // ІД джерела або CONSUMER_ANY_SOURCE
+    PAYLOAD_TYPE source_type = PAYLOAD_TYPE::PAYLOAD_TYPE_UNSUPPORTED; // тип відліків джерела, UNSUPPORTED - будь-який
+    std::size_t depth        = DEFAULT_CONSUMER_DEPTH;                 // черга кадрів, не прочитаних споживачем
+};
+
+/// \brief Лічильники і затримки споживача
+struct consumer_stats
+{
+    int id = 0;
+    std::string name;
+    std::size_t depth       = 0; // глибина черги
+    std::size_t occupancy   = 0; // кадрів в черзі
+    std::uint64_t delivered = 0; // оброблені кадри
+    std::uint64_t dropped   = 0; // кадри, що застали чергу заповненою
+    latency_snapshot queue_latency;   // від передачі до початку consume()
+    latency_snapshot consume_latency; // тривалість consume()
+};
+
+/// \brief Розсилка перетворених кадрів підписаним споживачам.
+/// Кожен споживач має власний потік і чергу без блокувань (DataSourceRing) глибиною consumer_config::depth.
+/// В черги йдуть копії frame_view - один кадр пулу на всіх, лише лічильник посилань.
+/// Якщо черга споживача заповнена, кадр для нього відкидається (dropped), інші споживачі і потік обробки
+/// не чекають. Тож кадрів в чергах і в обробці споживачів не більше за heldFrames().
+class DataSourceConsumerHub
+{
+public:
+    DataSourceConsumerHub() = default;
+
+    DATA_SOURCE_NON_COPYABLE(DataSourceConsumerHub)
+
+    /// \brief Зупиняє потоки споживачів, необроблені кадри відпускаються
+    ~DataSourceConsumerHub();
+
+    /// \brief Додаємо споживача. Можна викликати з будь-якого потоку.
+    /// \param consumer - споживач
+    /// \param config - підписка і глибина черги
+    /// \return ІД споживача для remove()
+    int add(const std::shared_ptr<DataSourceConsumer> & consumer, const consumer_config & config);
+
+    /// \brief Прибираємо споживача: чекаємо поточний consume(), решта черги відпускається.
+    /// Можна викликати з будь-якого потоку, крім потоку самого споживача.
+    /// \param id - ІД з add()
+    /// \return false, якщо споживача немає
+    bool remove(const int & id);
+
+    /// \brief Чи є споживачі. Без блокувань, для потоку обробки.
+    /// \return
+    inline bool hasConsumers() const { return m_count.load(std::memory_order_relaxed) > 0; }
+
+    /// \brief Передаємо кадр підписаним споживачам. Викликається з одного потоку (потік обробки).
+    /// \param flt_frame - кадр float; якщо є хоч один підписаний споживач, забирається і стає порожнім
+    /// \param elements - к-сть відліків
+    /// \param source_type - тип відліків джерела
+    /// \return к-сть споживачів, що отримали кадр
+    std::size_t publish(DataSourceFrameHandle & flt_frame, const int & elements, const PAYLOAD_TYPE & source_type);
+
+    /// \brief Найбільша к-сть кадрів, які можуть тримати споживачі: черги і кадри в consume()
+    /// \return
+    std::size_t heldFrames() const;
+
+    /// \brief Лічильники і затримки всіх споживачів
+    /// \return
+    std::vector<consumer_stats> stats() const;
+
+    /// \brief Кадри, відкинуті через заповнені черги, за весь час (і для вже прибраних споживачів)
+    /// \return
+    inline std::uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    /// \brief К-сть споживачів
+    /// \return
+    inline int count() const { return m_count.load(std::memory_order_relaxed); }
+
+private:
+    struct consumer_worker
+    {
+        explicit consumer_worker(const std::size_t & depth):
+            ring {ceilPowerOfTwo(std::max<std::size_t>(depth, 1))}
+        {
+            ring.setLimit(std::max<std::size_t>(depth, 1));
+        }
+
+        int id = 0;
+        std::shared_ptr<DataSourceConsumer> consumer;
+        consumer_config config;
+
+        DataSourceRing<frame_view> ring;
+        DataSourceEvent event;
+        std::atomic<bool> is_active {true};
+        std::thread thread;
+
+        std::atomic<std::uint64_t> delivered {0};
+        std::atomic<std::uint64_t> dropped {0};
+        DataSourceLatencyHistogram queue_latency;
+        DataSourceLatencyHistogram consume_latency;
+    };
+
+    /// \brief Потік споживача
+    static void consumeLoop(consumer_worker * worker);
+
+    /// \brief Зупиняємо потік і відпускаємо черги
+    static void stop(consumer_worker & worker);
+
+    // Список споживачів: змінюють add()/remove(), читає publish() (блокування без конкуренції, крім зміни списку)
+    mutable std::mutex m_lock;
+    std::vector<std::unique_ptr<consumer_worker>> m_workers;
+    std::atomic<int> m_count {0};
+    std::atomic<std::uint64_t> m_dropped {0};
+    int m_next_id = 0;
+};
+
+} // namespace DATA_SOURCE_TASK
+
+#endif // DATASOURCECONSUMER_H
@@ -4,10 +4,12 @@
 #include "DataSource.h"
 #include "DataSourceBuffer.h"
 #include "DataSourceFrameProcessor.h"
+#include "DataSourcePacer.h"
 
 #include <atomic>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 namespace DATA_SOURCE_TASK
 {
@@ -20,23 +22,37 @@ public:
     /// і відповідно пам'ять для кадру
     /// \param source_path - безпосередньо походження джерела (шлях до файлу, мережева адреса тощо). Може треба
     /// параметризувати цей параметр \param source_type - тип джереала \param p_type - тип корисних даних \param
-    /// frame_size - к-сть елементів в payload
-    DataSourceController(const std::shared_ptr<DataSource> & data_source, const std::uint32_t & frame_size);
+    /// frame_size - к-сть елементів в payload \param queue - глибина черги кадрів на обробку і політика переповнення
+    /// \param rec_config - налаштування реєстраторів
+    /// \param pacing - темп читання з джерела. При пакетному читанні глибина черги не менша за два пакети.
+    /// \param shared_ring - кільця перетворених кадрів в спільній пам'яті для інших процесів
+    DataSourceController(
+        const std::shared_ptr<DataSource> & data_source,
+        const std::uint32_t & frame_size,
+        const queue_config & queue = queue_config(),
+        const recorder_config & rec_config = recorder_config(),
+        const pacer_config & pacing = pacer_config(),
+        const shared_ring_config & shared_ring = shared_ring_config());
 
     virtual ~DataSourceController();
 
     /// \brief Значення magic_word
     /// \return
-    inline int header() { return m_buffer->header(); }
+    inline int header() { return lastHeader(); }
 
     /// \brief Поточний лічильник кадрів
     /// \return
-    inline int framesTotal() { return m_buffer->frameCounter(); }
+    inline int framesTotal() { return lastFrameCounter(); }
 
-    /// \brief Час читання з джерела. Повинен бути менше FRAME_RATE.
-    /// \return
+    /// \brief Час останнього такту читання (читання + складання кадрів). Повинен бути менше FRAME_RATE.
+    /// Розподіл по етапах - latency(LATENCY_STAGE_READ) і latency(LATENCY_STAGE_DEFRAME).
+    /// \return мілісекунди
     inline double elapsed() { return m_elapsed; }
 
+    /// \brief Статистика темпу читання: перевищення такту і запізнення пробудження
+    /// \return
+    inline pacer_stats pacerStats() const { return m_pacer.stats(); }
+
     /// \brief Час запису нового фрейма
     /// \return
     inline double writeFramelapsed() { return m_data_source->readElapsed(); }
@@ -45,16 +61,28 @@ protected:
     /// \brief Потокова функція читання даних з джерела циклом з частотою FRAME_RATE
     void readData();
 
+    /// \brief Такт читання одного блоку: acquire() в кадр з пулу або позичений буфер
+    void readBlock();
+
+    /// \brief Такт пакетного читання: readBatch() в pacer_config::batch_frames кадрів з пулу
+    void readBatch();
+
 private:
-    std::atomic<int> m_elapsed; // час читання з джерела, мс
+    std::atomic<double> m_elapsed {0.}; // час такту читання, мс
 
     std::atomic<bool> m_is_read_active;
 
+    DataSourcePacer m_pacer; // темп читання
+
     std::thread m_read_thread;
 
     std::shared_ptr<DATA_SOURCE_TASK::DataSource> m_data_source;
 
-    std::shared_ptr<DataSourceBufferInterface> m_buffer; // масиви для зберішання вх. даних
+    DataSourceFrameHandle m_buffer; // кадр з пулу, в який читаємо з джерела
+
+    // Пакетне читання (pacer_config::batch_frames > 1): кадри з пулу і їх буфери для readBatch()
+    std::vector<DataSourceFrameHandle> m_batch;
+    std::vector<read_vector> m_batch_vectors;
 
     std::mutex m_mutex;
 };
@@ -0,0 +1,110 @@
+#ifndef DATASOURCECONVERT_H
+#define DATASOURCECONVERT_H
+
+#include "globals.h"
+
+namespace DATA_SOURCE_TASK
+{
+
+// Набір векторних інструкцій для перетворення відліків.
+enum class DATA_SOURCE_SIMD_LEVEL : int
+{
+    DATA_SOURCE_SIMD_LEVEL_SCALAR = 0,
+    DATA_SOURCE_SIMD_LEVEL_SSE2,
+    DATA_SOURCE_SIMD_LEVEL_AVX2,
+    DATA_SOURCE_SIMD_LEVEL_AVX512,
+    DATA_SOURCE_SIMD_LEVEL_SIZE
+};
+
+// Формат відліків в файлі запису
+enum class RECORD_FORMAT : std::uint8_t
+{
+    RECORD_FORMAT_FLOAT32 = 0, // 32 bit IEEE 754 float без змін
+    RECORD_FORMAT_FLOAT16,     // 16 bit IEEE 754 half: 11 біт мантиси
+    RECORD_FORMAT_BFLOAT16,    // старші 16 біт float: 8 біт мантиси, повний діапазон порядку
+    RECORD_FORMAT_INT16,       // 16 bit signed: x * scale з насиченням
+};
+
+// Множник формату int16 для відліків +/-1.0: 8 і 16 bit джерела записуються без втрат
+static constexpr float INT16_RECORD_SCALE {32768.f};
+
+/// \brief Найкращий набір інструкцій, який підтримує процесор (визначається через cpuid один раз).
+/// \return
+DATA_SOURCE_SIMD_LEVEL detectedSimdLevel();
+
+/// \brief Набір інструкцій, який зараз використовується для перетворення.
+/// \return
+DATA_SOURCE_SIMD_LEVEL simdLevel();
+
+/// \brief Примусово обмежити набір інструкцій (для порівняння і діагностики).
+/// Рівень, вищий за detectedSimdLevel(), обрізається до підтримуваного.
+/// \param level
+void setSimdLevel(const DATA_SOURCE_SIMD_LEVEL & level);
+
+/// \brief Назва набору інструкцій
+/// \param level
+/// \return
+const char * simdLevelName(const DATA_SOURCE_SIMD_LEVEL & level);
+
+/// \brief Перетворення відліків до 32 bit IEEE 754 float з приведенням до діапазону +/-1.0 за один прохід.
+/// 8 bit unsigned: (x - 128) / 128, 16/32 bit signed: x / 2^(N-1), float: обмеження до [-1.0, 1.0].
+/// \param p_type - тип вхідних відліків
+/// \param src - вхідні відліки, вирівнювання не вимагається
+/// \param payload_size - розмір вхідних даних в байтах
+/// \param dst - вихідний масив, місця має вистачати на payload_size / sizeof(type) відліків
+/// \return к-сть перетворених відліків, 0 для непідтримуваного типу
+int convertToFloat(const PAYLOAD_TYPE & p_type, const char * src, const int & payload_size, float * dst);
+
+/// \brief Зворотне до convertToFloat() перетворення: відліки +/-1.0 в тип джерела з округленням і насиченням.
+/// Для відтворення записів і генерації сигналів, не для гарячого шляху.
+/// \param p_type - тип вихідних відліків
+/// \param src - відліки float
+/// \param count - к-сть відліків
+/// \param dst - вихідний масив, count * payloadTypeSize(p_type) байт
+void convertFromFloat(const PAYLOAD_TYPE & p_type, const float * src, const int & count, char * dst);
+
+/// \brief Розмір одного відліку для типу даних
+/// \param p_type
+/// \return 0 для непідтримуваного типу
+int payloadTypeSize(const PAYLOAD_TYPE & p_type);
+
+/// \brief Розмір одного відліку у форматі запису
+/// \param format
+/// \return 0 для непідтримуваного формату
+int recordFormatSize(const RECORD_FORMAT & format);
+
+/// \brief Назва формату запису
+/// \param format
+/// \return
+const char * recordFormatName(const RECORD_FORMAT & format);
+
+/// \brief Звуження float відліків до формату запису за один прохід (SSE2/AVX2, float16 - F16C).
+/// Округлення до найближчого парного, int16 - з насиченням.
+/// \param format - формат запису
+/// \param src - відліки float
+/// \param count - к-сть відліків
+/// \param dst - вихідний масив, count * recordFormatSize(format) байт
+/// \param scale - множник для RECORD_FORMAT_INT16
+void convertToRecord(
+    const RECORD_FORMAT & format,
+    const float * src,
+    const int & count,
+    char * dst,
+    const float & scale);
+
+/// \brief Розширення відліків формату запису до float (читання записів)
+/// \param format - формат запису
+/// \param src - відліки у форматі запису
+/// \param count - к-сть відліків
+/// \param dst - вихідний масив
+/// \param scale - множник, з яким записано RECORD_FORMAT_INT16
+void convertFromRecord(
+    const RECORD_FORMAT & format,
+    const char * src,
+    const int & count,
+    float * dst,
+    const float & scale);
+
+} // namespace DATA_SOURCE_TASK
+
+#endif // DATASOURCECONVERT_H
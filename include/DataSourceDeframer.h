@@ -0,0 +1,89 @@
+#ifndef DATASOURCEDEFRAMER_H
+#define DATASOURCEDEFRAMER_H
+
+#include "DataSourceBuffer.h"
+
+#include <vector>
+
+namespace DATA_SOURCE_TASK
+{
+
+/// \brief Пошук magic_word в масиві байт (SSE2, якщо доступно).
+/// \param data - масив
+/// \param size - розмір масиву
+/// \param magic_word - шуканий ідентифікатор, little-endian
+/// \return зміщення першого входження або -1
+int findMagicWord(const char * data, const int & size, const std::uint32_t & magic_word);
+
+/// \brief Потоковий розбір кадрів.
+/// DataSource::read() може повернути від 0 до size байт, тому байти накопичуються, межі кадрів шукаються
+/// по magic_word, а кадр видається тільки коли payload_size байт корисних даних вже отримано.
+/// При втраті синхронізації сміття пропускається до наступного magic_word.
+/// Використовується лише з потоку читання.
+class DataSourceDeframer
+{
+public:
+    /// \brief Конструктор
+    /// \param max_frame_size - максимальний розмір кадру з заголовком
+    /// \param magic_word - ідентифікатор початку кадру
+    DataSourceDeframer(const std::uint32_t & max_frame_size, const std::uint32_t & magic_word = FRAME_MAGIC_WORD);
+
+    DATA_SOURCE_NON_COPYABLE(DataSourceDeframer)
+
+    /// \brief Перевірка заголовку кадру: magic_word, тип і розмір корисних даних
+    /// \param frm - заголовок
+    /// \return
+    bool isValidHeader(const struct frame & frm) const;
+
+    /// \brief Розмір повного кадру, який лежить на початку data.
+    /// \param data - дані з джерела
+    /// \param size - к-сть отриманих байт
+    /// \return розмір кадру з заголовком або 0, якщо повного коректного кадру немає
+    int completeFrameSize(const char * data, const int & size) const;
+
+    /// \brief Дописуємо отримані байти в накопичувач
+    /// \param data
+    /// \param size
+    void push(const char * data, const int & size);
+
+    /// \brief Видаємо наступний повний кадр
+    /// \param frame - кадр, в який копіюються дані
+    /// \return розмір кадру з заголовком, 0 якщо повного кадру ще немає
+    int next(DataSourceBufferInterface & frame);
+
+    /// \brief К-сть накопичених і ще не розібраних байт
+    /// \return
+    inline int pending() const { return m_end - m_begin; }
+
+    /// \brief К-сть втрат синхронізації (пропущених ділянок сміття)
+    /// \return
+    inline std::uint64_t resyncs() const { return m_resyncs; }
+
+    /// \brief К-сть заголовків з некоректним розміром або типом даних
+    /// \return
+    inline std::uint64_t brokenHeaders() const { return m_broken_headers; }
+
+    /// \brief К-сть пропущених байт
+    /// \return
+    inline std::uint64_t skippedBytes() const { return m_skipped_bytes; }
+
+private:
+    /// \brief Пропускаємо байти до наступного magic_word
+    void resync();
+
+    const std::uint32_t m_max_frame_size;
+    const std::uint32_t m_magic_word;
+
+    std::vector<char> m_buffer; // накопичувач
+    int m_begin = 0;            // початок не розібраних даних
+    int m_end   = 0;            // кінець записаних даних
+    bool m_in_sync = true;      // останній розібраний кадр був коректним
+
+    std::uint64_t m_resyncs        = 0;
+    std::uint64_t m_broken_headers = 0;
+    std::uint64_t m_skipped_bytes  = 0;
+};
+
+} // namespace DATA_SOURCE_TASK
+
+#endif // DATASOURCEDEFRAMER_H
@@ -2,42 +2,142 @@
 #define DATASOURCEEMULATOR_H
 
 #include "DataSource.h"
-#include "DataSourceBuffer.h"
+#include "DataSourceAlignedAllocator.h"
 
 #include <mutex>
-#include <memory>
+#include <vector>
 
 namespace DATA_SOURCE_TASK
 {
 
+// Вирівнювання навантаження кадрів-шаблонів (AVX-512)
+static constexpr std::size_t EMULATOR_PAYLOAD_ALIGNMENT {64};
+
+// К-сть кадрів-шаблонів за замовчуванням
+static constexpr int EMULATOR_TEMPLATE_COUNT {16};
+
+// Сигнал емулятора
+enum class EMULATOR_SIGNAL : std::uint8_t
+{
+    EMULATOR_SIGNAL_CONSTANT = 0, // постійний рівень amplitude
+    EMULATOR_SIGNAL_SINE,         // синус частоти frequency
+    EMULATOR_SIGNAL_CHIRP,        // лінійна зміна частоти від frequency до frequency_end за всі шаблони
+    EMULATOR_SIGNAL_NOISE,        // рівномірний шум +/-amplitude
+};
+
+// Збій емулятора
+enum class EMULATOR_FAULT : std::uint8_t
+{
+    EMULATOR_FAULT_LOSS = 0,   // кадри не видаються, лічильник іде далі
+    EMULATOR_FAULT_SHORT_READ, // кадр видається частинами: не більше size / value байт за читання
+    EMULATOR_FAULT_CORRUPT,    // в кадрі інвертується байт зі зміщенням value (0 - magic_word)
+    EMULATOR_FAULT_SOURCE_ID,  // до ІД джерела додається value (по модулю 256), з цього кадру і далі
+};
+
+/// \brief Крок сценарію збоїв
+struct emulator_fault
+{
+    std::uint64_t frame  = 0; // номер кадру від початку, з 0 (з урахуванням втрачених)
+    EMULATOR_FAULT type  = EMULATOR_FAULT::EMULATOR_FAULT_LOSS;
+    std::uint32_t count  = 1; // к-сть кадрів підряд
+    int value            = 0; // параметр збою
+    std::uint64_t period = 0; // повтор кожні period кадрів, 0 - один раз
+};
+
+/// \brief Сценарій за замовчуванням - як було до сценаріїв:
+/// перші 5 кадрів половинами, ІД джерела +1 кожні 1000 кадрів
+/// \return
+std::vector<emulator_fault> defaultEmulatorFaults();
+
+/// \brief Налаштування емулятора
+struct emulator_config
+{
+    EMULATOR_SIGNAL signal = EMULATOR_SIGNAL::EMULATOR_SIGNAL_CONSTANT;
+    float amplitude        = 0.5f;        // рівень відносно повної шкали типу, 0..1
+    float frequency        = 1.f / 64.f;  // частота, циклів на відлік
+    float frequency_end    = 1.f / 4.f;   // кінцева частота EMULATOR_SIGNAL_CHIRP, циклів на відлік
+    std::uint64_t seed     = 1;           // зерно шуму, кожен емулятор - своє
+    int template_count     = EMULATOR_TEMPLATE_COUNT; // кадрів-шаблонів, видаються по колу
+    std::uint8_t source_id = 1;           // початковий ІД джерела
+    std::vector<emulator_fault> faults = defaultEmulatorFaults(); // сценарій збоїв
+};
+
 /// \brief Клас емулює роботу зовнішноього джарела даних.
+/// Сигнал генерується один раз при створенні в template_count кадрів-шаблонів (навантаження вирівняне на
+/// EMULATOR_PAYLOAD_ALIGNMENT), далі кадри видаються по колу через acquire() без копіювання - змінюються лише
+/// поля заголовку. Збої (втрати, часткове читання, пошкодження, зміна ІД джерела) йдуть за сценарієм
+/// emulator_config::faults від номера кадру, тож повторюються однаково від запуску до запуску.
+/// Стан кожного емулятора власний: кілька емуляторів не впливають один на одного.
 class DataSourceFileEmulator final : public DataSource
 {
 public:
     /// \brief Емулятор певного джерела
-    /// \param s_type - тип джерела
     /// \param p_type - тип даних
-    /// \param frame_size - к-сть відліків сигналу
-    explicit DataSourceFileEmulator(const DATA_SOURCE_TASK::PAYLOAD_TYPE & p_type, const int & frame_size);
+    /// \param frame_size - розмір кадру з заголовком, байт
+    /// \param config - сигнал і сценарій збоїв
+    explicit DataSourceFileEmulator(
+        const DATA_SOURCE_TASK::PAYLOAD_TYPE & p_type,
+        const int & frame_size,
+        const emulator_config & config = emulator_config());
 
     virtual ~DataSourceFileEmulator();
 
+    /// \brief Сумісність: копія позиченої порції acquire()
     int read(char * data, int size) override;
 
+    /// \brief Позичаємо залишок поточного кадру, не більше size байт. buffer не використовується.
+    read_block acquire(char * buffer, int size) override;
+
+    /// \brief Пересуваємо позицію в кадрі на consumed байт
+    void commit(const read_block & block, int consumed) override;
+
+    /// \brief Пакетне читання під одним блокуванням: кожен буфер отримує залишок поточного кадру
+    int readBatch(read_vector * frames, int count) override;
+
+    /// \brief К-сть виданих кадрів (почато видачу)
+    /// \return
+    inline std::uint64_t framesEmitted() const { return m_emitted; }
+
+    /// \brief К-сть кадрів, пропущених за сценарієм
+    /// \return
+    inline std::uint64_t framesLost() const { return m_lost; }
+
 protected:
-    void updateData();
+    /// \brief Кадри-шаблони з сигналом
+    void generateTemplates(const PAYLOAD_TYPE & p_type);
 
-    void updateBufs();
+    /// \brief Переходимо до наступного кадру: шаблон, лічильник і збої за сценарієм
+    void nextFrame();
 
-    void generateRandom();
+    /// \brief Залишок поточного кадру, не більше size байт. Викликається під m_read_lock.
+    read_block nextBlock(int size);
 
 private:
-    int m_byte_size = 0;
+    /// \brief Чи діє крок сценарію на кадр frame
+    static bool isFaultAt(const emulator_fault & fault, const std::uint64_t & frame);
 
-    std::atomic<uint16_t> m_frm_counter {0};
-    std::mutex m_read_lock;
+    const emulator_config m_config;
 
-    std::shared_ptr<DataSourceBufferInterface> m_buffer;
+    int m_frame_size    = 0; // розмір кадру з заголовком
+    std::size_t m_stride = 0; // відстань між шаблонами
+
+    std::vector<char, DataSourceAlignedAllocator<char, EMULATOR_PAYLOAD_ALIGNMENT>> m_templates;
+
+    char * m_frame    = nullptr; // поточний кадр - один з шаблонів
+    int m_stream_pos  = 0;       // позиція в поточному кадрі потоку
+    int m_read_divider = 1;      // EMULATOR_FAULT_SHORT_READ поточного кадру
+
+    // пошкоджений байт поточного кадру, відновлюється при переході до наступного
+    int m_corrupt_offset = -1;
+    char m_corrupt_byte  = 0;
+
+    std::uint64_t m_frame_index = 0; // номер наступного кадру
+    std::uint8_t m_source_id    = 1;
+
+    std::atomic<std::uint64_t> m_emitted {0};
+    std::atomic<std::uint64_t> m_lost {0};
+
+    std::mutex m_read_lock;
 };
 
 } // namespace DATA_SOURCE_TASK
@@ -0,0 +1,79 @@
+#ifndef DATASOURCEEVENT_H
+#define DATASOURCEEVENT_H
+
+#include "globals.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace DATA_SOURCE_TASK
+{
+
+/// \brief Подія для передачі між етапами: виробник публікує дані (кільце без блокувань) і викликає notify(),
+/// споживач спить в wait() до появи даних.
+/// notify() йде в ядро (futex під condition_variable) лише коли споживач справді спить: поки він зайнятий,
+/// виклик - одне атомарне читання, тож виробник не платить системним викликом за кожен кадр.
+/// Умова чекання перевіряється до засинання і після кожного пробудження, тому сповіщення не губиться,
+/// навіть якщо виробник опублікував дані між перевіркою і засинанням.
+class DataSourceEvent
+{
+public:
+    DataSourceEvent() = default;
+
+    DATA_SOURCE_NON_COPYABLE(DataSourceEvent)
+
+    /// \brief Будимо сплячих споживачів. Викликається після публікації даних.
+    void notify()
+    {
+        // публікація даних має бути видна до перевірки сплячих (пара до fence в waitFor)
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (!m_waiters.load(std::memory_order_relaxed))
+            return;
+
+        {
+            // споживач між перевіркою умови і засинанням тримає m_lock - сповіщення не проскочить повз
+            std::lock_guard<std::mutex> lock(m_lock);
+        }
+
+        m_wake.notify_all();
+    }
+
+    /// \brief Чекаємо, доки ready() не поверне true, не довше timeout.
+    /// \param ready - умова, перевіряється без блокувань виробника
+    /// \param timeout - межа очікування
+    /// \return значення ready() на виході
+    template<typename Ready, typename Rep, typename Period>
+    bool waitFor(Ready ready, const std::chrono::duration<Rep, Period> & timeout)
+    {
+        if (ready())
+            return true;
+
+        std::unique_lock<std::mutex> lock(m_lock);
+
+        m_waiters.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        const bool is_ready = m_wake.wait_for(lock, timeout, ready);
+
+        m_waiters.fetch_sub(1, std::memory_order_relaxed);
+
+        return is_ready;
+    }
+
+    /// \brief К-сть споживачів, що зараз сплять
+    /// \return
+    inline int waiters() const { return m_waiters.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int> m_waiters {0};
+
+    std::mutex m_lock;
+    std::condition_variable m_wake;
+};
+
+} // namespace DATA_SOURCE_TASK
+
+#endif // DATASOURCEEVENT_H
@@ -4,24 +4,88 @@
 #include "DataSource.h"
 
 #include <mutex>
+#include <string>
 
 namespace DATA_SOURCE_TASK
 {
 
+// Обсяг попереднього читання (MADV_WILLNEED) попереду курсору.
+static constexpr std::uint64_t FILE_READ_AHEAD_SIZE {8u * 1024u * 1024u};
+
 /// \brief Клас джерело даних.
-/// Читає дані з файлу і передає по методу read.
-/// Вже не використовується.
+/// Відображає файл запису в пам'ять і послідовно видає його кадр за кадром, пересуваючи курсор.
+/// Використовується для відтворення записаних потоків і навантажувального тестування.
 class DataSourceFile final : public DataSource
 {
 public:
-    explicit DataSourceFile(const std::string & file_path);
+    /// \brief Конструктор
+    /// \param file_path - шлях до файлу
+    /// \param is_looped - після кінця файлу продовжуємо з початку
+    explicit DataSourceFile(const std::string & file_path, const bool & is_looped = false);
     virtual ~DataSourceFile();
 
+    /// \brief Копіюємо наступні size байт файлу. Сумісність: копія порції acquire().
+    /// \return к-сть скопійованих байт, 0 в кінці файлу
     int read(char * data, int size) override;
 
+    /// \brief Позичаємо наступні size байт відображеної пам'яті. buffer не використовується.
+    /// Курсор пересуває commit().
+    read_block acquire(char * buffer, int size) override;
+
+    /// \brief Пересуваємо курсор на consumed байт
+    void commit(const read_block & block, int consumed) override;
+
+    /// \brief Пакетне читання під одним блокуванням: наступні frames[i].size байт в кожен буфер
+    int readBatch(read_vector * frames, int count) override;
+
+    /// \brief Видаємо наступні size байт без копіювання - вказівник на відображену пам'ять.
+    /// Дані дійсні, доки існує об'єкт.
+    /// \param data - вказівник на початок даних
+    /// \param size - бажаний розмір
+    /// \return к-сть доступних байт, 0 в кінці файлу
+    int view(const char ** data, int size);
+
+    /// \brief Чи вдалось відкрити і відобразити файл
+    /// \return
+    inline bool isOpen() const { return m_map != nullptr; }
+
+    /// \brief Розмір файлу
+    /// \return
+    inline std::uint64_t fileSize() const { return m_file_size; }
+
+    /// \brief Поточна позиція курсору
+    /// \return
+    inline std::uint64_t position() const { return m_pos; }
+
+    /// \brief Повертаємо курсор на початок файлу
+    void rewind();
+
 private:
+    /// \brief Пересуваємо курсор на size байт
+    /// \param size - бажаний розмір
+    /// \param offset - позиція початку даних
+    /// \return к-сть доступних байт
+    int advance(int size, std::uint64_t & offset);
+
+    /// \brief Підказка ядру про читання наперед
+    void readAhead();
+
+    void unmap();
+
     std::mutex m_data_mutex;
     std::string m_file_path;
+    bool m_is_looped = false;
+
+    const char * m_map           = nullptr; // відображений файл
+    std::uint64_t m_file_size    = 0;
+    std::uint64_t m_pos          = 0; // курсор
+    std::uint64_t m_ahead_pos    = 0; // межа, до якої вже запрошено читання наперед
+#ifdef WIN32
+    void * m_file_handle    = nullptr;
+    void * m_mapping_handle = nullptr;
+#else
+    int m_fd = -1;
+#endif
 };
 
 } // namespace DATA_SOURCE_TASK
@@ -0,0 +1,108 @@
+#ifndef DATASOURCEFLIGHTRECORDER_H
+#define DATASOURCEFLIGHTRECORDER_H
+
+#include "globals.h"
+
+#include <string>
+
+namespace DATA_SOURCE_TASK
+{
+
+// Розмір кільцевого файлу за замовчуванням, 256 МБ.
+static constexpr std::uint64_t DEFAULT_FLIGHT_RING_SIZE {256ull * 1024ull * 1024ull};
+
+// Ідентифікатори файлу і блоку ("DSFR", "DSFB")
+static constexpr std::uint32_t FLIGHT_RING_MAGIC {0x52465344};
+static constexpr std::uint32_t FLIGHT_BLOCK_MAGIC {0x42465344};
+static constexpr std::uint32_t FLIGHT_RING_VERSION {1};
+
+// Зміщення області даних від початку файлу (заголовок займає окрему сторінку).
+static constexpr std::uint64_t FLIGHT_RING_DATA_OFFSET {4096};
+
+/// \brief Заголовок кільцевого файлу. Лежить на початку файлу, оновлюється при кожному блоці.
+struct flight_ring_header
+{
+    std::uint32_t magic;           // FLIGHT_RING_MAGIC
+    std::uint32_t version;         // FLIGHT_RING_VERSION
+    std::uint64_t data_offset;     // зміщення області даних
+    std::uint64_t capacity;        // розмір області даних, байт
+    std::atomic<std::uint64_t> head;     // к-сть байт, записаних за весь час; позиція = head % capacity
+    std::atomic<std::uint64_t> sequence; // номер наступного блоку
+    std::uint8_t source_id;        // ІД джерела
+    std::uint8_t reserved[7];
+};
+
+/// \brief Заголовок блоку в кільці. За ним payload_size байт float відліків.
+/// Блок з payload_size == 0 і frame_counter == UINT16_MAX позначає перехід на початок області даних.
+struct flight_block_header
+{
+    std::uint32_t magic;         // FLIGHT_BLOCK_MAGIC
+    std::uint32_t payload_size;  // розмір даних, байт
+    std::uint64_t sequence;      // номер блоку, пишеться останнім
+    std::uint64_t timestamp_ns;  // час запису блоку (system_clock), нс
+    std::uint16_t frame_counter; // лічильник кадру
+    std::uint8_t source_id;      // ІД джерела
+    std::uint8_t reserved[5];
+};
+
+/// \brief "Бортовий самописець" джерела: останні N хвилин даних в кільцевому файлі.
+/// Файл фіксованого розміру виділяється наперед (posix_fallocate) і відображається в пам'ять (MAP_SHARED),
+/// блоки копіюються прямо у відображення без системних викликів запису. Дані лишаються в page cache і
+/// потрапляють у файл навіть після аварійного завершення процесу.
+/// Інші процеси можуть читати кільце під час запису: блок дійсний, якщо його sequence не змінився
+/// після копіювання і head ще не обігнав його позицію на capacity.
+/// Не потокобезпечний, запис з одного потоку.
+class DataSourceFlightRecorder
+{
+public:
+    /// \brief Конструктор. Створює або перевикористовує файл.
+    /// \param file_name - ім'я кільцевого файлу
+    /// \param ring_size - розмір області даних, байт
+    /// \param source_id - ІД джерела для заголовку
+    DataSourceFlightRecorder(
+        const std::string & file_name,
+        const std::uint64_t & ring_size = DEFAULT_FLIGHT_RING_SIZE,
+        const std::uint8_t & source_id = 0);
+
+    DATA_SOURCE_NON_COPYABLE(DataSourceFlightRecorder)
+
+    ~DataSourceFlightRecorder();
+
+    /// \brief Чи вдалось створити і відобразити файл
+    /// \return
+    inline bool isOpen() const { return m_header != nullptr; }
+
+    /// \brief Копіюємо блок відліків у кільце
+    /// \param data - відліки float
+    /// \param size - розмір, байт
+    /// \param frame_counter - лічильник кадру
+    /// \return false, якщо кільце не відкрите або блок більший за кільце
+    bool write(const char * data, const std::uint32_t & size, const std::uint16_t & frame_counter);
+
+    /// \brief Ім'я файлу
+    /// \return
+    inline const std::string & fileName() const { return m_file_name; }
+
+    /// \brief К-сть записаних блоків
+    /// \return
+    std::uint64_t blocksWritten() const;
+
+private:
+    void close();
+
+    std::string m_file_name;
+    std::uint8_t m_source_id = 0;
+
+    std::uint64_t m_capacity        = 0;       // розмір області даних
+    std::uint64_t m_map_size        = 0;       // розмір відображення
+    char * m_map                    = nullptr; // відображений файл
+    flight_ring_header * m_header   = nullptr; // заголовок у відображенні
+    char * m_data                   = nullptr; // область даних у відображенні
+#ifndef WIN32
+    int m_fd = -1;
+#endif
+};
+
+} // namespace DATA_SOURCE_TASK
+
+#endif // DATASOURCEFLIGHTRECORDER_H
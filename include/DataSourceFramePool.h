@@ -0,0 +1,263 @@
+#ifndef DATASOURCEFRAMEPOOL_H
+#define DATASOURCEFRAMEPOOL_H
+
+#include "DataSourceBuffer.h"
+#include "DataSourceEvent.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace DATA_SOURCE_TASK
+{
+
+// Вирівнювання відліків кадрів в пулі (кеш-лінія, достатньо для AVX-512).
+static constexpr std::size_t FRAME_POOL_ALIGNMENT {64};
+
+class DataSourceFramePool;
+
+/// \brief Кадр, пам'ять якого належить пулу.
+/// Заголовок розміщено так, щоб відліки починались з межі FRAME_POOL_ALIGNMENT.
+class DataSourcePoolBuffer final : public DataSourceBufferInterface
+{
+public:
+    DataSourcePoolBuffer(
+        DataSourceFramePool * pool,
+        char * data,
+        const std::uint32_t & index,
+        const std::uint32_t & frame_size,
+        const std::uint8_t & type_size);
+
+    DATA_SOURCE_NON_COPYABLE(DataSourcePoolBuffer)
+
+private:
+    friend class DataSourceFramePool;
+    friend class DataSourceFrameHandle;
+    friend class DataSourceSharedFrame;
+
+    DataSourceFramePool * m_pool;     // пул, в який повертається кадр
+    const std::uint32_t m_index;      // позиція кадру в пулі
+    std::atomic<std::uint32_t> m_next; // наступний вільний кадр (інтрузивний список)
+    std::atomic<std::uint32_t> m_refs; // власники DataSourceSharedFrame
+};
+
+/// \brief Дескриптор кадру з пулу. Лише переміщується, без лічильника посилань.
+/// При знищенні або reset() кадр повертається в пул.
+class DataSourceFrameHandle
+{
+public:
+    DataSourceFrameHandle() = default;
+
+    DataSourceFrameHandle(const DataSourceFrameHandle &) = delete;
+    DataSourceFrameHandle & operator=(const DataSourceFrameHandle &) = delete;
+
+    DataSourceFrameHandle(DataSourceFrameHandle && other) noexcept:
+        m_buffer {other.m_buffer}
+    {
+        other.m_buffer = nullptr;
+    }
+
+    DataSourceFrameHandle & operator=(DataSourceFrameHandle && other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            m_buffer       = other.m_buffer;
+            other.m_buffer = nullptr;
+        }
+
+        return *this;
+    }
+
+    ~DataSourceFrameHandle() { reset(); }
+
+    /// \brief Повертаємо кадр в пул
+    void reset();
+
+    void swap(DataSourceFrameHandle & other) noexcept { std::swap(m_buffer, other.m_buffer); }
+
+    inline DataSourceBufferInterface * get() const { return m_buffer; }
+    inline DataSourceBufferInterface * operator->() const { return m_buffer; }
+    inline DataSourceBufferInterface & operator*() const { return *m_buffer; }
+    explicit operator bool() const { return m_buffer != nullptr; }
+
+private:
+    friend class DataSourceFramePool;
+    friend class DataSourceSharedFrame;
+
+    explicit DataSourceFrameHandle(DataSourcePoolBuffer * buffer):
+        m_buffer {buffer}
+    {
+    }
+
+    DataSourcePoolBuffer * m_buffer = nullptr;
+};
+
+/// \brief Спільний кадр з пулу лише для читання, з лічильником посилань в самому кадрі.
+/// Копія - атомарний інкремент, без виділення пам'яті; кадр повертається в пул, коли знищено останню копію.
+/// Копії можна передавати і знищувати в різних потоках.
+class DataSourceSharedFrame
+{
+public:
+    DataSourceSharedFrame() = default;
+
+    /// \brief Забираємо кадр у дескриптора, той стає порожнім
+    /// \param frame
+    explicit DataSourceSharedFrame(DataSourceFrameHandle && frame) noexcept:
+        m_buffer {frame.m_buffer}
+    {
+        frame.m_buffer = nullptr;
+
+        if (m_buffer)
+            m_buffer->m_refs.store(1, std::memory_order_relaxed);
+    }
+
+    DataSourceSharedFrame(const DataSourceSharedFrame & other) noexcept:
+        m_buffer {other.m_buffer}
+    {
+        if (m_buffer)
+            m_buffer->m_refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    DataSourceSharedFrame(DataSourceSharedFrame && other) noexcept:
+        m_buffer {other.m_buffer}
+    {
+        other.m_buffer = nullptr;
+    }
+
+    DataSourceSharedFrame & operator=(const DataSourceSharedFrame & other) noexcept
+    {
+        DataSourceSharedFrame copy(other);
+        swap(copy);
+
+        return *this;
+    }
+
+    DataSourceSharedFrame & operator=(DataSourceSharedFrame && other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            m_buffer       = other.m_buffer;
+            other.m_buffer = nullptr;
+        }
+
+        return *this;
+    }
+
+    ~DataSourceSharedFrame() { reset(); }
+
+    /// \brief Відпускаємо кадр. Останній власник повертає його в пул.
+    void reset();
+
+    void swap(DataSourceSharedFrame & other) noexcept { std::swap(m_buffer, other.m_buffer); }
+
+    /// \brief К-сть власників кадру
+    /// \return
+    inline std::uint32_t useCount() const { return m_buffer ? m_buffer->m_refs.load(std::memory_order_relaxed) : 0; }
+
+    inline const DataSourceBufferInterface * get() const { return m_buffer; }
+    inline const DataSourceBufferInterface * operator->() const { return m_buffer; }
+    inline const DataSourceBufferInterface & operator*() const { return *m_buffer; }
+    explicit operator bool() const { return m_buffer != nullptr; }
+
+private:
+    DataSourcePoolBuffer * m_buffer = nullptr;
+};
+
+/// \brief Пул кадрів.
+/// Пам'ять виділяється вирівняними блоками: в конструкторі на capacity кадрів і в grow() до max_capacity.
+/// Вільні кадри тримаються в стеку без блокувань, тому acquire()/release можна викликати з різних потоків,
+/// в т.ч. одночасно з grow(). Пул не зменшується.
+/// Пул має жити довше за всі видані дескриптори.
+class DataSourceFramePool
+{
+public:
+    /// \brief Конструктор
+    /// \param frame_size - розмір кадру з заголовком, байт
+    /// \param capacity - к-сть кадрів
+    /// \param type_size - розмір відліку (sizeof(uint8_t), sizeof(float) ...)
+    /// \param max_capacity - межа росту через grow(), 0 - без росту
+    DataSourceFramePool(
+        const std::uint32_t & frame_size,
+        const std::size_t & capacity,
+        const std::uint8_t & type_size,
+        const std::size_t & max_capacity = 0);
+
+    DATA_SOURCE_NON_COPYABLE(DataSourceFramePool)
+
+    ~DataSourceFramePool();
+
+    /// \brief Беремо вільний кадр.
+    /// \return порожній дескриптор, якщо пул вичерпано
+    DataSourceFrameHandle acquire();
+
+    /// \brief Додаємо кадри до пулу.
+    /// \param count - к-сть нових кадрів, обрізається до maxCapacity()
+    /// \return к-сть доданих кадрів
+    std::size_t grow(const std::size_t & count);
+
+    /// \brief Доводимо ємність пулу до capacity кадрів, якщо вона менша. На відміну від послідовних
+    /// capacity()/grow(), одночасні виклики не додають кадри двічі.
+    /// \param capacity - потрібна ємність, обрізається до maxCapacity()
+    /// \return к-сть доданих кадрів
+    std::size_t reserve(const std::size_t & capacity);
+
+    /// \brief Ємність пулу
+    /// \return
+    inline std::size_t capacity() const { return m_capacity.load(std::memory_order_acquire); }
+
+    /// \brief Межа росту пулу
+    /// \return
+    inline std::size_t maxCapacity() const { return m_max_capacity; }
+
+    /// \brief Пам'ять на один кадр з вирівнюванням, байт
+    /// \return
+    inline std::size_t frameStride() const { return m_stride; }
+
+    /// \brief К-сть вільних кадрів
+    /// \return
+    inline std::size_t available() const { return m_available.load(std::memory_order_relaxed); }
+
+    /// \brief Розмір кадру з заголовком
+    /// \return
+    inline std::uint32_t frameSize() const { return m_frame_size; }
+
+    /// \brief Подія, яку пул будить при поверненні кадру: для потоку, що чекає вільний кадр.
+    /// Задається до видачі кадрів, подія має жити довше за пул.
+    /// \param event - подія, nullptr - без сповіщень
+    inline void setReleaseEvent(DataSourceEvent * event) { m_release_event = event; }
+
+private:
+    friend class DataSourceFrameHandle;
+    friend class DataSourceSharedFrame;
+
+    /// \brief Повертаємо кадр в стек вільних
+    void release(DataSourcePoolBuffer * buffer);
+
+    /// \brief Додаємо кадри, m_grow_lock вже взято
+    std::size_t growLocked(const std::size_t & count);
+
+    std::uint32_t m_frame_size = 0; // розмір кадру з заголовком
+    std::uint8_t m_type_size   = 0; // розмір відліку
+    std::size_t m_stride       = 0; // відстань між кадрами в пам'яті, кратна FRAME_POOL_ALIGNMENT
+    std::size_t m_max_capacity = 0; // межа росту
+
+    std::mutex m_grow_lock;                          // лише для grow()/reserve()
+    std::vector<std::unique_ptr<char[]>> m_memory;   // блоки пам'яті кадрів
+    // Кадри за індексом. Масив виділено на max_capacity наперед, тому grow() не переміщує вже видані кадри.
+    std::unique_ptr<std::unique_ptr<DataSourcePoolBuffer>[]> m_buffers;
+    std::atomic<std::size_t> m_capacity {0};
+
+    // Вершина стеку вільних кадрів: молодші 32 біти - індекс, старші - тег проти ABA.
+    std::atomic<std::uint64_t> m_free_head;
+    std::atomic<std::size_t> m_available {0};
+
+    DataSourceEvent * m_release_event = nullptr; // будиться в release()
+};
+
+} // namespace DATA_SOURCE_TASK
+
+#endif // DATASOURCEFRAMEPOOL_H
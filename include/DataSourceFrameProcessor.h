@@ -1,13 +1,24 @@
 #ifndef DATASOURCEFRAMEPROCESSOR_H
 #define DATASOURCEFRAMEPROCESSOR_H
 
+#include "DataSource.h"
 #include "DataSourceBuffer.h"
+#include "DataSourceConsumer.h"
+#include "DataSourceDeframer.h"
+#include "DataSourceEvent.h"
+#include "DataSourceFramePool.h"
 #include "DataSourceFrameRecorder.h"
+#include "DataSourceLatencyHistogram.h"
+#include "DataSourceMetrics.h"
+#include "DataSourceRing.h"
+#include "DataSourceSharedRing.h"
+#include "DataSourceWorkerPool.h"
 
 #include <memory>
-#include <mutex>
+#include <thread>
 #include <atomic>
 #include <unordered_map>
+#include <vector>
 
 namespace DATA_SOURCE_TASK
 {
@@ -18,85 +29,345 @@ enum class DATA_SOURCE_HW_CONV_TYPE : int
     DATA_SOURCE_HW_CONV_TYPE_GPU
 };
 
-// Буферізація масивів вхідних даних
-static constexpr int BUFERIZATION_NUM {2};
+// Що робити з новим кадром, коли черга на обробку заповнена
+enum class QUEUE_POLICY : int
+{
+    QUEUE_POLICY_BLOCK = 0,   // потік читання чекає вільного слоту
+    QUEUE_POLICY_DROP_NEWEST, // новий кадр відкидається
+    QUEUE_POLICY_DROP_OLDEST, // найстаріший необроблений кадр відкидається на користь нового
+    QUEUE_POLICY_SPILL,       // кадр відкладається в обмежений резерв; якщо і резерв заповнений - DROP_NEWEST
+};
+
+// Ємність резерву для QUEUE_POLICY_SPILL за замовчуванням, кадрів
+static constexpr std::size_t DEFAULT_SPILL_CAPACITY {16};
+
+// Автопідбір: межа глибини черги і к-сті буферів запису за замовчуванням, період перерахунку
+static constexpr std::size_t AUTO_TUNE_MAX_DEPTH {256};
+static constexpr std::size_t AUTO_TUNE_MAX_REC_BUF_NUM {16};
+static constexpr int AUTO_TUNE_INTERVAL_MS {1000};
+
+// Період перевірки реєстраторів без кадрів
+static constexpr int RECORDER_EVICT_INTERVAL_MS {1000};
+
+// Паралельне перетворення: к-сть кадрів, що перетворюються разом, і розмір частини кадру на одну задачу, байт
+static constexpr std::size_t DEFAULT_PROCESS_BATCH {4};
+static constexpr std::uint32_t DEFAULT_CONVERT_CHUNK_SIZE {64 * 1024};
+
+/// \brief Налаштування черги кадрів на обробку
+struct queue_config
+{
+    std::size_t depth           = DEFAULT_QUEUE_DEPTH;                    // початкова глибина черги
+    QUEUE_POLICY policy         = QUEUE_POLICY::QUEUE_POLICY_DROP_NEWEST; // поведінка при переповненні
+    std::size_t spill_capacity  = DEFAULT_SPILL_CAPACITY;                 // ємність резерву, лише для SPILL
+    std::size_t float_pool_size = MAX_PROCESSING_BUF_NUM;                 // к-сть кадрів float для обробки
+    bool auto_tune              = false;                                  // автопідбір глибини черги і буферів запису
+    std::size_t max_depth       = AUTO_TUNE_MAX_DEPTH;                    // межа глибини черги для автопідбору
+    std::uint64_t memory_budget = 0; // межа пам'яті кадрів і буферів запису для автопідбору, байт. 0 - без обмеження
+    std::size_t batch_size      = DEFAULT_PROCESS_BATCH;                  // кадри з черги, що перетворюються разом
+    std::uint32_t chunk_size    = DEFAULT_CONVERT_CHUNK_SIZE;             // частина кадру на одну задачу пулу, байт
+    std::shared_ptr<DataSourceWorkerPool> worker_pool;                    // пул перетворення, nullptr - спільний
+};
+
+/// \brief Лічильники черги. Відкидання політикою рахуються окремо від втрат по лічильнику кадрів.
+struct queue_stats
+{
+    std::uint64_t overruns       = 0; // кадри, що застали чергу заповненою
+    std::uint64_t dropped_newest = 0; // нові кадри, відкинуті політикою (DROP_NEWEST або заповнений резерв)
+    std::uint64_t dropped_oldest = 0; // необроблені кадри, витіснені новими (DROP_OLDEST)
+    std::uint64_t spilled        = 0; // кадри, що пройшли через резерв (SPILL)
+    std::uint64_t blocked        = 0; // очікування вільного слоту потоком читання (BLOCK)
+    std::uint64_t blocked_ns     = 0; // сумарний час очікування, нс
+    std::size_t spill_occupancy  = 0; // поточна к-сть кадрів в резерві
+    std::size_t depth            = 0; // поточна глибина черги
+    std::size_t max_depth        = 0; // межа глибини
+    std::uint64_t tune_steps     = 0; // к-сть збільшень глибини або буферів автопідбором
+    std::uint64_t memory_bytes   = 0; // пам'ять кадрів і буферів запису, байт
+};
 
 /// \brief Клас для валідації отриманого кадру з джерела даних.
 /// Робить перевірку і складання кадрів.
-/// Заповнює буфери масивів даних, розмірністю MxN. К-сть буферів BUFERIZATION_NUM,
-/// а вних к-сть кадрів MAX_PROCESSING_BUF_NUM.
+/// Кадри від потоку читання передаються в потік обробки через кільце без блокувань глибиною queue_config::depth,
+/// глибину і к-сть буферів запису може збільшувати автопідбір (queue_config::auto_tune).
+/// Пам'ять кадрів береться з вирівняних пулів, дескриптори лише переміщуються між потоками.
+/// Порожня черга не опитується: потік обробки спить на DataSourceEvent до нового кадру, потік читання
+/// в QUEUE_POLICY_BLOCK - до звільнення слоту.
+/// Потік обробки забирає з черги до queue_config::batch_size кадрів, перевіряє лічильники послідовно,
+/// а перетворення частин усіх кадрів розкладає по пулу потоків; в реєстратори кадри йдуть в порядку черги.
+/// Реєстратори джерел пишуть через спільний пул запису (recorder_config::writer_pool); реєстратор джерела без кадрів
+/// довше recorder_config::idle_seconds витісняється, нумерація сегментів джерела при поверненні продовжується.
+/// Якщо задано shared_ring_config::name_prefix, перетворені кадри кожного джерела ще й публікуються в кільце
+/// спільної пам'яті для інших процесів (DataSourceSharedRingReader); кільце витісняється разом з реєстратором.
+/// Власні етапи (ЦОС, експорт тощо) підписуються через addConsumer(): кожен отримує той же кадр float без копіювання
+/// у своєму потоці і своїй черзі, повільний споживач втрачає кадри сам, не гальмуючи обробку і решту споживачів.
 class DataSourceFrameProcessor
 {
 public:
     /// \brief Клас для роботи з отриманимим кадрами.
-    DataSourceFrameProcessor(const int & frame_size);
+    /// \param frame_size - розмір кадру
+    /// \param queue - глибина черги кадрів і політика переповнення
+    /// \param rec_config - налаштування реєстраторів
+    /// \param read_frames - к-сть кадрів, які потік читання тримає одночасно (пакетне читання)
+    /// \param shared_ring - кільця перетворених кадрів в спільній пам'яті
+    DataSourceFrameProcessor(
+        const int & frame_size,
+        const queue_config & queue = queue_config(),
+        const recorder_config & rec_config = recorder_config(),
+        const std::size_t & read_frames = 1,
+        const shared_ring_config & shared_ring = shared_ring_config());
     virtual ~DataSourceFrameProcessor();
 
     /// \brief Перевірка бракованих кадрів.
-    /// Конвертація в float.
+    /// Конвертація в float. Викликається з потоку обробки.
     /// \param buffer - дані з джерела
+    /// \param flt_buffer - кадр для відліків float
     /// \return - к-сть відліків float
-    int validateFrame(const std::shared_ptr<DataSourceBufferInterface> & buffer);
+    int validateFrame(DataSourceBufferInterface & buffer, DataSourceBufferInterface & flt_buffer);
     /// \brief Розмір кадру
     /// \return
     inline int frameSize() const { return m_frame_size; }
-    /// \brief К-сть втрачених пакетів, рахуються по лячильнику в заголовку кадру
+    /// \brief К-сть втрачених пакетів, рахуються по лячильнику в заголовку кадру.
+    /// Включає і кадри, відкинуті політикою черги (getPolicyDrops()), решта - втрати з боку джерела.
     /// \return
-    inline int getPacketsLoss() const { return m_packets_loss; }
+    inline int getPacketsLoss() const
+    {
+        return static_cast<int>(m_metrics.counter(METRIC_COUNTER::METRIC_COUNTER_PACKETS_LOSS));
+    }
     /// \brief Браковані кадри.
-    /// Рахуються по результату методу read, якщо розмір прочитаних даних менше бажаного.
+    /// Рахуються втрати синхронізації потоку (сміття між кадрами) і неповні кадри в putNewFrame().
     /// \return
-    inline int getBadFrames() const { return m_bad_frames; }
-    /// \brief К-сть кадрів з проблемами цілісності даних.
+    inline int getBadFrames() const
+    {
+        return static_cast<int>(m_metrics.counter(METRIC_COUNTER::METRIC_COUNTER_BAD_FRAMES));
+    }
+    /// \brief К-сть кадрів з проблемами цілісності даних: розмір не кратний типу даних або некоректний заголовок.
     /// \return
-    inline int getBrokenFrames() const { return m_stream_broken; }
-    /// \brief Функція записує вх. кадр в масив буферів кадрів.
-    /// \param frame
+    inline int getBrokenFrames() const
+    {
+        return static_cast<int>(m_metrics.counter(METRIC_COUNTER::METRIC_COUNTER_BROKEN_FRAMES));
+    }
+    /// \brief К-сть кадрів, що застали чергу заповненою (незалежно від того, як їх обробила політика).
+    /// \return
+    inline std::uint64_t getOverruns() const { return m_metrics.counter(METRIC_COUNTER::METRIC_COUNTER_OVERRUNS); }
+    /// \brief К-сть кадрів, відкинутих політикою черги (нових і витіснених старих).
+    /// \return
+    inline std::uint64_t getPolicyDrops() const
+    {
+        return m_metrics.counter(METRIC_COUNTER::METRIC_COUNTER_DROPPED_NEWEST)
+            + m_metrics.counter(METRIC_COUNTER::METRIC_COUNTER_DROPPED_OLDEST);
+    }
+    /// \brief Лічильники черги
+    /// \return
+    queue_stats queueStats() const;
+    /// \brief Політика переповнення черги
+    /// \return
+    inline QUEUE_POLICY queuePolicy() const { return m_queue_config.policy; }
+    /// \brief Поточна к-сть кадрів в черзі на обробку.
+    /// \return
+    inline std::size_t queueOccupancy() const { return m_source_ring.size(); }
+    /// \brief Поточна глибина черги на обробку.
+    /// \return
+    inline std::size_t queueDepth() const { return m_source_ring.limit(); }
+    /// \brief Пам'ять кадрів джерела, кадрів float і буферів запису, байт.
+    /// \return
+    std::uint64_t memoryUsage() const;
+    /// \brief Функція записує вх. кадр в чергу на обробку. Викликається з потоку читання.
+    /// Якщо черга заповнена, діє політика queue_config::policy; блокує лише QUEUE_POLICY_BLOCK.
+    /// \param frame - кадр з пулу acquireFrame(). Після постановки в чергу (або в резерв) стає порожнім,
+    /// якщо кадр відкинуто - лишається у викликаючого для повторного використання.
     /// \param updated_size
-    void putNewFrame(std::shared_ptr<DataSourceBufferInterface> & frame, int updated_size);
-    /// \brief Пройдений час на обробки вх. даних в потоці.
+    void putNewFrame(DataSourceFrameHandle & frame, int updated_size);
+    /// \brief Функція приймає довільну к-сть байт потоку з джерела (результат DataSource::read).
+    /// Кадри складаються з часткових читань по magic_word і передаються в putNewFrame().
+    /// Якщо прочитані дані починаються з повного кадру, він передається без копіювання.
+    /// \param frame - кадр з пулу, в який читали. Може стати порожнім, якщо пішов в чергу.
+    /// \param updated_size - к-сть прочитаних байт
+    void putNewData(DataSourceFrameHandle & frame, int updated_size);
+    /// \brief Те ж для даних, позичених джерелом (DataSource::acquire()).
+    /// Повні кадри на початку даних копіюються одразу в кадри пулу, решта - через накопичувач.
+    /// \param frame - вільний кадр з пулу, використовується першим. Може стати порожнім, якщо пішов в чергу.
+    /// \param data - дані джерела, після виклику не потрібні
+    /// \param size - к-сть байт
+    void putNewData(DataSourceFrameHandle & frame, const char * data, int size);
+    /// \brief Пакет кадрів з DataSource::readBatch() за один прохід.
+    /// \param frames - кадри з пулу, в які читали. Кадри, що пішли в чергу, стають порожніми.
+    /// \param sizes - результат readBatch(): к-сть прочитаних байт в кожен кадр
+    /// \param count - к-сть заповнених кадрів
+    void putNewBatch(DataSourceFrameHandle * frames, const read_vector * sizes, const int & count);
+    /// \brief Пройдений час на обробку останнього кадру в потоці.
     /// \return мілісекунди
     inline double validationElapsed() { return m_elapsed; }
     /// \brief Усереднений час запису оброблених даних в файл.
     /// \return мілісекунди
     double saveFrameElapsed();
+    /// \brief Розподіл затримок етапу обробки з моменту створення або resetLatency().
+    /// \param stage - етап
+    /// \return p50/p99/p99.9/max, нс
+    latency_snapshot latency(const LATENCY_STAGE & stage) const;
+    /// \brief Обнулення гістограм затримок усіх етапів.
+    void resetLatency();
+    /// \brief Метрики джерела: лічильники і значення оновлюються без блокувань, потік обробки публікує
+    /// узгоджений знімок раз на METRICS_PUBLISH_INTERVAL_MS і перед тим, як заснути без кадрів.
+    /// \return
+    inline const DataSourceMetrics & metrics() const { return m_metrics; }
+    /// \brief Останній опублікований знімок метрик, можна викликати з будь-якого потоку
+    /// \return
+    inline metrics_snapshot metricsSnapshot() const { return m_metrics.snapshot(); }
+    /// \brief Підписуємо споживача перетворених кадрів. Пул кадрів float доростає до float_pool_size плюс кадри,
+    /// які можуть тримати всі поточні споживачі (heldFrames()), в межах MAX_CONSUMER_FRAMES на всіх.
+    /// Пул не зменшується: кадри прибраних споживачів залишаються в резерві для наступних.
+    /// \param consumer - споживач
+    /// \param config - джерело, тип відліків джерела і глибина черги
+    /// \return ІД споживача, -1 - споживач не заданий
+    int addConsumer(const std::shared_ptr<DataSourceConsumer> & consumer, const consumer_config & config = {});
+    /// \brief Прибираємо споживача
+    /// \param id - ІД з addConsumer()
+    /// \return false, якщо споживача немає
+    inline bool removeConsumer(const int & id) { return m_consumers.remove(id); }
+    /// \brief Лічильники і затримки споживачів
+    /// \return
+    inline std::vector<consumer_stats> consumerStats() const { return m_consumers.stats(); }
 
 protected:
     /// \brief Потокова функція обробки вхідних буферів
     void frameProcess();
 
+    /// \brief magic_word останнього кадру, переданого на обробку
+    /// \return
+    inline std::uint32_t lastHeader() const { return m_last_header; }
+
+    /// \brief Лічильник останнього кадру, переданого на обробку
+    /// \return
+    inline std::uint16_t lastFrameCounter() const { return m_last_counter; }
+
+    /// \brief Вільний кадр для читання з джерела. Якщо пул вичерпано, кадр джерела не прочитано -
+    /// рахується як переповнення (METRIC_COUNTER_OVERRUNS).
+    /// \return порожній дескриптор, якщо всі кадри в черзі або в обробці
+    DataSourceFrameHandle acquireFrame();
+
+    /// \brief Метрики для оновлення з потоку читання
+    /// \return
+    inline DataSourceMetrics & mutableMetrics() { return m_metrics; }
+
+    /// \brief Додаємо вимір затримки етапу
+    /// \param stage - етап
+    /// \param elapsed_ns - затримка, нс
+    inline void recordLatency(const LATENCY_STAGE & stage, const std::int64_t & elapsed_ns)
+    {
+        m_latency[static_cast<int>(stage)].record(elapsed_ns);
+    }
+
 private:
+    /// \brief Постановка кадру в чергу згідно політики
+    /// \return false, якщо кадр відкинуто
+    bool enqueueFrame(DataSourceFrameHandle & frame);
+
+    /// \brief Переносимо кадри з резерву в чергу, скільки вміститься
+    void drainSpill();
+
+    /// \brief Видаємо повні кадри з накопичувача і оновлюємо лічильники браку
+    /// \param frame - вільний кадр з пулу, використовується першим
+    void drainDeframer(DataSourceFrameHandle & frame);
+
+    /// \brief Крок автопідбору за вікно спостереження. Викликається з потоку обробки.
+    /// Глибина черги росте так, щоб вмістити кадри, що надходять за найдовшу обробку кадру у вікні, з двократним
+    /// запасом, і на к-сть переповнень у вікні. Якщо обробка зайнята майже весь час, черга не росте:
+    /// глибина рятує від пікових затримок, а не від нестачі продуктивності.
+    /// Буфери запису додаються, якщо запис на диск (p99.9) довший за заповнення наявних буферів
+    /// або реєстратор відкидав відліки. Все в межах max_depth і memory_budget.
+    /// \param window_ns - тривалість вікна
+    /// \param frames - кадри, оброблені у вікні
+    /// \param busy_ns - сумарний час обробки кадрів у вікні
+    /// \param max_stall_ns - найдовша обробка кадру у вікні
+    void autoTune(
+        const std::int64_t & window_ns,
+        const std::uint64_t & frames,
+        const std::int64_t & busy_ns,
+        const std::int64_t & max_stall_ns);
+
+    /// \brief Перевірка лічильника і копіювання заголовку в кадр float, без перетворення відліків.
+    /// \return розмір даних для перетворення, байт
+    int validateHeader(DataSourceBufferInterface & buffer, DataSourceBufferInterface & flt_buffer);
+
+    /// \brief Передаємо перетворений кадр реєстратору його джерела, створюємо реєстратор для нового джерела.
+    void recordFrame(DataSourceBufferInterface & flt_frame,
+                     const int & total_elements,
+                     const PAYLOAD_TYPE & source_type);
+
+    /// \brief Публікуємо перетворений кадр в кільце спільної пам'яті його джерела, створюємо кільце для нового джерела.
+    void shareFrame(DataSourceBufferInterface & flt_frame,
+                    const int & total_elements,
+                    const PAYLOAD_TYPE & source_type);
+
+    /// \brief Передаємо пулу запису реєстратори без кадрів довше recorder_config::idle_seconds,
+    /// закриваємо кільця спільної пам'яті тих же джерел. Викликається з потоку обробки.
+    void evictIdleRecorders();
+
+    /// \brief Скільки байт ще можна виділити в межах memory_budget
+    std::uint64_t memoryAvailable() const;
+
+    /// \brief Оновлюємо значення і публікуємо знімок метрик. Викликається з потоку обробки.
+    void publishMetrics();
+
     int m_frame_size    = 0; // відомий розмір кадру
-    int m_packets_loss  = 0; // втрати пакетів на основі лфчильника кадрів
-    int m_stream_broken = 0; // потік даних не цілісний. Не вистачає байтів для даних.
-    int m_bad_frames    = 0; // поганий пакет на основі повернутого розміру кадру
 
-    double m_elapsed = 0;   // час обробки вх. даних, мс
+    // Лічильники втрат, черги, автопідбору і значення - кожен на своїй кеш-лінії
+    DataSourceMetrics m_metrics;
+
+    std::atomic<double> m_elapsed {0.}; // час обробки останнього кадру, мс
+
+    // Гістограми затримок по етапах. Оголошені до реєстраторів, які пишуть в LATENCY_STAGE_DISK_WRITE.
+    DataSourceLatencyHistogram m_latency[static_cast<int>(LATENCY_STAGE::LATENCY_STAGE_SIZE)];
 
-    mutable std::mutex m_process_mutex;
+    queue_config m_queue_config;
 
-    std::atomic<bool> m_can_validate;
-    std::atomic<int> m_req_size;
+    // --------------   Автопідбір (потік обробки)   --------------------
+    std::atomic<std::uint64_t> m_recorder_memory {0}; // пам'ять буферів запису всіх реєстраторів
+    std::uint64_t m_tune_overruns = 0;                 // METRIC_COUNTER_OVERRUNS на початок вікна
+    std::unordered_map<int, std::uint64_t> m_tune_dropped_samples; // відкинуті відліки реєстраторів на початок вікна
 
     std::thread m_process_thread;
     std::atomic<bool> m_is_process_active;
 
     std::atomic<int> m_cur_frm_counter {-1};
 
-    // --------------   Дані з джерела   --------------------
-    std::atomic<int> m_src_ready_buffer; // 0...MAX_PROCESSING_BUF_NUM-1
-    std::atomic<int> m_active_buffer;    // 0...BUFERIZATION_NUM-1
+    std::atomic<std::uint32_t> m_last_header {0};  // magic_word останнього кадру в черзі
+    std::atomic<std::uint16_t> m_last_counter {0}; // лічильник останнього кадру в черзі
 
-    // Два буфери - один наповнюємо з іншим працюємо. Потім навпаки
-    std::shared_ptr<DataSourceBufferInterface> m_source_buffer[BUFERIZATION_NUM]
-                                                              [MAX_PROCESSING_BUF_NUM]; // дані для swap з джерела
+    // --------------   Дані з джерела   --------------------
+    // Пул кадрів: слоти черги + кадри в потоці читання + пакет потоку обробки + резерв.
+    DataSourceFramePool m_source_pool;
+    // Черга кадрів: потік читання переміщує кадр в слот, потік обробки забирає найстаріший.
+    DataSourceRing<DataSourceFrameHandle> m_source_ring;
+    DataSourceEvent m_frame_event; // новий кадр в черзі: будить потік обробки
+    DataSourceEvent m_slot_event;  // звільнено слоти: будить потік читання в QUEUE_POLICY_BLOCK
+    // Резерв для QUEUE_POLICY_SPILL: кадри, що не вмістились в чергу, в порядку надходження (лише потік читання)
+    std::vector<DataSourceFrameHandle> m_spill;
+    std::size_t m_spill_head = 0;
+    std::atomic<std::size_t> m_spill_size {0};
+    // Складання кадрів з часткових читань (лише потік читання)
+    DataSourceDeframer m_deframer;
+    std::uint64_t m_deframer_resyncs = 0; // вже враховані в METRIC_COUNTER_BAD_FRAMES
+    std::uint64_t m_deframer_broken  = 0; // вже враховані в METRIC_COUNTER_BROKEN_FRAMES
 
     // --------------   Оброблені дані (float)   --------------------
-    std::atomic<int> m_flt_ready_buffer;                            // 0..MAX_PROCESSING_BUF_NUM-1
-    std::vector<std::shared_ptr<DataSourceBuffer<float>>> m_buffer; // дані будуть перетворені в float
+    DataSourceFramePool m_float_pool; // дані будуть перетворені в float
+
+    // Споживачі кадрів float. Оголошені після пулу: черги споживачів тримають його кадри.
+    DataSourceConsumerHub m_consumers;
+    std::uint64_t m_consumer_dropped = 0; // вже враховані в METRIC_COUNTER_CONSUMER_DROPPED
+
+    // Пул потоків перетворення, може бути спільним для кількох джерел
+    std::shared_ptr<DataSourceWorkerPool> m_workers;
 
     // Реєстратор відліків блоками відліків, к-сть яких є число степеня 2.
+    recorder_config m_recorder_config;
     std::unordered_map<int, std::shared_ptr<DataSourceFrameRecorder> > m_data_source_frame_recorders;
+    // Лічильники сегментів джерел, переживають витіснення реєстраторів
+    std::unordered_map<int, std::shared_ptr<std::atomic<std::uint32_t>>> m_segment_counters;
+
+    // Кільця перетворених кадрів для інших процесів, по одному на джерело (лише потік обробки)
+    shared_ring_config m_shared_ring_config;
+    std::unordered_map<int, std::unique_ptr<DataSourceSharedRingWriter>> m_shared_rings;
 };
 
 } // namespace DATA_SOURCE_TASK
@@ -1,75 +1,237 @@
 #ifndef DATASOURCEFRAMERECORDER_H
 #define DATASOURCEFRAMERECORDER_H
 
+#include "DataSourceAlignedAllocator.h"
 #include "DataSourceBuffer.h"
+#include "DataSourceCaptureFile.h"
+#include "DataSourceCodec.h"
+#include "DataSourceFlightRecorder.h"
+#include "DataSourceLatencyHistogram.h"
+#include "DataSourceRecordWriterPool.h"
+#include "DataSourceRing.h"
 
 #include <memory>
 #include <mutex>
 #include <atomic>
-#include <thread>
+#include <vector>
 
 namespace DATA_SOURCE_TASK
 {
-// К-сть буферів для обробки.
+// К-сть буферів запису за замовчуванням.
 static constexpr std::size_t MAX_REC_BUF_NUM {2};
 
 // К-сть блоків кратних степеню двійки для запису в файл.
 static constexpr std::size_t RECORD_SIZE {10};
 
+// Через скільки секунд без кадрів реєстратор джерела витісняється
+static constexpr std::uint32_t DEFAULT_RECORDER_IDLE_SECONDS {10};
+
+// Режим роботи реєстратора
+enum class RECORD_MODE : int
+{
+    RECORD_MODE_ARCHIVE = 0,             // повний архів в сегментних файлах
+    RECORD_MODE_FLIGHT_RING,             // тільки кільцевий файл останніх хвилин
+    RECORD_MODE_ARCHIVE_AND_FLIGHT_RING, // обидва
+};
+
+/// \brief Налаштування реєстратора
+struct recorder_config
+{
+    RECORD_MODE mode               = RECORD_MODE::RECORD_MODE_ARCHIVE;
+    std::uint64_t segment_size     = DEFAULT_SEGMENT_SIZE;     // максимальний розмір сегменту, байт
+    std::uint32_t segment_seconds  = 0;                        // максимальний вік сегменту, с. 0 - без обмеження
+    std::uint64_t flight_ring_size = DEFAULT_FLIGHT_RING_SIZE; // розмір кільцевого файлу, байт
+    std::string record_prefix      = "record_";                // шлях і початок імені файлів, далі ІД джерела
+    std::size_t buffer_count       = MAX_REC_BUF_NUM;          // к-сть буферів запису
+    std::size_t max_buffer_count   = 0;                        // межа росту через addBuffers(), 0 - buffer_count
+    RECORD_CODEC codec             = RECORD_CODEC::RECORD_CODEC_NONE;      // кодування блоків архіву
+    RECORD_FORMAT format           = RECORD_FORMAT::RECORD_FORMAT_FLOAT32; // формат відліків архіву
+    float int16_scale              = INT16_RECORD_SCALE;                   // множник RECORD_FORMAT_INT16
+    std::uint32_t idle_seconds     = DEFAULT_RECORDER_IDLE_SECONDS; // витіснення реєстратора без кадрів, 0 - ніколи
+    std::shared_ptr<DataSourceRecordWriterPool> writer_pool;       // потоки запису і бюджет пам'яті, nullptr - shared()
+};
+
 struct record_buffer
 {
     int id;
-    bool is_full                 = false; // готовність до запису в файл
-    std::uint32_t pos            = 0;     // поточна позиція запису в буфер
-    std::uint32_t available_size = 0;     // залишок елементів для перезапису
-    std::vector<float> record_buffer;     // масив елементів
+    std::uint32_t pos            = 0;   // поточна позиція запису в буфер, відліків
+    std::uint32_t available_size = 0;   // залишок відліків до заповнення
+    std::uint64_t first_frame    = 0;   // лічильник першого кадру в буфері без переповнення
+    std::uint64_t last_frame     = 0;   // лічильник останнього кадру
+    std::uint64_t first_ns       = 0;   // час надходження першого кадру (system_clock), нс
+    std::uint64_t last_ns        = 0;   // час надходження останнього кадру
+    std::uint32_t frame_offset   = 0;   // відліки на початку буфера - продовження кадру з попереднього буфера
+    std::uint8_t source_id       = 0;   // ІД джерела і тип відліків до перетворення - з першого кадру
+    PAYLOAD_TYPE payload_type    = PAYLOAD_TYPE::PAYLOAD_TYPE_32_BIT_IEEE_FLOAT;
+    std::vector<char, DataSourceAlignedAllocator<char>> record_buffer; // відліки формату запису, вирівняні для O_DIRECT
 };
 
 /// \brief Клас реалізовує функціонал складання і зберігання кадрів в файл.
 /// -	складати результати обробки перерозподілити у блоки,
 ///     кількість відліків сигналу у яких є найближчим степенем двійки;
+/// Заповнені блоки дописуються в кінець сегментних файлів <record_name>_<index>.bin без перевідкриття,
+/// сегменти змінюються по розміру або часу. Файли - контейнери DataSourceCaptureWriter: заголовок файлу,
+/// блоки з block_header (джерело, діапазон кадрів, час, к-сть відліків, кодування) і індекс в кінці.
+/// В режимі кільцевого файлу кожен кадр одразу копіюється у відображений файл <record_name>.ring.
+/// Власного потоку реєстратор не має: заповнений буфер передається в спільний пул потоків запису
+/// (recorder_config::writer_pool), пам'ять буферів резервується в бюджеті пулу.
+/// Буфери ходять між потоками через дві черги: вільні (потік запису -> putNewFrame)
+/// і заповнені (putNewFrame -> потік запису), тому їх к-сть можна збільшувати на ходу.
+/// З recorder_config::codec блоки стискаються в потоці запису, всі блоки вирівняні на DIRECT_IO_ALIGNMENT.
+/// Кільцевий файл завжди пишеться без кодування.
+/// З recorder_config::format відліки звужуються (float16, bfloat16, int16) в тому ж проході, що заповнює буфер;
+/// формат і множник зберігаються в заголовку блоку.
 class DataSourceFrameRecorder
 {
 public:
     /// \brief Конструктор класу
     /// \param record_name - базове ім'я файлу зберігання
-    /// \param block_size - к-сть елемнтів
-    DataSourceFrameRecorder(const std::string & record_name, const int & num_elements);
+    /// \param num_elements - к-сть відліків в кадрі
+    /// \param config - режим і параметри запису
+    /// \param write_latency - гістограма часу запису блоків в файл, може бути спільною для кількох реєстраторів
+    /// \param encode_latency - гістограма часу стиснення блоків, може бути спільною для кількох реєстраторів
+    /// \param segment_counter - спільний лічильник сегментів record_name: новий реєстратор того ж джерела
+    /// продовжує нумерацію, а не переписує сегменти попереднього. nullptr - нумерація з 0.
+    DataSourceFrameRecorder(
+        const std::string & record_name,
+        const int & num_elements,
+        const recorder_config & config = recorder_config(),
+        DataSourceLatencyHistogram * write_latency = nullptr,
+        DataSourceLatencyHistogram * encode_latency = nullptr,
+        const std::shared_ptr<std::atomic<std::uint32_t>> & segment_counter = nullptr);
     virtual ~DataSourceFrameRecorder();
 
+    DATA_SOURCE_NON_COPYABLE(DataSourceFrameRecorder)
+
+    /// \brief Дописуємо всі буфери, включно з неповним, і чекаємо пул запису.
+    /// Після виклику лічильники записаних байт остаточні. Викликається і з деструктора.
+    void stop();
+
+    /// \brief Передаємо неповний буфер в запис. Викликається з потоку, що викликає putNewFrame().
+    void flush();
+
+    /// \brief Час без нових кадрів. Викликається з потоку, що викликає putNewFrame().
+    /// \return мілісекунди
+    inline double idleMs() const { return m_idle_timer.elapsed(); }
+
     /// \brief К-сть відліків для запису, к-сть кратна степеню двійки.
     /// \return
     inline std::uint32_t bufferSize() const { return m_buffer_size; }
 
+    /// \brief Розмір буфера запису у форматі запису, байт
+    /// \return
+    inline std::uint64_t bufferBytes() const { return static_cast<std::uint64_t>(m_buffer_size) * m_sample_size; }
+
     /// \brief Заповнюємо буфери розміром до к-сті відліків степеня 2.
     /// Розмір вхідних даних менше ніж виділено під запис.
     /// \param buffer - оброблені дані float
     /// \param total_elements - к-сть відліків float
-    void putNewFrame(const std::shared_ptr<DataSourceBuffer<float>> & buffer, const int & total_elements);
+    /// \param source_type - тип відліків джерела до перетворення, для заголовків блоків
+    void putNewFrame(
+        const DataSourceBufferInterface & buffer,
+        const int & total_elements,
+        const PAYLOAD_TYPE & source_type = PAYLOAD_TYPE::PAYLOAD_TYPE_32_BIT_IEEE_FLOAT);
+
+    /// \brief Час запису в файл останнього блоку.
+    /// \return мілісекунди
+    double elapsed() const { return m_elapsed; }
+
+    /// \brief Додаємо буфери запису. Викликається з потоку, що викликає putNewFrame().
+    /// \param count - к-сть, обрізається до recorder_config::max_buffer_count і бюджету пам'яті пулу запису
+    /// \return к-сть доданих буферів
+    std::size_t addBuffers(const std::size_t & count);
 
-    /// \brief Замір часу на запис в файл.
+    /// \brief Поточна к-сть буферів запису
     /// \return
-    double elapsed() const { return m_elapsed; }
+    inline std::size_t bufferCount() const { return m_buffer_count; }
+
+    /// \brief Межа к-сті буферів запису
+    /// \return
+    inline std::size_t maxBufferCount() const { return m_max_buffer_count; }
+
+    /// \brief Пам'ять буферів запису і буферів кодування (два блоки), байт
+    /// \return
+    inline std::uint64_t memoryUsage() const
+    {
+        const std::size_t codec_buffers = m_codec.codec() != RECORD_CODEC::RECORD_CODEC_NONE ? 2 : 0;
 
-protected:
-    /// \brief Асинхронний запис в файл.
-    void recordBlock();
+        return (m_buffer_count + codec_buffers) * bufferBytes();
+    }
+
+    /// \brief К-сть відліків в кадрі
+    /// \return
+    inline int frameElements() const { return m_num_elements; }
+
+    /// \brief К-сть відліків, відкинутих через те, що всі буфери ще чекають запису.
+    /// \return
+    inline std::uint64_t droppedSamples() const { return m_dropped_samples; }
+
+    /// \brief Всього записано байт
+    /// \return
+    inline std::uint64_t bytesWritten() const { return m_bytes_written; }
+
+    /// \brief Всього байт відліків float до звуження і кодування. Відношення до bytesWritten() - ступінь стиснення.
+    /// \return
+    inline std::uint64_t rawBytesWritten() const { return m_raw_bytes_written; }
 
 private:
-    std::uint8_t m_active_buffer_index = 0;
+    friend class DataSourceRecordWriterPool;
+
+    /// \brief Записуємо в файл всі заповнені буфери. Викликається потоком пулу запису.
+    void writeReady();
+
+    /// \brief Новий буфер запису, пам'ять вже зарезервована. Викликається під m_buf_lock.
+    void appendBuffer();
+
+    /// \brief Віддаємо буфер в чергу запису. Викликається під m_buf_lock.
+    void pushReady(record_buffer * buf);
+
+    /// \brief Розкладаємо кадр по буферах. Викликається під m_buf_lock.
+    /// \return true, якщо є заповнені буфери для пулу запису
+    bool fillBuffers(
+        const DataSourceBufferInterface & frame,
+        const int & total_elements,
+        const PAYLOAD_TYPE & source_type);
+
+    record_buffer * m_active_buffer = nullptr; // буфер, який заповнюється
     std::uint32_t m_buffer_size        = 0;        // к-сть відліків степепня числа 2
+    int m_sample_size                  = FLOAT_SIZE; // розмір відліку у форматі запису, байт
+    int m_num_elements                 = 0;        // к-сть відліків в кадрі
     std::string m_record_name          = "record"; // ім'я файлу.
 
-    mutable std::atomic<bool> m_is_can_record_active; // Активатор потоку запису
-    std::thread m_record_to_file;
-    double m_elapsed = 0.;
+    std::shared_ptr<DataSourceRecordWriterPool> m_pool; // потоки запису і бюджет пам'яті
+    std::uint64_t m_reserved_bytes = 0;                // зарезервовано в бюджеті пулу
+
+    Timer m_idle_timer; // з останнього кадру
+    std::atomic<double> m_elapsed {0.};
+
+    DataSourceLatencyHistogram * m_write_latency  = nullptr; // час запису блоків, не володіємо
+    DataSourceLatencyHistogram * m_encode_latency = nullptr; // час стиснення блоків, не володіємо
+
+    std::atomic<std::uint64_t> m_dropped_samples {0};
+    std::atomic<std::uint64_t> m_bytes_written {0};
+    std::atomic<std::uint64_t> m_raw_bytes_written {0};
 
     std::mutex m_buf_lock;
-    std::atomic<bool> m_need_record;
 
-    struct record_buffer m_frame_record[MAX_REC_BUF_NUM]; // масиви для заповнення float відліками даних.
+    // масиви для заповнення float відліками даних. Змінюється лише в addBuffers().
+    std::vector<std::unique_ptr<record_buffer>> m_frame_record;
+    std::atomic<std::size_t> m_buffer_count {0};
+    std::size_t m_max_buffer_count = 0;
+
+    DataSourceRing<record_buffer *> m_free_buffers;  // вільні буфери: потік запису -> putNewFrame
+    DataSourceRing<record_buffer *> m_ready_buffers; // заповнені буфери по черзі: putNewFrame -> потік запису
+    std::vector<record_buffer *> m_spare_buffers;    // нові буфери з addBuffers(), ще не бували в черзі вільних
+
+    recorder_config m_config;
+
+    DataSourceCaptureWriter m_writer; // запис в сегментні файли-контейнери
+    DataSourceBlockCodec m_codec;     // стиснення блоків (лише потік запису)
+
+    std::uint64_t m_frame = 0; // лічильник поточного кадру без переповнення
+    bool m_is_first_frame = true;
 
-    std::vector<float> m_record_buffer; // дані для запису в файл.
+    std::unique_ptr<DataSourceFlightRecorder> m_flight_recorder; // кільцевий файл останніх хвилин
 };
 
 } // namespace DATA_SOURCE_TASK
@@ -0,0 +1,94 @@
+#ifndef DATASOURCELATENCYHISTOGRAM_H
+#define DATASOURCELATENCYHISTOGRAM_H
+
+#include "globals.h"
+
+namespace DATA_SOURCE_TASK
+{
+
+// Піддіапазонів на кожну степінь двійки: похибка значення не більше 1/32 (~3%).
+static constexpr unsigned LATENCY_SUB_BUCKET_BITS {5};
+static constexpr std::size_t LATENCY_SUB_BUCKETS {std::size_t(1) << LATENCY_SUB_BUCKET_BITS};
+// Кошики покривають весь діапазон std::uint64_t
+static constexpr std::size_t LATENCY_BUCKETS {(64 - LATENCY_SUB_BUCKET_BITS + 1) * LATENCY_SUB_BUCKETS};
+
+// Етапи обробки кадру, для яких ведеться гістограма затримок
+enum class LATENCY_STAGE : int
+{
+    LATENCY_STAGE_READ = 0,       // читання з джерела
+    LATENCY_STAGE_DEFRAME,        // складання кадрів і постановка в чергу
+    LATENCY_STAGE_CONVERT,        // перевірка і перетворення в float
+    LATENCY_STAGE_RECORD_ENQUEUE, // передача кадру реєстратору
+    LATENCY_STAGE_SHARED_PUBLISH, // копіювання кадру в кільце спільної пам'яті
+    LATENCY_STAGE_ENCODE,         // стиснення блоку перед записом
+    LATENCY_STAGE_DISK_WRITE,     // запис блоку в файл
+    LATENCY_STAGE_SIZE
+};
+
+/// \brief Назва етапу
+/// \param stage
+/// \return
+const char * latencyStageName(const LATENCY_STAGE & stage);
+
+/// \brief Знімок гістограми, нс
+struct latency_snapshot
+{
+    std::uint64_t count = 0;
+    std::int64_t min_ns  = 0;
+    std::int64_t mean_ns = 0;
+    std::int64_t p50_ns  = 0;
+    std::int64_t p90_ns  = 0;
+    std::int64_t p99_ns  = 0;
+    std::int64_t p999_ns = 0;
+    std::int64_t max_ns  = 0;
+};
+
+/// \brief Гістограма затримок в стилі HDR: лог-лінійні кошики (степінь двійки x LATENCY_SUB_BUCKETS).
+/// record() - кілька атомарних інкрементів без блокувань, можна викликати з кількох потоків.
+/// Перцентилі рахуються в snapshot() з відносною похибкою до 1/LATENCY_SUB_BUCKETS.
+class DataSourceLatencyHistogram
+{
+public:
+    DataSourceLatencyHistogram();
+
+    DATA_SOURCE_NON_COPYABLE(DataSourceLatencyHistogram)
+
+    /// \brief Додаємо вимір
+    /// \param value_ns - затримка, нс. Від'ємні значення рахуються як 0.
+    void record(std::int64_t value_ns);
+
+    /// \brief Знімок: к-сть, min/mean/max і перцентилі p50/p90/p99/p99.9.
+    /// Під час запису з інших потоків знімок може не включати останні виміри.
+    /// \return
+    latency_snapshot snapshot() const;
+
+    /// \brief Значення перцентиля
+    /// \param percentile - від 0 до 100
+    /// \return нс, 0 якщо вимірів немає
+    std::int64_t percentile(const double & percentile) const;
+
+    /// \brief Обнулення. Виміри, що пишуться одночасно з reset(), можуть частково залишитись.
+    void reset();
+
+    /// \brief Номер кошика для значення
+    /// \param value
+    /// \return
+    static std::size_t bucketIndex(const std::uint64_t & value);
+
+    /// \brief Найбільше значення, що потрапляє в кошик
+    /// \param index
+    /// \return
+    static std::uint64_t bucketUpperBound(const std::size_t & index);
+
+private:
+    std::int64_t percentile(const std::uint64_t * counts, const std::uint64_t & total, const double & percentile) const;
+
+    std::atomic<std::uint64_t> m_counts[LATENCY_BUCKETS];
+    std::atomic<std::uint64_t> m_sum_ns {0};
+    std::atomic<std::int64_t> m_min_ns {std::numeric_limits<std::int64_t>::max()};
+    std::atomic<std::int64_t> m_max_ns {0};
+};
+
+} // namespace DATA_SOURCE_TASK
+
+#endif // DATASOURCELATENCYHISTOGRAM_H
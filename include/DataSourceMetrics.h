@@ -0,0 +1,140 @@
+#ifndef DATASOURCEMETRICS_H
+#define DATASOURCEMETRICS_H
+
+#include "DataSourceLatencyHistogram.h"
+#include "DataSourceRing.h"
+#include "globals.h"
+
+#include <atomic>
+
+namespace DATA_SOURCE_TASK
+{
+
+// Період публікації знімка метрик потоком обробки
+static constexpr int METRICS_PUBLISH_INTERVAL_MS {100};
+
+// Лічильники джерела, лише ростуть
+enum class METRIC_COUNTER : int
+{
+    METRIC_COUNTER_FRAMES = 0,      // оброблені кадри
+    METRIC_COUNTER_BYTES,           // байти навантаження оброблених кадрів
+    METRIC_COUNTER_PACKETS_LOSS,    // втрачені кадри за лічильником в заголовку
+    METRIC_COUNTER_BAD_FRAMES,      // втрати синхронізації і неповні кадри
+    METRIC_COUNTER_BROKEN_FRAMES,   // некоректний заголовок або розмір не кратний типу
+    METRIC_COUNTER_OVERRUNS,        // кадри, що застали чергу заповненою
+    METRIC_COUNTER_DROPPED_NEWEST,  // відкинуті нові кадри
+    METRIC_COUNTER_DROPPED_OLDEST,  // витіснені старі кадри
+    METRIC_COUNTER_SPILLED,         // кадри через резерв
+    METRIC_COUNTER_BLOCKED,         // очікування вільного слоту
+    METRIC_COUNTER_BLOCKED_NS,      // час очікування вільного слоту, нс
+    METRIC_COUNTER_TUNE_STEPS,      // кроки автопідбору
+    METRIC_COUNTER_RECORDERS_EVICTED, // витіснені реєстратори
+    METRIC_COUNTER_CONSUMER_DROPPED,  // кадри, що застали чергу споживача заповненою
+    METRIC_COUNTER_SIZE
+};
+
+// Поточні значення джерела
+enum class METRIC_GAUGE : int
+{
+    METRIC_GAUGE_QUEUE_OCCUPANCY = 0, // кадрів в черзі на обробку
+    METRIC_GAUGE_QUEUE_DEPTH,         // робоча глибина черги
+    METRIC_GAUGE_MEMORY_BYTES,        // пам'ять кадрів і буферів запису, байт
+    METRIC_GAUGE_RECORDERS,           // активні реєстратори
+    METRIC_GAUGE_CONSUMERS,           // підписані споживачі
+    METRIC_GAUGE_PROCESS_NS,          // обробка кадру в останньому пакеті, нс
+    METRIC_GAUGE_READ_NS,             // останній такт читання, нс
+    METRIC_GAUGE_SIZE
+};
+
+/// \brief Назва лічильника для експорту
+/// \param counter
+/// \return
+const char * metricCounterName(const METRIC_COUNTER & counter);
+
+/// \brief Назва значення для експорту
+/// \param gauge
+/// \return
+const char * metricGaugeName(const METRIC_GAUGE & gauge);
+
+/// \brief Узгоджений знімок метрик джерела: всі значення з однієї публікації
+struct metrics_snapshot
+{
+    std::uint64_t sequence = 0; // номер публікації, 0 - ще не публікувались
+    std::int64_t time_ns   = 0; // час публікації, system_clock, нс
+    std::uint64_t counters[static_cast<int>(METRIC_COUNTER::METRIC_COUNTER_SIZE)] = {};
+    std::int64_t gauges[static_cast<int>(METRIC_GAUGE::METRIC_GAUGE_SIZE)]        = {};
+    latency_snapshot latency[static_cast<int>(LATENCY_STAGE::LATENCY_STAGE_SIZE)];
+
+    inline std::uint64_t counter(const METRIC_COUNTER & c) const { return counters[static_cast<int>(c)]; }
+    inline std::int64_t gauge(const METRIC_GAUGE & g) const { return gauges[static_cast<int>(g)]; }
+};
+
+/// \brief Блок метрик джерела.
+/// Лічильники і значення - атомарні, кожен на окремій кеш-лінії: потоки читання і обробки оновлюють їх
+/// без блокувань і без хибного поділу ліній. add()/setGauge() можна викликати з будь-якого потоку.
+/// Один потік (потік обробки) періодично публікує знімок через seqlock: номер публікації непарний під час
+/// копіювання і парний після. snapshot() перечитує, доки не отримає цілу публікацію, тож читач бачить узгоджені
+/// значення і ніколи не блокує публікацію.
+class DataSourceMetrics
+{
+public:
+    DataSourceMetrics();
+
+    DATA_SOURCE_NON_COPYABLE(DataSourceMetrics)
+
+    /// \brief Додаємо до лічильника
+    inline void add(const METRIC_COUNTER & counter, const std::uint64_t & value = 1)
+    {
+        m_counters[static_cast<int>(counter)].value.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    /// \brief Поточне значення лічильника (між публікаціями)
+    inline std::uint64_t counter(const METRIC_COUNTER & counter) const
+    {
+        return m_counters[static_cast<int>(counter)].value.load(std::memory_order_relaxed);
+    }
+
+    /// \brief Оновлюємо значення
+    inline void setGauge(const METRIC_GAUGE & gauge, const std::int64_t & value)
+    {
+        m_gauges[static_cast<int>(gauge)].value.store(static_cast<std::uint64_t>(value), std::memory_order_relaxed);
+    }
+
+    /// \brief Поточне значення (між публікаціями)
+    inline std::int64_t gauge(const METRIC_GAUGE & gauge) const
+    {
+        return static_cast<std::int64_t>(m_gauges[static_cast<int>(gauge)].value.load(std::memory_order_relaxed));
+    }
+
+    /// \brief Публікуємо знімок поточних лічильників і значень. Викликається лише з одного потоку.
+    /// \param latency - знімки гістограм затримок усіх етапів (LATENCY_STAGE_SIZE), nullptr - без затримок
+    void publish(const latency_snapshot * latency);
+
+    /// \brief Останній опублікований знімок. Можна викликати з будь-якого потоку.
+    /// \return
+    metrics_snapshot snapshot() const;
+
+private:
+    struct metric_cell
+    {
+        std::atomic<std::uint64_t> value {0};
+        char pad[CACHE_LINE_SIZE - sizeof(std::atomic<std::uint64_t>)];
+    };
+
+    // знімок зберігається словами, щоб читання під час публікації не було гонитвою даних
+    static constexpr std::size_t SNAPSHOT_WORDS {(sizeof(metrics_snapshot) + sizeof(std::uint64_t) - 1)
+                                                 / sizeof(std::uint64_t)};
+
+    metric_cell m_counters[static_cast<int>(METRIC_COUNTER::METRIC_COUNTER_SIZE)];
+    metric_cell m_gauges[static_cast<int>(METRIC_GAUGE::METRIC_GAUGE_SIZE)];
+
+    // seqlock: непарний - публікація триває
+    std::atomic<std::uint64_t> m_sequence {0};
+    char m_sequence_pad[CACHE_LINE_SIZE - sizeof(std::atomic<std::uint64_t>)];
+
+    std::atomic<std::uint64_t> m_snapshot[SNAPSHOT_WORDS];
+};
+
+} // namespace DATA_SOURCE_TASK
+
+#endif // DATASOURCEMETRICS_H
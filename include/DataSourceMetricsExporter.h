@@ -0,0 +1,92 @@
+#ifndef DATASOURCEMETRICSEXPORTER_H
+#define DATASOURCEMETRICSEXPORTER_H
+
+#include "DataSourceMetrics.h"
+#include "globals.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace DATA_SOURCE_TASK
+{
+
+// Період запису файлу метрик за замовчуванням
+static constexpr int DEFAULT_METRICS_EXPORT_INTERVAL_MS {1000};
+
+/// \brief Налаштування експорту метрик
+struct exporter_config
+{
+    std::string file_path;   // файл для textfile collector, "" - без файлу
+    std::string socket_path; // локальний сокет (AF_UNIX, відповідь HTTP), "" - без сокета. Не для Windows.
+    int interval_ms = DEFAULT_METRICS_EXPORT_INTERVAL_MS; // період запису файлу
+};
+
+/// \brief Експорт метрик джерел в текстовому форматі Prometheus.
+/// Власний потік раз на interval_ms бере знімки (DataSourceMetrics::snapshot()) всіх доданих джерел і
+/// переписує файл (через тимчасовий і перейменування, тож збирач не бачить половину файлу), а на кожне
+/// з'єднання з локальним сокетом відповідає тим же текстом. Потоки обробки при цьому нічого не чекають.
+class DataSourceMetricsExporter
+{
+public:
+    /// \brief Конструктор
+    /// \param config - куди і як часто експортувати
+    explicit DataSourceMetricsExporter(const exporter_config & config);
+
+    DATA_SOURCE_NON_COPYABLE(DataSourceMetricsExporter)
+
+    ~DataSourceMetricsExporter();
+
+    /// \brief Додаємо джерело
+    /// \param source - мітка source в експорті
+    /// \param metrics - метрики джерела, живуть до remove() або знищення експортера
+    void add(const std::string & source, const DataSourceMetrics * metrics);
+
+    /// \brief Прибираємо джерело
+    /// \param metrics
+    void remove(const DataSourceMetrics * metrics);
+
+    /// \brief Поточний текст експорту
+    /// \return
+    std::string text() const;
+
+    /// \brief Текстовий формат Prometheus для знімків джерел
+    /// \param sources - мітка source і знімок
+    /// \return
+    static std::string format(const std::vector<std::pair<std::string, metrics_snapshot>> & sources);
+
+    /// \brief Чи слухаємо локальний сокет
+    /// \return
+    inline bool isServing() const { return m_socket >= 0; }
+
+private:
+    /// \brief Потік експорту
+    void exportLoop();
+
+    /// \brief Переписуємо файл метрик
+    void writeFile(const std::string & text) const;
+
+    /// \brief Відкриваємо локальний сокет
+    void openSocket();
+
+    /// \brief Відповідаємо одному клієнту сокета
+    void serveClient();
+
+    const exporter_config m_config;
+
+    mutable std::mutex m_lock;
+    std::condition_variable m_wake;
+    std::vector<std::pair<std::string, const DataSourceMetrics *>> m_sources;
+    bool m_is_active = true;
+
+    int m_socket = -1;
+
+    std::thread m_thread;
+};
+
+} // namespace DATA_SOURCE_TASK
+
+#endif // DATASOURCEMETRICSEXPORTER_H
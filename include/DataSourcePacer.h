@@ -0,0 +1,80 @@
+#ifndef DATASOURCEPACER_H
+#define DATASOURCEPACER_H
+
+#include "globals.h"
+
+namespace DATA_SOURCE_TASK
+{
+
+// Період читання 200 Гц, нс
+static constexpr std::int64_t DEFAULT_PACER_PERIOD_NS {static_cast<std::int64_t>(MAX_FREQ_READ * 1000000.)};
+
+// Що робити з тактами, пропущеними через затримку в обробці
+enum class PACER_CATCH_UP : int
+{
+    PACER_CATCH_UP_BURST = 0, // пропущені такти відпрацьовуються підряд без паузи
+    PACER_CATCH_UP_SKIP,      // пропущені такти відкидаються, фаза розкладу зберігається
+    PACER_CATCH_UP_RESET,     // розклад починається заново від поточного моменту
+};
+
+/// \brief Налаштування темпу читання
+struct pacer_config
+{
+    std::int64_t period_ns   = DEFAULT_PACER_PERIOD_NS;               // період, нс. 0 - без пауз
+    std::int64_t spin_ns     = 0;                                     // активне очікування в кінці такту, нс
+    PACER_CATCH_UP catch_up  = PACER_CATCH_UP::PACER_CATCH_UP_SKIP;   // поведінка після перевищення такту
+    int batch_frames         = 1; // кадрів за такт: > 1 - один DataSource::readBatch() на такт
+};
+
+/// \brief Статистика темпу
+struct pacer_stats
+{
+    std::uint64_t ticks          = 0; // к-сть тактів
+    std::uint64_t overruns       = 0; // такти, на початок яких вже запізнились
+    std::uint64_t missed_ticks   = 0; // такти, відкинуті політикою SKIP/RESET
+    std::int64_t last_jitter_ns  = 0; // запізнення пробудження відносно дедлайну в останньому такті
+    std::int64_t max_jitter_ns   = 0; // максимальне запізнення пробудження
+    std::int64_t mean_jitter_ns  = 0; // середнє запізнення пробудження
+};
+
+/// \brief Темп циклу за абсолютними дедлайнами на монотонному годиннику.
+/// Потік спить до дедлайну (clock_nanosleep з TIMER_ABSTIME), за бажанням останні spin_ns чекає активно.
+/// Дедлайни рахуються від початку розкладу, тому похибка не накопичується.
+/// wait() викликається з одного потоку, статистику можна читати з будь-якого.
+class DataSourcePacer
+{
+public:
+    explicit DataSourcePacer(const pacer_config & config = pacer_config());
+
+    DATA_SOURCE_NON_COPYABLE(DataSourcePacer)
+
+    /// \brief Початок розкладу: перший дедлайн через період від поточного моменту
+    void start();
+
+    /// \brief Чекаємо наступний дедлайн
+    void wait();
+
+    /// \brief Знімок статистики
+    /// \return
+    pacer_stats stats() const;
+
+    /// \brief Налаштування
+    /// \return
+    inline const pacer_config & config() const { return m_config; }
+
+private:
+    const pacer_config m_config;
+
+    std::int64_t m_deadline_ns = 0; // наступний дедлайн на монотонному годиннику
+
+    std::atomic<std::uint64_t> m_ticks {0};
+    std::atomic<std::uint64_t> m_overruns {0};
+    std::atomic<std::uint64_t> m_missed_ticks {0};
+    std::atomic<std::int64_t> m_last_jitter_ns {0};
+    std::atomic<std::int64_t> m_max_jitter_ns {0};
+    std::atomic<std::int64_t> m_sum_jitter_ns {0};
+};
+
+} // namespace DATA_SOURCE_TASK
+
+#endif // DATASOURCEPACER_H
@@ -0,0 +1,124 @@
+#ifndef DATASOURCERECORDWRITERPOOL_H
+#define DATASOURCERECORDWRITERPOOL_H
+
+#include "globals.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DATA_SOURCE_TASK
+{
+
+class DataSourceFrameRecorder;
+
+// К-сть потоків запису спільного пулу: по одному на пристрій зберігання
+static constexpr std::size_t DEFAULT_RECORD_WRITER_THREADS {2};
+
+// Межа пам'яті буферів запису всіх реєстраторів спільного пулу, 1 ГБ
+static constexpr std::uint64_t DEFAULT_RECORD_MEMORY_BUDGET {1024ull * 1024ull * 1024ull};
+
+/// \brief Спільний пул потоків запису реєстраторів.
+/// Реєстратор ставить себе в чергу, коли має заповнені буфери (submit()), потік пулу записує всі його готові
+/// буфери. Кожен реєстратор в черзі не більше одного разу і обробляється одним потоком за раз, тож блоки одного
+/// джерела пишуться по порядку, а різних - паралельно. К-сть потоків задається під пристрої зберігання і не
+/// залежить від к-сті джерел.
+/// Пам'ять буферів запису всіх реєстраторів пулу обмежена спільним бюджетом (reserve()/release()).
+/// Витіснені реєстратори передаються в retire(): пул дописує їх буфери і знищує у своєму потоці.
+class DataSourceRecordWriterPool
+{
+public:
+    /// \brief Конструктор
+    /// \param threads - к-сть потоків запису, не менше 1
+    /// \param memory_budget - межа пам'яті буферів запису, байт. 0 - без обмеження.
+    explicit DataSourceRecordWriterPool(
+        const std::size_t & threads = DEFAULT_RECORD_WRITER_THREADS,
+        const std::uint64_t & memory_budget = DEFAULT_RECORD_MEMORY_BUDGET);
+
+    DATA_SOURCE_NON_COPYABLE(DataSourceRecordWriterPool)
+
+    ~DataSourceRecordWriterPool();
+
+    /// \brief Спільний пул процесу: DEFAULT_RECORD_WRITER_THREADS потоків, DEFAULT_RECORD_MEMORY_BUDGET
+    /// \return
+    static std::shared_ptr<DataSourceRecordWriterPool> shared();
+
+    /// \brief Реєстратор має заповнені буфери. Якщо його зараз пишуть - буде записаний ще раз після цього.
+    /// \param recorder - реєстратор, живе до wait() або retire()
+    void submit(DataSourceFrameRecorder * recorder);
+
+    /// \brief Чекаємо, доки реєстратор не буде в черзі і жоден потік його не пише
+    /// \param recorder - реєстратор
+    void wait(DataSourceFrameRecorder * recorder);
+
+    /// \brief Передаємо реєстратор пулу: незаписані буфери дописуються, реєстратор знищується в потоці пулу.
+    /// \param recorder - реєстратор, в якого більше немає інших власників
+    void retire(std::shared_ptr<DataSourceFrameRecorder> recorder);
+
+    /// \brief Чекаємо знищення всіх витіснених реєстраторів.
+    /// Власник пулу викликає перед тим, як відпустити пул: останнє посилання на пул не повинне зникнути
+    /// в потоці самого пулу разом з реєстратором.
+    void waitRetired();
+
+    /// \brief Резервуємо пам'ять під буфери в межах бюджету
+    /// \param bytes - розмір одного буфера, байт
+    /// \param count - бажана к-сть буферів
+    /// \return к-сть буферів, для яких зарезервовано пам'ять
+    std::size_t reserve(const std::uint64_t & bytes, const std::size_t & count);
+
+    /// \brief Резервуємо пам'ять без перевірки бюджету (мінімум, без якого реєстратор не працює)
+    /// \param bytes - розмір, байт
+    void reserveForced(const std::uint64_t & bytes);
+
+    /// \brief Повертаємо пам'ять в бюджет
+    /// \param bytes - розмір, байт
+    void release(const std::uint64_t & bytes);
+
+    /// \brief К-сть потоків запису
+    /// \return
+    inline std::size_t threads() const { return m_threads.size(); }
+
+    /// \brief Межа пам'яті буферів, байт. 0 - без обмеження.
+    /// \return
+    inline std::uint64_t memoryBudget() const { return m_memory_budget; }
+
+    /// \brief Зарезервована пам'ять буферів, байт
+    /// \return
+    inline std::uint64_t memoryUsed() const { return m_memory_used; }
+
+    /// \brief К-сть реєстраторів, переданих в retire() і ще не знищених
+    /// \return
+    std::size_t retiredCount() const;
+
+private:
+    /// \brief Потік запису
+    void writerLoop();
+
+    /// \brief Чи реєстратор в черзі або його пишуть. Викликається під m_lock.
+    bool isBusy(const DataSourceFrameRecorder * recorder) const;
+
+    const std::uint64_t m_memory_budget = 0;
+    std::atomic<std::uint64_t> m_memory_used {0};
+
+    mutable std::mutex m_lock;
+    std::condition_variable m_wake; // є робота для потоків запису
+    std::condition_variable m_done; // реєстратор записано
+
+    std::deque<DataSourceFrameRecorder *> m_queue;
+    std::vector<DataSourceFrameRecorder *> m_running;  // реєстратори, які зараз пишуться
+    std::vector<DataSourceFrameRecorder *> m_rerun;    // отримали submit() під час запису
+    std::vector<std::shared_ptr<DataSourceFrameRecorder>> m_retired;
+    std::size_t m_destroying = 0; // витіснені реєстратори, які зараз знищуються
+
+    bool m_is_active = true;
+
+    std::vector<std::thread> m_threads;
+};
+
+} // namespace DATA_SOURCE_TASK
+
+#endif // DATASOURCERECORDWRITERPOOL_H
@@ -0,0 +1,137 @@
+#ifndef DATASOURCEREPLAY_H
+#define DATASOURCEREPLAY_H
+
+#include "DataSource.h"
+#include "DataSourceCaptureFile.h"
+#include "DataSourceFile.h"
+#include "DataSourcePacer.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace DATA_SOURCE_TASK
+{
+
+/// \brief Налаштування відтворення
+struct replay_config
+{
+    double speed      = 1.;                 // 1 - темп запису, N - в N разів швидше, 0 - якнайшвидше
+    bool is_looped    = false;              // після кінця запису починаємо спочатку
+    double frame_rate = FRAME_RATE_PER_SEC; // темп сирих записів кадрів (в них немає часу), Гц
+};
+
+/// \brief Джерело, що відтворює записи через DataSourceController.
+/// Читає файли-контейнери реєстратора (DataSourceCaptureReader) або сирі записи потоку кадрів
+/// (кадри з заголовками підряд, як видає джерело; відображаються в пам'ять через DataSourceFile).
+/// Відліки контейнерів повертаються до типу джерела з заголовку файлу (8/16 bit - без втрат), кадри отримують
+/// лічильники від першого записаного кадру. Кадр видається через позичений буфер (acquire/commit) без копіювання.
+/// Темп задає саме джерело за часом надходження кадрів з блоків запису (сирі записи - replay_config::frame_rate),
+/// тому контролер створюється з pacing(): без власних пауз 200 Гц.
+/// Після кінця запису acquire() видає 0 байт, isFinished() - true.
+class DataSourceReplay final : public DataSource
+{
+public:
+    /// \brief Конструктор
+    /// \param files - файли для відтворення по черзі: сегменти контейнерів або сирі записи кадрів
+    /// \param config - швидкість і повтор
+    explicit DataSourceReplay(const std::vector<std::string> & files, const replay_config & config = replay_config());
+
+    virtual ~DataSourceReplay();
+
+    /// \brief Сегменти запису реєстратора <record_name>_NNNNNN.bin, що існують, по порядку
+    /// \param record_name - базове ім'я запису (recorder_config::record_prefix + ІД джерела)
+    /// \return
+    static std::vector<std::string> captureSegments(const std::string & record_name);
+
+    /// \brief Темп контролера для відтворення: без пауз, решта налаштувань зберігається
+    /// \param pacing - налаштування темпу
+    /// \return
+    static pacer_config pacing(const pacer_config & pacing = pacer_config());
+
+    /// \brief Сумісність: копія позиченої порції acquire()
+    int read(char * data, int size) override;
+
+    /// \brief Позичаємо залишок поточного кадру, не більше size байт. buffer не використовується.
+    /// Наступний кадр видається не раніше свого часу з урахуванням replay_config::speed.
+    read_block acquire(char * buffer, int size) override;
+
+    /// \brief Пересуваємо позицію в кадрі на consumed байт
+    void commit(const read_block & block, int consumed) override;
+
+    /// \brief Найбільший розмір кадру з заголовком, байт - розмір кадру для DataSourceController
+    /// \return 0, якщо жоден файл не вдалось прочитати
+    inline int frameSize() const { return m_frame_size; }
+
+    /// \brief Чи відтворено весь запис
+    /// \return
+    inline bool isFinished() const { return m_is_finished; }
+
+    /// \brief К-сть виданих кадрів
+    /// \return
+    inline std::uint64_t framesReplayed() const { return m_frames; }
+
+    /// \brief К-сть виданих байт
+    /// \return
+    inline std::uint64_t bytesReplayed() const { return m_bytes; }
+
+private:
+    /// \brief Готуємо наступний кадр і чекаємо його часу. Викликається під m_read_lock.
+    bool nextFrame();
+
+    /// \brief Кадр з відліків контейнера
+    bool nextCaptureFrame(std::uint64_t & time_ns);
+
+    /// \brief Кадр з сирого запису
+    bool nextRawFrame(std::uint64_t & time_ns);
+
+    /// \brief Наступний блок контейнера, за потреби - наступний файл
+    bool nextBlock();
+
+    /// \brief Відкриваємо файл m_file_index
+    bool openFile();
+
+    /// \brief Чекаємо часу кадру
+    void waitDue(const std::uint64_t & time_ns);
+
+    const replay_config m_config;
+    const std::vector<std::string> m_files;
+
+    std::mutex m_read_lock;
+
+    std::size_t m_file_index = 0;
+    int m_frame_size         = 0;
+
+    // поточний контейнер
+    std::unique_ptr<DataSourceCaptureReader> m_reader;
+    std::size_t m_block_index = 0;
+    block_header m_block;
+    std::vector<float> m_samples; // декодований блок
+    std::size_t m_sample_pos = 0;
+
+    // поточний сирий запис
+    std::unique_ptr<DataSourceFile> m_raw;
+
+    // кадр, зібраний з відліків контейнера
+    std::vector<char> m_frame_buffer;
+    std::uint64_t m_frame_index = 0; // лічильник кадру без переповнення
+
+    // кадр, що видається: зібраний або прямо у відображенні сирого запису
+    const char * m_frame = nullptr;
+    int m_frame_bytes    = 0;
+    int m_frame_pos      = 0;
+
+    // відповідність часу запису і монотонного годинника
+    bool m_is_timed            = false;
+    std::uint64_t m_start_time = 0; // час першого кадру розкладу в записі, нс
+    std::int64_t m_start_ns    = 0; // steady_clock на початку розкладу, нс
+
+    std::atomic<bool> m_is_finished {false};
+    std::atomic<std::uint64_t> m_frames {0};
+    std::atomic<std::uint64_t> m_bytes {0};
+};
+
+} // namespace DATA_SOURCE_TASK
+
+#endif // DATASOURCEREPLAY_H
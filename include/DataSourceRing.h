@@ -0,0 +1,186 @@
+#ifndef DATASOURCERING_H
+#define DATASOURCERING_H
+
+#include "globals.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace DATA_SOURCE_TASK
+{
+
+// Розмір кеш-лінії. Індекси виробника і споживача рознесені по різних лініях.
+static constexpr std::size_t CACHE_LINE_SIZE {64};
+
+// Глибина черги кадрів між потоком читання і потоком обробки за замовчуванням.
+static constexpr std::size_t DEFAULT_QUEUE_DEPTH {16};
+
+/// \brief Перевірка, що число є степенем двійки.
+inline bool isPowerOfTwo(const std::size_t & n)
+{
+    return n && !(n & (n - 1));
+}
+
+/// \brief Найменший степінь двійки, не менший за n.
+inline std::size_t ceilPowerOfTwo(const std::size_t & n)
+{
+    std::size_t p = 1;
+
+    while (p < n)
+        p <<= 1;
+
+    return p;
+}
+
+/// \brief Кільцевий буфер без блокувань для одного виробника і кількох споживачів.
+/// Слоти виділені наперед, глибина - степінь двійки, тому позиція слоту рахується маскою.
+/// Кожен слот має свій номер послідовності (схема Д. Вюкова): виробник пише лише в слот, звільнений споживачем,
+/// споживач забирає лише опублікований слот. Тому забрати найстаріший елемент може і сам виробник
+/// (відкидання старих кадрів при переповненні), не ламаючи споживача.
+/// Робоча глибина (limit) може бути меншою за к-сть слотів і змінюватись на ходу.
+/// Виробник: writeSlot() -> заповнення -> push().
+/// Споживач: pop().
+template<typename T>
+class DataSourceRing
+{
+public:
+    /// \brief Конструктор
+    /// \param depth - к-сть слотів, степінь двійки
+    explicit DataSourceRing(const std::size_t & depth):
+        m_mask {depth - 1}
+    {
+        if (!isPowerOfTwo(depth))
+            throw std::invalid_argument("DataSourceRing: depth must be a power of two");
+
+        m_cells.reset(new cell[depth]);
+
+        for (std::size_t i = 0; i < depth; ++i)
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+
+        m_limit.store(depth, std::memory_order_relaxed);
+    }
+
+    DATA_SOURCE_NON_COPYABLE(DataSourceRing)
+
+    /// \brief Вільний слот для запису. Викликається лише з потоку виробника.
+    /// \return nullptr, якщо кільце заповнене
+    T * writeSlot()
+    {
+        const std::size_t head  = m_head.load(std::memory_order_relaxed);
+        const std::size_t limit = m_limit.load(std::memory_order_relaxed);
+
+        // робоча глибина менша за к-сть слотів
+        if (limit <= m_mask && head - m_tail.load(std::memory_order_acquire) >= limit)
+            return nullptr;
+
+        cell & c = m_cells[head & m_mask];
+
+        // слот вільний, коли споживач повернув його з номером поточної позиції запису
+        if (c.sequence.load(std::memory_order_acquire) != head)
+            return nullptr;
+
+        return &c.value;
+    }
+
+    /// \brief Публікуємо заповнений слот для споживача.
+    void push()
+    {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+
+        m_cells[head & m_mask].sequence.store(head + 1, std::memory_order_release);
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    /// \brief Забираємо найстаріший елемент. Можна викликати з кількох потоків, в т.ч. з потоку виробника.
+    /// \param out - сюди переміщується елемент
+    /// \return false, якщо кільце порожнє
+    bool pop(T & out)
+    {
+        std::size_t tail = m_tail.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            cell & c                  = m_cells[tail & m_mask];
+            const std::size_t seq     = c.sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq - (tail + 1));
+
+            if (diff == 0)
+            {
+                // слот опубліковано - займаємо позицію і лише потім переміщуємо дані
+                if (m_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed))
+                {
+                    out = std::move(c.value);
+                    c.sequence.store(tail + capacity(), std::memory_order_release);
+
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                // інший споживач вже забрав цей слот
+                tail = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// \brief Поточна заповненість кільця
+    /// \return
+    std::size_t size() const
+    {
+        const std::size_t tail = m_tail.load(std::memory_order_acquire);
+        const std::size_t head = m_head.load(std::memory_order_acquire);
+
+        return head > tail ? head - tail : 0;
+    }
+
+    /// \brief К-сть слотів
+    /// \return
+    std::size_t capacity() const { return m_mask + 1; }
+
+    /// \brief Робоча глибина: виробник не займає більше слотів, ніж limit().
+    /// \return
+    std::size_t limit() const { return m_limit.load(std::memory_order_relaxed); }
+
+    /// \brief Змінюємо робочу глибину без перевиділення. Можна викликати з будь-якого потоку.
+    /// \param limit - 1...capacity()
+    void setLimit(const std::size_t & limit)
+    {
+        m_limit.store(std::min(std::max<std::size_t>(limit, 1), capacity()), std::memory_order_relaxed);
+    }
+
+    /// \brief Прямий доступ до слоту, наприклад для попереднього заповнення до старту потоків.
+    /// \param index - 0...capacity()-1
+    T & at(const std::size_t & index) { return m_cells[index & m_mask].value; }
+
+private:
+    struct cell
+    {
+        std::atomic<std::size_t> sequence; // позиція, для якої слот готовий: запису (== head) або читання (== tail + 1)
+        T value;
+    };
+
+    const std::size_t m_mask;
+    std::unique_ptr<cell[]> m_cells;
+    char m_cells_pad[CACHE_LINE_SIZE];
+
+    // Лічильник виробника і робоча глибина
+    std::atomic<std::size_t> m_head {0};
+    std::atomic<std::size_t> m_limit {0};
+    char m_head_pad[CACHE_LINE_SIZE - 2 * sizeof(std::atomic<std::size_t>)];
+
+    // Лічильник споживачів
+    std::atomic<std::size_t> m_tail {0};
+    char m_tail_pad[CACHE_LINE_SIZE - sizeof(std::atomic<std::size_t>)];
+};
+
+} // namespace DATA_SOURCE_TASK
+
+#endif // DATASOURCERING_H
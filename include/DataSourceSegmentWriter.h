@@ -0,0 +1,120 @@
+#ifndef DATASOURCESEGMENTWRITER_H
+#define DATASOURCESEGMENTWRITER_H
+
+#include "globals.h"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+namespace DATA_SOURCE_TASK
+{
+
+// Максимальний розмір одного файлу сегменту за замовчуванням, 1 ГБ.
+static constexpr std::uint64_t DEFAULT_SEGMENT_SIZE {1024ull * 1024ull * 1024ull};
+
+/// \brief Запис блоків в кінець файлу без повторного відкриття.
+/// Файл тримається відкритим, блоки дописуються за зміщенням (pwrite). Коли сегмент досягає
+/// заданого розміру або віку, відкривається наступний: <base_name>_<index>.bin.
+/// Якщо можливо, файл відкривається з O_DIRECT (дані в обхід page cache), тоді блоки мають бути вирівняні на
+/// DIRECT_IO_ALIGNMENT за адресою і розміром; невирівняний блок або файлова система без O_DIRECT
+/// переводять сегмент на звичайний буферизований запис.
+/// Номери сегментів можна брати зі спільного лічильника: кілька записувачів одного джерела (наприклад, реєстратор,
+/// створений знову після витіснення) продовжують нумерацію, а не перезаписують сегменти попередника.
+/// Не потокобезпечний, використовується з одного потоку запису.
+class DataSourceSegmentWriter
+{
+public:
+    /// \brief Конструктор. Файл відкривається при першому записі.
+    /// \param base_name - базове ім'я файлів сегментів
+    /// \param segment_size - максимальний розмір сегменту, байт
+    /// \param segment_seconds - максимальний вік сегменту, с. 0 - без обмеження
+    /// \param use_direct_io - намагатись писати з O_DIRECT
+    /// \param segment_counter - спільний лічильник номерів сегментів, nullptr - власна нумерація з 0
+    DataSourceSegmentWriter(
+        const std::string & base_name,
+        const std::uint64_t & segment_size = DEFAULT_SEGMENT_SIZE,
+        const std::uint32_t & segment_seconds = 0,
+        const bool & use_direct_io = true,
+        const std::shared_ptr<std::atomic<std::uint32_t>> & segment_counter = nullptr);
+
+    DATA_SOURCE_NON_COPYABLE(DataSourceSegmentWriter)
+
+    ~DataSourceSegmentWriter();
+
+    /// \brief Дописуємо блок в поточний сегмент, за потреби перейшовши на наступний
+    /// \param data - дані
+    /// \param size - розмір, байт
+    /// \return false при помилці запису
+    bool write(const char * data, const std::size_t & size);
+
+    /// \brief Дописуємо блок в поточний сегмент без переходу на наступний (заголовки, індекс)
+    /// \param data - дані
+    /// \param size - розмір, байт
+    /// \return false при помилці запису
+    bool append(const char * data, const std::size_t & size);
+
+    /// \brief Закриваємо поточний сегмент. Наступний запис відкриє новий з тим же номером.
+    void close();
+
+    /// \brief Закриваємо поточний сегмент, наступний запис відкриє сегмент з наступним номером
+    void rotate();
+
+    /// \brief Чи пора переходити на наступний сегмент перед записом size байт
+    /// \param size - розмір наступного запису, байт
+    /// \return
+    bool needRotate(const std::size_t & size);
+
+    /// \brief Чи відкритий сегмент
+    /// \return
+    bool isOpen() const;
+
+    /// \brief Чи пишемо зараз в обхід page cache
+    /// \return
+    inline bool isDirect() const { return m_is_direct; }
+
+    /// \brief Номер поточного сегменту
+    /// \return
+    inline std::uint32_t segmentIndex() const { return m_segment_index; }
+
+    /// \brief Ім'я поточного сегменту
+    /// \return
+    inline const std::string & segmentName() const { return m_segment_name; }
+
+    /// \brief Зміщення в поточному сегменті
+    /// \return
+    inline std::uint64_t offset() const { return m_offset; }
+
+    /// \brief Всього записано байт у всі сегменти
+    /// \return
+    inline std::uint64_t bytesWritten() const { return m_bytes_written; }
+
+private:
+    bool openSegment();
+
+    /// \brief Вимикаємо O_DIRECT для поточного сегменту
+    void dropDirect();
+
+    std::string m_base_name;
+    std::string m_segment_name;
+    std::uint64_t m_segment_size    = DEFAULT_SEGMENT_SIZE;
+    std::uint32_t m_segment_seconds = 0;
+    bool m_use_direct_io            = true;
+    bool m_is_direct                = false;
+
+    std::uint32_t m_segment_index = 0;
+    std::shared_ptr<std::atomic<std::uint32_t>> m_segment_counter; // спільна нумерація сегментів
+    std::uint64_t m_offset        = 0;
+    std::uint64_t m_bytes_written = 0;
+    Timer m_segment_timer;
+
+#ifdef WIN32
+    std::FILE * m_file = nullptr;
+#else
+    int m_fd = -1;
+#endif
+};
+
+} // namespace DATA_SOURCE_TASK
+
+#endif // DATASOURCESEGMENTWRITER_H
@@ -0,0 +1,230 @@
+#ifndef DATASOURCESHAREDRING_H
+#define DATASOURCESHAREDRING_H
+
+#include "DataSourceBuffer.h"
+#include "DataSourceRing.h"
+#include "globals.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace DATA_SOURCE_TASK
+{
+
+// К-сть кадрів в кільці за замовчуванням
+static constexpr std::uint32_t DEFAULT_SHARED_RING_SLOTS {64};
+
+// К-сть читачів, курсори яких видно в кільці. Решта читають без реєстрації.
+static constexpr std::uint32_t MAX_SHARED_RING_READERS {16};
+
+// Ознака і версія розмітки пам'яті кільця
+static constexpr std::uint32_t SHARED_RING_MAGIC {0x44535352}; // "RSSD"
+static constexpr std::uint32_t SHARED_RING_VERSION {1};
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "shared ring needs address-free 64 bit atomics");
+
+/// \brief Налаштування кілець перетворених кадрів в спільній пам'яті
+struct shared_ring_config
+{
+    std::string name_prefix;                        // об'єкт POSIX shm: /<name_prefix><ІД джерела>, "" - без кілець
+    std::uint32_t slots = DEFAULT_SHARED_RING_SLOTS; // к-сть кадрів, округлюється до степеня 2
+};
+
+/// \brief Заголовок кільця на початку спільної пам'яті
+struct alignas(CACHE_LINE_SIZE) shared_ring_header
+{
+    std::atomic<std::uint32_t> magic;   // SHARED_RING_MAGIC, пишеться останнім при створенні
+    std::uint32_t version;              // SHARED_RING_VERSION
+    std::uint32_t slot_count;           // к-сть слотів, степінь 2
+    std::uint32_t slot_size;            // байт на слот разом з заголовком слоту
+    std::uint32_t max_elements;         // відліків float в слоті
+    std::uint8_t source_id;             // ІД джерела
+    std::uint8_t reserved[3];
+    std::uint64_t created_ns;           // час створення (system_clock), нс
+    std::atomic<std::uint32_t> closed;  // 1 - записувач завершився, кадрів більше не буде
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> write_sequence; // к-сть опублікованих кадрів
+};
+
+/// \brief Курсор зареєстрованого читача
+struct alignas(CACHE_LINE_SIZE) shared_ring_reader
+{
+    std::atomic<std::int64_t> pid;     // процес читача, 0 - вільно
+    std::atomic<std::uint64_t> cursor; // номер наступного кадру читача
+    std::atomic<std::uint64_t> lost;   // кадри, перезаписані до прочитання
+};
+
+/// \brief Заголовок слоту, за ним - відліки float
+struct alignas(CACHE_LINE_SIZE) shared_slot_header
+{
+    // 2n+1 - кадр n пишеться, 2n+2 - кадр n опубліковано
+    std::atomic<std::uint64_t> sequence;
+    std::uint64_t timestamp_ns;  // час публікації (system_clock), нс
+    std::uint32_t magic_word;    // заголовок вхідного кадру
+    std::uint16_t frame_counter;
+    std::uint8_t source_id;
+    PAYLOAD_TYPE source_type;    // тип відліків джерела до перетворення
+    std::uint32_t elements;      // к-сть відліків float
+};
+
+/// \brief Кадр в кільці без копіювання. Дійсний, доки release() не скаже, що слот не перезаписано.
+struct shared_frame_view
+{
+    std::uint64_t sequence       = 0; // номер кадру в кільці
+    std::uint64_t timestamp_ns   = 0;
+    std::uint32_t magic_word     = 0;
+    std::uint16_t frame_counter  = 0;
+    std::uint8_t source_id       = 0;
+    PAYLOAD_TYPE source_type     = PAYLOAD_TYPE::PAYLOAD_TYPE_UNSUPPORTED;
+    std::uint32_t elements       = 0;
+    const float * samples        = nullptr; // відліки в спільній пам'яті
+};
+
+/// \brief Стан зареєстрованого читача для моніторингу
+struct shared_reader_stats
+{
+    std::int64_t pid    = 0;
+    std::uint64_t lag   = 0; // кадри, опубліковані, але ще не прочитані
+    std::uint64_t lost  = 0;
+};
+
+/// \brief Записувач кільця перетворених кадрів одного джерела в спільній пам'яті (POSIX shm).
+/// Кожен слот - заголовок кадру, час і відліки float. Записувач ніколи не чекає читачів: повільний читач
+/// отримує перезаписані кадри як втрати, а не гальмує обробку. Стан слоту - seqlock номера кадру,
+/// тож читачі в інших процесах без блокувань і системних викликів бачать, чи кадр цілий.
+/// Не для Windows: isOpen() завжди false.
+class DataSourceSharedRingWriter
+{
+public:
+    /// \brief Створюємо кільце. Об'єкт з тим же ім'ям від попереднього запуску замінюється.
+    /// \param name - ім'я об'єкта shm, з '/' на початку
+    /// \param source_id - ІД джерела
+    /// \param max_elements - найбільша к-сть відліків float в кадрі
+    /// \param slots - к-сть кадрів, округлюється до степеня 2
+    DataSourceSharedRingWriter(
+        const std::string & name,
+        const std::uint8_t & source_id,
+        const std::uint32_t & max_elements,
+        const std::uint32_t & slots = DEFAULT_SHARED_RING_SLOTS);
+
+    DATA_SOURCE_NON_COPYABLE(DataSourceSharedRingWriter)
+
+    /// \brief Позначаємо кільце закритим і видаляємо ім'я. Читачі дочитують свої відображення.
+    ~DataSourceSharedRingWriter();
+
+    /// \brief Чи створено спільну пам'ять
+    /// \return
+    inline bool isOpen() const { return m_header != nullptr; }
+
+    /// \brief Публікуємо перетворений кадр. Викликається з одного потоку.
+    /// \param flt_frame - кадр float з заголовком вхідного кадру
+    /// \param total_elements - к-сть відліків
+    /// \param source_type - тип відліків джерела
+    void publish(DataSourceBufferInterface & flt_frame, const int & total_elements, const PAYLOAD_TYPE & source_type);
+
+    /// \brief К-сть опублікованих кадрів. Можна викликати з будь-якого потоку.
+    /// \return
+    std::uint64_t published() const;
+
+    /// \brief Зареєстровані читачі: відставання і втрати. Можна викликати з будь-якого потоку.
+    /// \return
+    std::vector<shared_reader_stats> readers() const;
+
+    /// \brief Розмір спільної пам'яті, байт
+    /// \return
+    inline std::size_t memoryUsage() const { return m_size; }
+
+    /// \brief Ім'я об'єкта shm
+    /// \return
+    inline const std::string & name() const { return m_name; }
+
+private:
+    std::string m_name;
+    std::size_t m_size = 0;
+
+    shared_ring_header * m_header = nullptr;
+    char * m_slots                = nullptr;
+
+    std::uint64_t m_sequence = 0; // номер наступного кадру, лише потік publish()
+};
+
+/// \brief Читач кільця в будь-якому процесі. Кожен читач має власний курсор, читачі не заважають один одному
+/// і записувачу. Кадр береться без копіювання (acquire()/release()) або копією (read()).
+class DataSourceSharedRingReader
+{
+public:
+    /// \brief Відкриваємо кільце
+    /// \param name - ім'я об'єкта shm
+    /// \param from_oldest - починати з найстарішого кадру в кільці, інакше - з наступного опублікованого
+    explicit DataSourceSharedRingReader(const std::string & name, const bool & from_oldest = false);
+
+    DATA_SOURCE_NON_COPYABLE(DataSourceSharedRingReader)
+
+    ~DataSourceSharedRingReader();
+
+    /// \brief Чи відкрито кільце
+    /// \return
+    inline bool isOpen() const { return m_header != nullptr; }
+
+    /// \brief Наступний кадр без копіювання. Якщо читач відстав більше ніж на ємність кільця, курсор
+    /// переходить на найстаріший кадр, пропущені кадри рахуються в lost().
+    /// \param view - кадр, відліки - у спільній пам'яті
+    /// \return false, якщо нових кадрів немає
+    bool acquire(shared_frame_view & view);
+
+    /// \brief Перевіряємо, що слот кадру не перезаписали, поки його читали.
+    /// \param view - кадр з acquire()
+    /// \return false - дані могли змінитись під час читання, кадр рахується в lost()
+    bool release(const shared_frame_view & view);
+
+    /// \brief Наступний кадр копією
+    /// \param view - кадр, samples вказує на samples
+    /// \param samples - відліки
+    /// \return false, якщо нових кадрів немає
+    bool read(shared_frame_view & view, std::vector<float> & samples);
+
+    /// \brief Кадри, перезаписані до прочитання або під час читання
+    /// \return
+    inline std::uint64_t lost() const { return m_lost; }
+
+    /// \brief Скільки разів читач відставав і перескакував на найстаріший кадр
+    /// \return
+    inline std::uint64_t overruns() const { return m_overruns; }
+
+    /// \brief Кадри, опубліковані, але ще не прочитані
+    /// \return
+    std::uint64_t lag() const;
+
+    /// \brief Записувач завершився: нових кадрів не буде, кільце можна відкрити знову
+    /// \return
+    bool isWriterClosed() const;
+
+    /// \brief Найбільша к-сть відліків в кадрі
+    /// \return
+    inline std::uint32_t maxElements() const { return m_header ? m_header->max_elements : 0; }
+
+private:
+    /// \brief Заголовок слоту кадру sequence
+    shared_slot_header * slot(const std::uint64_t & sequence) const;
+
+    /// \brief Займаємо курсор в заголовку кільця, щоб записувач бачив відставання
+    void registerReader();
+
+    /// \brief Оновлюємо зареєстрований курсор
+    void updateCursor();
+
+    std::size_t m_size = 0;
+
+    shared_ring_header * m_header = nullptr;
+    shared_ring_reader * m_reader = nullptr; // зареєстрований курсор, nullptr - всі зайняті
+    char * m_slots                = nullptr;
+
+    std::uint64_t m_cursor   = 0; // номер наступного кадру
+    std::uint64_t m_lost     = 0;
+    std::uint64_t m_overruns = 0;
+};
+
+} // namespace DATA_SOURCE_TASK
+
+#endif // DATASOURCESHAREDRING_H
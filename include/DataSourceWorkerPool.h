@@ -0,0 +1,100 @@
+#ifndef DATASOURCEWORKERPOOL_H
+#define DATASOURCEWORKERPOOL_H
+
+#include "DataSourceRing.h"
+#include "globals.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DATA_SOURCE_TASK
+{
+
+/// \brief Пул робочих потоків з крадіжкою задач.
+/// Кожен потік має власну чергу: бере задачі зі свого кінця, а коли черга порожня - краде з початку чужих.
+/// parallelFor() розкладає задачі по чергах суцільними блоками (сусідні частини кадру - одному потоку),
+/// викликаючий потік теж виконує задачі, поки не завершаться всі.
+/// Один пул можна використовувати з кількох потоків одночасно (спільний для всіх джерел).
+class DataSourceWorkerPool
+{
+public:
+    /// \brief Конструктор
+    /// \param threads - к-сть робочих потоків. 0 - все виконується у викликаючому потоці.
+    explicit DataSourceWorkerPool(const std::size_t & threads);
+
+    DATA_SOURCE_NON_COPYABLE(DataSourceWorkerPool)
+
+    ~DataSourceWorkerPool();
+
+    /// \brief Спільний пул процесу на hardware_concurrency() - 1 потоків (викликаючий потік - ще одне ядро).
+    /// \return
+    static std::shared_ptr<DataSourceWorkerPool> shared();
+
+    /// \brief Виконуємо fn(0) ... fn(count - 1) паралельно і чекаємо завершення всіх.
+    /// \param count - к-сть задач
+    /// \param fn - задача, не повинна кидати виключення
+    void parallelFor(const std::size_t & count, const std::function<void(std::size_t)> & fn);
+
+    /// \brief К-сть робочих потоків
+    /// \return
+    inline std::size_t threads() const { return m_threads.size(); }
+
+    /// \brief К-сть виконаних задач
+    /// \return
+    inline std::uint64_t tasksExecuted() const { return m_executed; }
+
+    /// \brief К-сть задач, вкрадених з чужих черг
+    /// \return
+    inline std::uint64_t tasksStolen() const { return m_stolen; }
+
+private:
+    struct task_group
+    {
+        const std::function<void(std::size_t)> * fn;
+        std::atomic<std::size_t> remaining;
+    };
+
+    struct task
+    {
+        task_group * group;
+        std::size_t index;
+    };
+
+    // Кожна черга в окремому виділенні, запас відсуває сусідню від спільної кеш-лінії
+    struct worker_queue
+    {
+        std::mutex lock;
+        std::deque<task> tasks;
+        char pad[CACHE_LINE_SIZE];
+    };
+
+    /// \brief Робочий потік
+    void workerLoop(const std::size_t & id);
+
+    /// \brief Беремо задачу: спочатку зі своєї черги (кінець), потім крадемо з початку чужих
+    /// \param id - своя черга; m_queues.size() - своєї черги немає (викликаючий потік)
+    bool takeTask(const std::size_t & id, task & out);
+
+    /// \brief Виконуємо задачу
+    void run(const task & t);
+
+    std::vector<std::unique_ptr<worker_queue>> m_queues;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_wake_lock;
+    std::condition_variable m_wake;
+    std::atomic<std::size_t> m_pending {0}; // задачі в чергах
+    std::atomic<bool> m_is_active {true};
+
+    std::atomic<std::uint64_t> m_executed {0};
+    std::atomic<std::uint64_t> m_stolen {0};
+};
+
+} // namespace DATA_SOURCE_TASK
+
+#endif // DATASOURCEWORKERPOOL_H
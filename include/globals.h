@@ -3,6 +3,7 @@
 
 #include <atomic>
 #include <cstdint>
+#include <limits>
 #ifdef WIN32
 #include <profileapi.h>
 #include <winnt.h>
@@ -36,7 +37,7 @@ public:
     }
     /// \brief Пройдений час в мілісекундах
     /// \return
-    double elapsed()
+    double elapsed() const
     {
         LARGE_INTEGER end;
         QueryPerformanceCounter(&end);
@@ -45,11 +46,27 @@ public:
         return static_cast<double>(end.QuadPart - m_start.QuadPart) * 1000.0 / m_frequency.QuadPart;
     }
 
+    /// \brief Пройдений час в наносекундах
+    /// \return
+    std::int64_t elapsedNs() const
+    {
+        LARGE_INTEGER end;
+        QueryPerformanceCounter(&end);
+
+        const std::int64_t ticks = end.QuadPart - m_start.QuadPart;
+
+        // ділимо частинами, щоб не переповнити ticks * 10^9
+        return (ticks / m_frequency.QuadPart) * 1000000000ll
+            + (ticks % m_frequency.QuadPart) * 1000000000ll / m_frequency.QuadPart;
+    }
+
 private:
     LARGE_INTEGER m_start;
     LARGE_INTEGER m_frequency;
 };
 #else
+/// \brief Таймер на монотонному годиннику (steady_clock), роздільна здатність - наносекунди.
+/// Не залежить від переведення системного часу, може читатись з будь-якого потоку.
 class Timer
 {
 public:
@@ -58,29 +75,35 @@ public:
     bool isValid() const { return m_is_valid; }
     void reset()
     {
-        m_start    = std::chrono::system_clock::now();
+        m_start    = std::chrono::steady_clock::now();
         m_is_valid = true;
     }
 
     /// \brief Пройдений час в мілісекундах
     /// \return
-    std::int64_t elapsed() const
+    double elapsed() const
     {
         if (isValid())
-        {
-            static std::chrono::time_point<std::chrono::system_clock> end;
-            end = std::chrono::system_clock::now();
+            return elapsedNs() / 1000000.;
+
+        return std::numeric_limits<double>::max();
+    }
 
-            return std::chrono::duration_cast<std::chrono::milliseconds>(
-                       std::chrono::high_resolution_clock::now() - m_start)
+    /// \brief Пройдений час в наносекундах
+    /// \return
+    std::int64_t elapsedNs() const
+    {
+        if (isValid())
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start)
                 .count();
         }
-        return std::numeric_limits<int64_t>::max();
+        return std::numeric_limits<std::int64_t>::max();
     }
 
 private:
     std::atomic<bool> m_is_valid;
-    std::chrono::time_point<std::chrono::high_resolution_clock> m_start;
+    std::chrono::time_point<std::chrono::steady_clock> m_start;
 };
 #endif
 
@@ -121,6 +144,9 @@ struct frame
 
 static constexpr std::uint32_t FRAME_HEADER_SIZE {sizeof(struct frame) - sizeof(void *)};
 
+// ідентифікатор початку кадру за замовчуванням
+static constexpr std::uint32_t FRAME_MAGIC_WORD {0xf113};
+
 static constexpr int UINT8_SIZE {sizeof(std::uint8_t)};
 static constexpr int INT16_SIZE {sizeof(std::int16_t)};
 static constexpr int INT32_SIZE {sizeof(std::int32_t)};
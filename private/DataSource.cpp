@@ -3,6 +3,40 @@
 namespace DATA_SOURCE_TASK
 {
 
-DataSource::DataSource(): m_elapsed {0} {}
+DataSource::DataSource(): m_elapsed {0.} {}
+
+int DataSource::readBatch(read_vector * frames, int count)
+{
+    int filled = 0;
+
+    for (; filled < count; ++filled)
+    {
+        const int size = read(frames[filled].data, frames[filled].size);
+
+        if (size <= 0)
+            return filled ? filled : size;
+
+        frames[filled].size = size;
+    }
+
+    return filled;
+}
+
+read_block DataSource::acquire(char * buffer, int size)
+{
+    read_block block;
+
+    block.data = buffer;
+    block.size = read(buffer, size);
+
+    return block;
+}
+
+void DataSource::commit(const read_block & block, int consumed)
+{
+    // дані вже в буфері викликаючого
+    (void) block;
+    (void) consumed;
+}
 
 } // namespace DATA_SOURCE_TASK
@@ -0,0 +1,390 @@
+#include "DataSourceCaptureFile.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace DATA_SOURCE_TASK
+{
+
+namespace
+{
+
+std::uint64_t alignPage(const std::uint64_t & size)
+{
+    return (size + DIRECT_IO_ALIGNMENT - 1) / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT;
+}
+
+std::uint64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+capture_index_entry indexEntry(const block_header & header, const std::uint64_t & offset)
+{
+    capture_index_entry entry;
+
+    entry.offset       = offset;
+    entry.block_size   = header.block_size;
+    entry.sample_count = header.sample_count;
+    entry.first_frame  = header.first_frame;
+    entry.last_frame   = header.last_frame;
+    entry.first_ns     = header.first_ns;
+    entry.last_ns      = header.last_ns;
+
+    return entry;
+}
+
+} // namespace
+
+std::string captureIndexName(const std::string & file_name)
+{
+    const std::string extension = ".bin";
+
+    if (file_name.size() > extension.size()
+        && file_name.compare(file_name.size() - extension.size(), extension.size(), extension) == 0)
+    {
+        return file_name.substr(0, file_name.size() - extension.size()) + ".idx";
+    }
+
+    return file_name + ".idx";
+}
+
+// --------------   DataSourceCaptureWriter   --------------------
+
+DataSourceCaptureWriter::DataSourceCaptureWriter(
+    const std::string & base_name,
+    const std::uint64_t & segment_size,
+    const std::uint32_t & segment_seconds,
+    const std::uint32_t & frame_elements,
+    const RECORD_CODEC & codec,
+    const std::shared_ptr<std::atomic<std::uint32_t>> & segment_counter):
+    m_frame_elements {frame_elements},
+    m_codec {codec},
+    m_writer {base_name, segment_size, segment_seconds, true, segment_counter}
+{
+}
+
+DataSourceCaptureWriter::~DataSourceCaptureWriter()
+{
+    close();
+}
+
+bool DataSourceCaptureWriter::openSegment(const block_header & first)
+{
+    capture_file_header header;
+
+    header.created_ns     = nowNs();
+    header.segment_index  = m_writer.segmentIndex();
+    header.frame_elements = m_frame_elements;
+    header.source_id      = first.source_id;
+    header.payload_type   = first.payload_type;
+    header.format         = first.format;
+    header.codec          = static_cast<std::uint8_t>(m_codec);
+
+    m_page.assign(CAPTURE_DATA_OFFSET, 0);
+    memcpy(m_page.data(), &header, sizeof(header));
+
+    if (!m_writer.append(m_page.data(), m_page.size()))
+        return false;
+
+    m_index.clear();
+
+    m_index_name = captureIndexName(m_writer.segmentName());
+    m_index_file = std::fopen(m_index_name.c_str(), "wb");
+
+    if (!m_index_file)
+        std::cout << "DataSourceCaptureWriter: can't open " << m_index_name << std::endl;
+
+    return true;
+}
+
+bool DataSourceCaptureWriter::write(const char * block, const std::size_t & size)
+{
+    block_header header;
+
+    if (!DataSourceBlockCodec::readHeader(block, size, header))
+        return false;
+
+    if (m_writer.isOpen() && m_writer.needRotate(size))
+        close();
+
+    if (!m_writer.isOpen() && !openSegment(header))
+        return false;
+
+    const std::uint64_t offset = m_writer.offset();
+
+    if (!m_writer.append(block, size))
+        return false;
+
+    m_bytes_written += size;
+
+    m_index.push_back(indexEntry(header, offset));
+
+    // індекс на випадок аварії: блок вже в файлі, запис індексу - після нього
+    if (m_index_file)
+    {
+        std::fwrite(&m_index.back(), sizeof(capture_index_entry), 1, m_index_file);
+        std::fflush(m_index_file);
+    }
+
+    return true;
+}
+
+void DataSourceCaptureWriter::close()
+{
+    if (!m_writer.isOpen())
+        return;
+
+    capture_file_footer footer;
+
+    footer.entry_count  = static_cast<std::uint32_t>(m_index.size());
+    footer.index_offset = m_writer.offset();
+
+    // індекс і футер в кінці, футер - останні байти файлу
+    const std::size_t index_bytes = m_index.size() * sizeof(capture_index_entry);
+
+    m_page.assign(alignPage(index_bytes + sizeof(footer)), 0);
+
+    if (index_bytes)
+        memcpy(m_page.data(), m_index.data(), index_bytes);
+
+    memcpy(m_page.data() + m_page.size() - sizeof(footer), &footer, sizeof(footer));
+
+    const bool is_written = m_writer.append(m_page.data(), m_page.size());
+
+    m_writer.rotate();
+    m_index.clear();
+
+    if (m_index_file)
+    {
+        std::fclose(m_index_file);
+        m_index_file = nullptr;
+
+        // футер на місці - окремий індекс більше не потрібен
+        if (is_written)
+            std::remove(m_index_name.c_str());
+    }
+}
+
+// --------------   DataSourceCaptureReader   --------------------
+
+DataSourceCaptureReader::DataSourceCaptureReader(const std::string & file_name): m_file_name {file_name}
+{
+    std::uint64_t file_size = 0;
+
+#ifdef WIN32
+    m_file = std::fopen(m_file_name.c_str(), "rb");
+
+    if (!m_file)
+        return;
+
+    _fseeki64(m_file, 0, SEEK_END);
+    file_size = static_cast<std::uint64_t>(_ftelli64(m_file));
+#else
+    m_fd = ::open(m_file_name.c_str(), O_RDONLY);
+
+    if (m_fd < 0)
+        return;
+
+    struct stat st;
+
+    if (fstat(m_fd, &st) == 0)
+        file_size = static_cast<std::uint64_t>(st.st_size);
+#endif
+
+    if (!readAt(0, reinterpret_cast<char *>(&m_header), sizeof(m_header)) || m_header.magic != CAPTURE_FILE_MAGIC
+        || m_header.data_offset < sizeof(m_header))
+    {
+        std::cout << "DataSourceCaptureReader: not a capture file " << m_file_name << std::endl;
+        return;
+    }
+
+    m_is_header = true;
+
+    m_is_complete = loadFooter(file_size);
+
+    if (!m_is_complete && !loadIndexFile(file_size))
+        scanBlocks(file_size);
+}
+
+DataSourceCaptureReader::~DataSourceCaptureReader()
+{
+#ifdef WIN32
+    if (m_file)
+        std::fclose(m_file);
+#else
+    if (m_fd >= 0)
+        ::close(m_fd);
+#endif
+}
+
+bool DataSourceCaptureReader::isOpen() const
+{
+    return m_is_header;
+}
+
+bool DataSourceCaptureReader::readAt(const std::uint64_t & offset, char * data, const std::size_t & size) const
+{
+#ifdef WIN32
+    std::lock_guard<std::mutex> lock(m_file_lock);
+
+    if (!m_file || _fseeki64(m_file, static_cast<__int64>(offset), SEEK_SET) != 0)
+        return false;
+
+    return std::fread(data, 1, size, m_file) == size;
+#else
+    std::size_t done = 0;
+
+    while (done < size)
+    {
+        const ssize_t ret = pread(m_fd, data + done, size - done, static_cast<off_t>(offset + done));
+
+        if (ret < 0 && errno == EINTR)
+            continue;
+
+        if (ret <= 0)
+            return false;
+
+        done += static_cast<std::size_t>(ret);
+    }
+
+    return true;
+#endif
+}
+
+bool DataSourceCaptureReader::loadFooter(const std::uint64_t & file_size)
+{
+    capture_file_footer footer;
+
+    if (file_size < m_header.data_offset + sizeof(footer)
+        || !readAt(file_size - sizeof(footer), reinterpret_cast<char *>(&footer), sizeof(footer))
+        || footer.magic != CAPTURE_INDEX_MAGIC)
+    {
+        return false;
+    }
+
+    const std::uint64_t index_bytes = static_cast<std::uint64_t>(footer.entry_count) * sizeof(capture_index_entry);
+
+    if (footer.index_offset < m_header.data_offset || footer.index_offset + index_bytes + sizeof(footer) > file_size)
+        return false;
+
+    m_index.resize(footer.entry_count);
+
+    if (index_bytes && !readAt(footer.index_offset, reinterpret_cast<char *>(m_index.data()), index_bytes))
+    {
+        m_index.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool DataSourceCaptureReader::loadIndexFile(const std::uint64_t & file_size)
+{
+    std::FILE * file = std::fopen(captureIndexName(m_file_name).c_str(), "rb");
+
+    if (!file)
+        return false;
+
+    capture_index_entry entry;
+
+    // неповний останній запис або блок, який не встиг потрапити в файл, відкидаємо
+    while (std::fread(&entry, sizeof(entry), 1, file) == 1 && entry.offset + entry.block_size <= file_size)
+        m_index.push_back(entry);
+
+    std::fclose(file);
+
+    return !m_index.empty();
+}
+
+void DataSourceCaptureReader::scanBlocks(const std::uint64_t & file_size)
+{
+    std::uint64_t offset = m_header.data_offset;
+    block_header header;
+
+    while (offset + sizeof(block_header) <= file_size
+           && readAt(offset, reinterpret_cast<char *>(&header), sizeof(header))
+           && DataSourceBlockCodec::readHeader(
+               reinterpret_cast<const char *>(&header), static_cast<std::size_t>(file_size - offset), header))
+    {
+        m_index.push_back(indexEntry(header, offset));
+        offset += header.block_size;
+    }
+}
+
+std::size_t DataSourceCaptureReader::findFrame(const std::uint64_t & frame) const
+{
+    const auto it = std::lower_bound(
+        m_index.begin(),
+        m_index.end(),
+        frame,
+        [](const capture_index_entry & e, const std::uint64_t & f) { return e.last_frame < f; });
+
+    return static_cast<std::size_t>(it - m_index.begin());
+}
+
+std::size_t DataSourceCaptureReader::findTime(const std::uint64_t & time_ns) const
+{
+    const auto it = std::lower_bound(
+        m_index.begin(),
+        m_index.end(),
+        time_ns,
+        [](const capture_index_entry & e, const std::uint64_t & t) { return e.last_ns < t; });
+
+    return static_cast<std::size_t>(it - m_index.begin());
+}
+
+bool DataSourceCaptureReader::readBlock(
+    const std::size_t & index,
+    std::vector<float> & samples,
+    block_header * header) const
+{
+    if (index >= m_index.size())
+        return false;
+
+    const capture_index_entry & entry = m_index[index];
+
+    std::vector<char> block(entry.block_size);
+
+    if (!readAt(entry.offset, block.data(), block.size()))
+        return false;
+
+    block_header hdr;
+
+    if (!DataSourceBlockCodec::readHeader(block.data(), block.size(), hdr))
+        return false;
+
+    const int sample_size = recordFormatSize(static_cast<RECORD_FORMAT>(hdr.format));
+
+    if (!sample_size || hdr.element_size != sample_size)
+        return false;
+
+    // власний кодер на кожен виклик: читання з кількох потоків не ділить буфери
+    DataSourceBlockCodec codec;
+    std::vector<char> raw;
+
+    if (!codec.decode(block.data(), block.size(), raw))
+        return false;
+
+    const int count = static_cast<int>(raw.size() / sample_size);
+
+    samples.resize(count);
+    convertFromRecord(static_cast<RECORD_FORMAT>(hdr.format), raw.data(), count, samples.data(), hdr.scale);
+
+    if (header)
+        *header = hdr;
+
+    return true;
+}
+
+} // namespace DATA_SOURCE_TASK
@@ -0,0 +1,458 @@
+#include "DataSourceCodec.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace DATA_SOURCE_TASK
+{
+
+namespace
+{
+
+// LZ: хеш-таблиця 4-байтових послідовностей, мінімальний збіг, межа зміщення (2 байти)
+constexpr int LZ_HASH_BITS {16};
+constexpr std::size_t LZ_MIN_MATCH {4};
+constexpr std::size_t LZ_MAX_OFFSET {65535};
+// Останні байти завжди йдуть літералами: пошук збігів не виходить за межу блоку
+constexpr std::size_t LZ_LAST_LITERALS {5};
+constexpr std::size_t LZ_MATCH_FIND_LIMIT {12};
+// Поле довжини в токені (4 біти), більші довжини продовжуються байтами
+constexpr std::size_t LZ_RUN_MASK {15};
+// Межа кроку пошуку на нестискуваних ділянках: площина шуму не повинна перескочити стискувану площину за нею
+constexpr std::size_t LZ_MAX_SKIP {32};
+
+std::size_t alignUp(const std::size_t & value, const std::size_t & alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+inline std::uint32_t read32(const char * p)
+{
+    std::uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline std::uint64_t read64(const char * p)
+{
+    std::uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline std::uint32_t lzHash(const std::uint32_t & sequence)
+{
+    return (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+// Найгірший розмір LZ для size байт: всі літерали і байти продовження довжини
+std::size_t lzBound(const std::size_t & size)
+{
+    return size + size / 255 + 16;
+}
+
+inline char * writeLength(char * op, std::size_t length)
+{
+    while (length >= 255)
+    {
+        *op++ = static_cast<char>(255);
+        length -= 255;
+    }
+
+    *op++ = static_cast<char>(length);
+    return op;
+}
+
+inline bool readLength(const unsigned char *& ip, const unsigned char * iend, std::size_t & length)
+{
+    unsigned char byte;
+
+    do
+    {
+        if (ip >= iend)
+            return false;
+
+        byte = *ip++;
+        length += byte;
+    } while (byte == 255);
+
+    return true;
+}
+
+// Послідовність: токен (літерали << 4 | збіг - LZ_MIN_MATCH), довжини, літерали, зміщення, довжина збігу
+char * emitSequence(
+    char * op,
+    const char * literals,
+    const std::size_t & literal_length,
+    const std::size_t & offset,
+    const std::size_t & match_length)
+{
+    char * token = op++;
+
+    const std::size_t match_code = match_length - LZ_MIN_MATCH;
+
+    *token = static_cast<char>((std::min(literal_length, LZ_RUN_MASK) << 4) | std::min(match_code, LZ_RUN_MASK));
+
+    if (literal_length >= LZ_RUN_MASK)
+        op = writeLength(op, literal_length - LZ_RUN_MASK);
+
+    memcpy(op, literals, literal_length);
+    op += literal_length;
+
+    *op++ = static_cast<char>(offset & 0xff);
+    *op++ = static_cast<char>(offset >> 8);
+
+    if (match_code >= LZ_RUN_MASK)
+        op = writeLength(op, match_code - LZ_RUN_MASK);
+
+    return op;
+}
+
+// Остання послідовність - лише літерали
+char * emitLastLiterals(char * op, const char * literals, const std::size_t & literal_length)
+{
+    *op++ = static_cast<char>(std::min(literal_length, LZ_RUN_MASK) << 4);
+
+    if (literal_length >= LZ_RUN_MASK)
+        op = writeLength(op, literal_length - LZ_RUN_MASK);
+
+    memcpy(op, literals, literal_length);
+
+    return op + literal_length;
+}
+
+std::size_t lzCompress(const char * src, const std::size_t & size, char * dst, std::vector<std::uint32_t> & table)
+{
+    char * op = dst;
+
+    if (size < LZ_MATCH_FIND_LIMIT)
+        return emitLastLiterals(op, src, size) - dst;
+
+    // позиція + 1, 0 - порожньо
+    table.assign(std::size_t(1) << LZ_HASH_BITS, 0);
+
+    const std::size_t match_limit = size - LZ_LAST_LITERALS;
+    const std::size_t find_limit  = size - LZ_MATCH_FIND_LIMIT;
+
+    std::size_t ip     = 0;
+    std::size_t anchor = 0;
+
+    while (ip < find_limit)
+    {
+        const std::uint32_t sequence  = read32(src + ip);
+        const std::uint32_t hash      = lzHash(sequence);
+        const std::uint32_t candidate = table[hash];
+
+        table[hash] = static_cast<std::uint32_t>(ip + 1);
+
+        if (!candidate || ip - (candidate - 1) > LZ_MAX_OFFSET || read32(src + candidate - 1) != sequence)
+        {
+            // без збігів крок росте: нестискувані ділянки проходяться швидше
+            ip += 1 + std::min((ip - anchor) >> 6, LZ_MAX_SKIP);
+            continue;
+        }
+
+        const std::size_t ref = candidate - 1;
+        std::size_t length    = LZ_MIN_MATCH;
+
+        // продовжуємо збіг по 8 байт, залишок - побайтно
+        bool is_mismatch = false;
+
+        while (!is_mismatch && ip + length + sizeof(std::uint64_t) <= match_limit)
+        {
+            const std::uint64_t diff = read64(src + ip + length) ^ read64(src + ref + length);
+
+            if (diff)
+            {
+                length += __builtin_ctzll(diff) / 8;
+                is_mismatch = true;
+            }
+            else
+            {
+                length += sizeof(std::uint64_t);
+            }
+        }
+
+        while (!is_mismatch && ip + length < match_limit && src[ref + length] == src[ip + length])
+            ++length;
+
+        op = emitSequence(op, src + anchor, ip - anchor, ip - ref, length);
+
+        ip += length;
+        anchor = ip;
+
+        // позиція всередині збігу покращує пошук наступного
+        table[lzHash(read32(src + ip - 2))] = static_cast<std::uint32_t>(ip - 2 + 1);
+    }
+
+    return emitLastLiterals(op, src + anchor, size - anchor) - dst;
+}
+
+bool lzDecompress(const char * src, const std::size_t & size, char * dst, const std::size_t & dst_size)
+{
+    const unsigned char * ip   = reinterpret_cast<const unsigned char *>(src);
+    const unsigned char * iend = ip + size;
+
+    char * op         = dst;
+    char * const oend = dst + dst_size;
+
+    while (ip < iend)
+    {
+        const unsigned token = *ip++;
+
+        std::size_t literal_length = token >> 4;
+
+        if (literal_length == LZ_RUN_MASK && !readLength(ip, iend, literal_length))
+            return false;
+
+        if (literal_length > static_cast<std::size_t>(iend - ip)
+            || literal_length > static_cast<std::size_t>(oend - op))
+            return false;
+
+        memcpy(op, ip, literal_length);
+        ip += literal_length;
+        op += literal_length;
+
+        // остання послідовність без збігу
+        if (ip == iend)
+            break;
+
+        if (iend - ip < 2)
+            return false;
+
+        const std::size_t offset = ip[0] | (static_cast<std::size_t>(ip[1]) << 8);
+        ip += 2;
+
+        if (!offset || offset > static_cast<std::size_t>(op - dst))
+            return false;
+
+        std::size_t match_length = token & LZ_RUN_MASK;
+
+        if (match_length == LZ_RUN_MASK && !readLength(ip, iend, match_length))
+            return false;
+
+        match_length += LZ_MIN_MATCH;
+
+        if (match_length > static_cast<std::size_t>(oend - op))
+            return false;
+
+        // Збіг може перекривати сам себе (повтор з періодом offset): копіюємо частинами,
+        // кожна частина вдвічі більша і не перекривається з джерелом
+        const char * ref = op - offset;
+
+        while (match_length)
+        {
+            const std::size_t chunk = std::min<std::size_t>(match_length, op - ref);
+
+            memcpy(op, ref, chunk);
+            op += chunk;
+            match_length -= chunk;
+        }
+    }
+
+    return op == oend;
+}
+
+// XOR з попереднім відліком і перестановка байтів по площинах: байт b відліку i -> out[b * count + i]
+void shuffle(const char * src, const std::size_t & size, const std::size_t & element_size, char * dst)
+{
+    const std::size_t count = size / element_size;
+
+    if (element_size == FLOAT_SIZE)
+    {
+        std::uint32_t prev = 0;
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const std::uint32_t value = read32(src + i * FLOAT_SIZE);
+            const std::uint32_t delta = value ^ prev;
+
+            prev = value;
+
+            dst[i]             = static_cast<char>(delta);
+            dst[count + i]     = static_cast<char>(delta >> 8);
+            dst[2 * count + i] = static_cast<char>(delta >> 16);
+            dst[3 * count + i] = static_cast<char>(delta >> 24);
+        }
+    }
+    else
+    {
+        for (std::size_t b = 0; b < element_size; ++b)
+        {
+            char * plane = dst + b * count;
+            char prev    = 0;
+
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                const char value = src[i * element_size + b];
+
+                plane[i] = value ^ prev;
+                prev     = value;
+            }
+        }
+    }
+
+    // неповний відлік в кінці - як є
+    memcpy(dst + count * element_size, src + count * element_size, size - count * element_size);
+}
+
+void unshuffle(const char * src, const std::size_t & size, const std::size_t & element_size, char * dst)
+{
+    const std::size_t count = size / element_size;
+
+    if (element_size == FLOAT_SIZE)
+    {
+        const unsigned char * planes = reinterpret_cast<const unsigned char *>(src);
+
+        std::uint32_t prev = 0;
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const std::uint32_t delta = planes[i] | (static_cast<std::uint32_t>(planes[count + i]) << 8)
+                | (static_cast<std::uint32_t>(planes[2 * count + i]) << 16)
+                | (static_cast<std::uint32_t>(planes[3 * count + i]) << 24);
+
+            prev ^= delta;
+
+            memcpy(dst + i * FLOAT_SIZE, &prev, FLOAT_SIZE);
+        }
+    }
+    else
+    {
+        for (std::size_t b = 0; b < element_size; ++b)
+        {
+            const char * plane = src + b * count;
+            char prev          = 0;
+
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                prev ^= plane[i];
+                dst[i * element_size + b] = prev;
+            }
+        }
+    }
+
+    memcpy(dst + count * element_size, src + count * element_size, size - count * element_size);
+}
+
+} // namespace
+
+const char * recordCodecName(const RECORD_CODEC & codec)
+{
+    switch (codec)
+    {
+    case RECORD_CODEC::RECORD_CODEC_NONE:
+        return "none";
+    case RECORD_CODEC::RECORD_CODEC_RAW:
+        return "raw";
+    case RECORD_CODEC::RECORD_CODEC_SHUFFLE_LZ:
+        return "shuffle-lz";
+    default:
+        break;
+    }
+
+    return "unknown";
+}
+
+DataSourceBlockCodec::DataSourceBlockCodec(const RECORD_CODEC & codec, const std::size_t & alignment):
+    m_codec {codec},
+    m_alignment {std::max<std::size_t>(alignment, 1)}
+{
+}
+
+std::size_t DataSourceBlockCodec::encode(const char * data, const std::uint32_t & size, const block_header & meta)
+{
+    block_header header = meta;
+
+    header.magic_word   = BLOCK_MAGIC_WORD;
+    header.codec        = static_cast<std::uint8_t>(m_codec);
+    header.element_size = std::max<std::uint8_t>(meta.element_size, 1);
+    header.header_size  = sizeof(block_header);
+    header.raw_size     = size;
+
+    const std::size_t capacity = alignUp(sizeof(block_header) + lzBound(size), m_alignment);
+
+    if (m_block.size() < capacity)
+        m_block.resize(capacity);
+
+    char * payload = m_block.data() + sizeof(block_header);
+
+    std::size_t encoded = size;
+
+    if (m_codec == RECORD_CODEC::RECORD_CODEC_SHUFFLE_LZ)
+    {
+        m_shuffled.resize(size);
+
+        shuffle(data, size, header.element_size, m_shuffled.data());
+
+        encoded = lzCompress(m_shuffled.data(), size, payload, m_hash);
+    }
+
+    // кодування не дало виграшу - зберігаємо як є
+    if (m_codec != RECORD_CODEC::RECORD_CODEC_SHUFFLE_LZ || encoded >= size)
+    {
+        header.codec = static_cast<std::uint8_t>(RECORD_CODEC::RECORD_CODEC_RAW);
+        encoded      = size;
+
+        memcpy(payload, data, size);
+    }
+
+    header.encoded_size = static_cast<std::uint32_t>(encoded);
+    header.block_size   = static_cast<std::uint32_t>(alignUp(sizeof(block_header) + encoded, m_alignment));
+
+    memset(payload + encoded, 0, header.block_size - sizeof(block_header) - encoded);
+    memcpy(m_block.data(), &header, sizeof(block_header));
+
+    return header.block_size;
+}
+
+bool DataSourceBlockCodec::readHeader(const char * data, const std::size_t & size, block_header & header)
+{
+    if (size < sizeof(block_header))
+        return false;
+
+    memcpy(&header, data, sizeof(block_header));
+
+    return header.magic_word == BLOCK_MAGIC_WORD && header.header_size >= sizeof(block_header)
+        && header.element_size > 0
+        && static_cast<std::uint64_t>(header.header_size) + header.encoded_size <= header.block_size
+        && header.block_size <= size;
+}
+
+bool DataSourceBlockCodec::decode(const char * data, const std::size_t & size, std::vector<char> & out)
+{
+    block_header header;
+
+    if (!readHeader(data, size, header))
+        return false;
+
+    const char * payload = data + header.header_size;
+
+    out.resize(header.raw_size);
+
+    switch (static_cast<RECORD_CODEC>(header.codec))
+    {
+    case RECORD_CODEC::RECORD_CODEC_RAW:
+        if (header.encoded_size != header.raw_size)
+            return false;
+
+        memcpy(out.data(), payload, header.raw_size);
+        return true;
+
+    case RECORD_CODEC::RECORD_CODEC_SHUFFLE_LZ:
+        m_shuffled.resize(header.raw_size);
+
+        if (!lzDecompress(payload, header.encoded_size, m_shuffled.data(), header.raw_size))
+            return false;
+
+        unshuffle(m_shuffled.data(), header.raw_size, header.element_size, out.data());
+        return true;
+
+    default:
+        break;
+    }
+
+    return false;
+}
+
+} // namespace DATA_SOURCE_TASK
@@ -0,0 +1,217 @@
+#include "DataSourceConsumer.h"
+
+#include <algorithm>
+
+namespace DATA_SOURCE_TASK
+{
+
+namespace
+{
+
+// Межа сну потоку споживача без кадрів: запас на випадок пропущеного сповіщення при зупинці
+constexpr int CONSUMER_IDLE_WAIT_MS {100};
+
+} // namespace
+
+DataSourceConsumerHub::~DataSourceConsumerHub()
+{
+    std::vector<std::unique_ptr<consumer_worker>> workers;
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        workers.swap(m_workers);
+        m_count = 0;
+    }
+
+    for (auto & worker : workers)
+        stop(*worker);
+}
+
+int DataSourceConsumerHub::add(const std::shared_ptr<DataSourceConsumer> & consumer, const consumer_config & config)
+{
+    if (!consumer)
+        return -1;
+
+    std::unique_ptr<consumer_worker> worker(new consumer_worker(config.depth));
+
+    worker->consumer = consumer;
+    worker->config   = config;
+    worker->thread   = std::thread(&DataSourceConsumerHub::consumeLoop, worker.get());
+
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    worker->id = m_next_id++;
+
+    m_workers.push_back(std::move(worker));
+    m_count = static_cast<int>(m_workers.size());
+
+    return m_workers.back()->id;
+}
+
+bool DataSourceConsumerHub::remove(const int & id)
+{
+    std::unique_ptr<consumer_worker> worker;
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        auto it = std::find_if(m_workers.begin(), m_workers.end(), [&id](const std::unique_ptr<consumer_worker> & w) {
+            return w->id == id;
+        });
+
+        if (it == m_workers.end())
+            return false;
+
+        worker = std::move(*it);
+
+        m_workers.erase(it);
+        m_count = static_cast<int>(m_workers.size());
+    }
+
+    // publish() вже не бачить споживача - зупиняємо без блокування списку
+    stop(*worker);
+
+    return true;
+}
+
+std::size_t DataSourceConsumerHub::publish(
+    DataSourceFrameHandle & flt_frame,
+    const int & elements,
+    const PAYLOAD_TYPE & source_type)
+{
+    if (!flt_frame)
+        return 0;
+
+    const int source_id = static_cast<int>(flt_frame->sourceId());
+
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    frame_view view;
+    std::size_t delivered = 0;
+
+    for (auto & worker : m_workers)
+    {
+        const consumer_config & config = worker->config;
+
+        if (config.source_id != CONSUMER_ANY_SOURCE && config.source_id != source_id)
+            continue;
+
+        if (config.source_type != PAYLOAD_TYPE::PAYLOAD_TYPE_UNSUPPORTED && config.source_type != source_type)
+            continue;
+
+        frame_view * slot = worker->ring.writeSlot();
+
+        // повільний споживач втрачає кадр сам, решта і потік обробки не чекають
+        if (!slot)
+        {
+            worker->dropped.fetch_add(1, std::memory_order_relaxed);
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        // кадр забираємо у потоку обробки лише для першого підписаного споживача
+        if (!view.frame)
+        {
+            view.frame       = DataSourceSharedFrame(std::move(flt_frame));
+            view.elements    = elements;
+            view.source_type = source_type;
+            view.published   = std::chrono::steady_clock::now();
+        }
+
+        *slot = view;
+
+        worker->ring.push();
+        worker->event.notify();
+
+        ++delivered;
+    }
+
+    return delivered;
+}
+
+std::size_t DataSourceConsumerHub::heldFrames() const
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    std::size_t frames = 0;
+
+    // черга і кадр, який споживач обробляє
+    for (const auto & worker : m_workers)
+        frames += worker->ring.limit() + 1;
+
+    return frames;
+}
+
+std::vector<consumer_stats> DataSourceConsumerHub::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    std::vector<consumer_stats> stats;
+
+    stats.reserve(m_workers.size());
+
+    for (const auto & worker : m_workers)
+    {
+        consumer_stats consumer;
+
+        consumer.id              = worker->id;
+        consumer.name            = worker->config.name;
+        consumer.depth           = worker->ring.limit();
+        consumer.occupancy       = worker->ring.size();
+        consumer.delivered       = worker->delivered.load(std::memory_order_relaxed);
+        consumer.dropped         = worker->dropped.load(std::memory_order_relaxed);
+        consumer.queue_latency   = worker->queue_latency.snapshot();
+        consumer.consume_latency = worker->consume_latency.snapshot();
+
+        stats.push_back(consumer);
+    }
+
+    return stats;
+}
+
+void DataSourceConsumerHub::consumeLoop(consumer_worker * worker)
+{
+    frame_view view;
+    Timer timer;
+
+    while (worker->is_active)
+    {
+        if (!worker->ring.pop(view))
+        {
+            worker->event.waitFor([worker]() { return worker->ring.size() || !worker->is_active; },
+                                  std::chrono::milliseconds(CONSUMER_IDLE_WAIT_MS));
+            continue;
+        }
+
+        worker->queue_latency.record(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - view.published)
+                .count());
+
+        timer.reset();
+
+        worker->consumer->consume(view);
+
+        worker->consume_latency.record(timer.elapsedNs());
+        worker->delivered.fetch_add(1, std::memory_order_relaxed);
+
+        // кадр повертається в пул, коли його відпустять всі споживачі
+        view.frame.reset();
+    }
+}
+
+void DataSourceConsumerHub::stop(consumer_worker & worker)
+{
+    worker.is_active = false;
+    worker.event.notify();
+
+    if (worker.thread.joinable())
+        worker.thread.join();
+
+    frame_view view;
+
+    while (worker.ring.pop(view))
+        view.frame.reset();
+}
+
+} // namespace DATA_SOURCE_TASK
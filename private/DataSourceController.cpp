@@ -2,59 +2,152 @@
 
 #include "globals.h"
 
+#include <algorithm>
 #include <cstring>
 #include <thread>
 
 namespace DATA_SOURCE_TASK
 {
 
-DataSourceController::DataSourceController(const std::shared_ptr<DataSource> & data_source, const uint32_t & frame_size):
-    DataSourceFrameProcessor(frame_size),
-    m_data_source {data_source}
+// Черга має вміщати два пакети: поки потік обробки чекає, за такт приходить batch_frames кадрів
+queue_config batchQueueConfig(const queue_config & queue, const pacer_config & pacing)
 {
-    m_buffer = std::make_shared<DataSourceBuffer<std::uint8_t>>(frame_size);
+    queue_config config = queue;
 
+    config.depth     = std::max<std::size_t>(config.depth, 2 * std::max(pacing.batch_frames, 1));
+    config.max_depth = std::max(config.max_depth, config.depth);
+
+    return config;
+}
+
+DataSourceController::DataSourceController(
+    const std::shared_ptr<DataSource> & data_source,
+    const uint32_t & frame_size,
+    const queue_config & queue,
+    const recorder_config & rec_config,
+    const pacer_config & pacing,
+    const shared_ring_config & shared_ring):
+    DataSourceFrameProcessor(
+        frame_size, batchQueueConfig(queue, pacing), rec_config, std::max(pacing.batch_frames, 1), shared_ring),
+    m_pacer {pacing},
+    m_data_source {data_source},
+    m_batch(std::max(pacing.batch_frames, 1)),
+    m_batch_vectors(std::max(pacing.batch_frames, 1))
+{
     // - організувати зчитування даних в окремому потоці;
     // Потік який читає данні
-    m_read_thread = std::thread(&DataSourceController::readData, this);
+    m_is_read_active = true;
+    m_read_thread    = std::thread(&DataSourceController::readData, this);
 }
 
 void DataSourceController::readData()
 {
-    m_is_read_active = true;
-
-    int ret_size = static_cast<int>(DATA_SOURCE_ERROR::READ_SOURCE_ERROR);
-    std::atomic<double> elapsed;
-
     Timer timer;
 
+    m_pacer.start();
+
     while (m_is_read_active)
     {
         timer.reset();
-        elapsed = 0;
 
-        // - браковані кадри заповнювати нулями
-        memset(m_buffer->payload(), 0, m_buffer->payloadSize());
+        if (m_batch.size() > 1)
+            readBatch();
+        else
+            readBlock();
 
-        // читаємо з джерела
-        ret_size = m_data_source->read(m_buffer->data(), m_buffer->size());
+        m_elapsed = timer.elapsed();
 
-        if (ret_size > 0)
-        {
-            // обробка даних
-            putNewFrame(m_buffer, ret_size);
-        }
+        mutableMetrics().setGauge(METRIC_GAUGE::METRIC_GAUGE_READ_NS, timer.elapsedNs());
 
-        elapsed = timer.elapsed();
+        // 200 Hz: спимо до наступного дедлайну замість активного очікування
+        m_pacer.wait();
+    }
+}
+
+void DataSourceController::readBlock()
+{
+    Timer stage_timer;
+
+    // попередній кадр пішов в чергу - беремо новий з пулу
+    if (!m_buffer)
+        m_buffer = acquireFrame();
+
+    if (!m_buffer)
+        return;
+
+    // читаємо з джерела: в кадр з пулу або позичений буфер джерела
+    const read_block block = m_data_source->acquire(m_buffer->data(), m_buffer->size());
 
-        // 200 Hz
-        while (elapsed < MAX_FREQ_READ)
+    recordLatency(LATENCY_STAGE::LATENCY_STAGE_READ, stage_timer.elapsedNs());
+
+    if (block.size > 0)
+    {
+        // складання кадрів і обробка даних
+        stage_timer.reset();
+
+        if (block.is_lent)
         {
-            elapsed = timer.elapsed();
+            putNewData(m_buffer, block.data, block.size);
         }
+        else
+        {
+            // - браковані кадри заповнювати нулями: лише хвіст, який джерело не записало
+            if (block.size < m_buffer->size())
+                memset(m_buffer->data() + block.size, 0, m_buffer->size() - block.size);
 
-        m_elapsed = elapsed;
+            putNewData(m_buffer, block.size);
+        }
+
+        recordLatency(LATENCY_STAGE::LATENCY_STAGE_DEFRAME, stage_timer.elapsedNs());
+    }
+
+    m_data_source->commit(block, std::max(block.size, 0));
+}
+
+void DataSourceController::readBatch()
+{
+    Timer stage_timer;
+
+    // кадри, що пішли в чергу, замінюємо новими з пулу; пакет коротшає, якщо пул вичерпано
+    int count = 0;
+
+    for (auto & frame : m_batch)
+    {
+        if (!frame)
+            frame = acquireFrame();
+
+        if (!frame)
+            break;
+
+        m_batch_vectors[count].data = frame->data();
+        m_batch_vectors[count].size = frame->size();
+        ++count;
     }
+
+    if (!count)
+        return;
+
+    const int filled = m_data_source->readBatch(m_batch_vectors.data(), count);
+
+    recordLatency(LATENCY_STAGE::LATENCY_STAGE_READ, stage_timer.elapsedNs());
+
+    if (filled <= 0)
+        return;
+
+    stage_timer.reset();
+
+    // - браковані кадри заповнювати нулями: лише хвіст, який джерело не записало
+    for (int i = 0; i < filled; ++i)
+    {
+        const int size = m_batch_vectors[i].size;
+
+        if (size > 0 && size < m_batch[i]->size())
+            memset(m_batch[i]->data() + size, 0, m_batch[i]->size() - size);
+    }
+
+    putNewBatch(m_batch.data(), m_batch_vectors.data(), filled);
+
+    recordLatency(LATENCY_STAGE::LATENCY_STAGE_DEFRAME, stage_timer.elapsedNs());
 }
 
 DataSourceController::~DataSourceController()
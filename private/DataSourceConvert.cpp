@@ -0,0 +1,830 @@
+#include "DataSourceConvert.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define DATA_SOURCE_X86_SIMD
+#include <immintrin.h>
+#define DATA_SOURCE_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+namespace DATA_SOURCE_TASK
+{
+
+namespace
+{
+
+// Коефіцієнти нормування до +/-1.0
+constexpr float UINT8_OFFSET {128.f};
+constexpr float UINT8_SCALE {1.f / 128.f};
+constexpr float INT16_SCALE {1.f / 32768.f};
+constexpr float INT32_SCALE {1.f / 2147483648.f};
+
+using convert_kernel = void (*)(const char * src, int n, float * dst);
+
+struct convert_kernels
+{
+    convert_kernel u8;
+    convert_kernel i16;
+    convert_kernel i32;
+    convert_kernel f32;
+};
+
+// --------------   Скалярні ядра (також обробляють хвости векторних)   --------------------
+
+void u8Scalar(const char * src, int n, float * dst)
+{
+    const std::uint8_t * in = reinterpret_cast<const std::uint8_t *>(src);
+
+    for (int i = 0; i < n; ++i)
+        dst[i] = (static_cast<float>(in[i]) - UINT8_OFFSET) * UINT8_SCALE;
+}
+
+void i16Scalar(const char * src, int n, float * dst)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        std::int16_t v;
+        memcpy(&v, src + i * INT16_SIZE, INT16_SIZE);
+        dst[i] = static_cast<float>(v) * INT16_SCALE;
+    }
+}
+
+void i32Scalar(const char * src, int n, float * dst)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        std::int32_t v;
+        memcpy(&v, src + i * INT32_SIZE, INT32_SIZE);
+        dst[i] = static_cast<float>(v) * INT32_SCALE;
+    }
+}
+
+void f32Scalar(const char * src, int n, float * dst)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        float v;
+        memcpy(&v, src + i * FLOAT_SIZE, FLOAT_SIZE);
+        dst[i] = std::min(1.f, std::max(-1.f, v));
+    }
+}
+
+// --------------   Звуження float до формату запису   --------------------
+
+using record_kernel = void (*)(const float * src, int n, char * dst, float scale);
+
+struct record_kernels
+{
+    record_kernel f16;
+    record_kernel bf16;
+    record_kernel i16;
+};
+
+std::uint32_t floatBits(const float & value)
+{
+    std::uint32_t bits;
+    memcpy(&bits, &value, FLOAT_SIZE);
+    return bits;
+}
+
+float bitsFloat(const std::uint32_t & bits)
+{
+    float value;
+    memcpy(&value, &bits, FLOAT_SIZE);
+    return value;
+}
+
+// float -> half з округленням до найближчого парного, переповнення -> нескінченність
+std::uint16_t floatToHalf(const float & value)
+{
+    constexpr std::uint32_t F32_INFINITY {255u << 23};
+    constexpr std::uint32_t F16_OVERFLOW {(127u + 16u) << 23};
+    constexpr std::uint32_t F16_MIN_NORMAL {113u << 23};
+    constexpr std::uint32_t DENORM_MAGIC {((127u - 15u) + (23u - 10u) + 1u) << 23};
+
+    std::uint32_t bits       = floatBits(value);
+    const std::uint32_t sign = bits & 0x80000000u;
+
+    bits ^= sign;
+
+    std::uint16_t out;
+
+    if (bits >= F16_OVERFLOW)
+    {
+        out = bits > F32_INFINITY ? 0x7e00 : 0x7c00;
+    }
+    else if (bits < F16_MIN_NORMAL)
+    {
+        // денормалізоване half: додавання зсуває мантису на місце з округленням апаратно
+        out = static_cast<std::uint16_t>(floatBits(bitsFloat(bits) + bitsFloat(DENORM_MAGIC)) - DENORM_MAGIC);
+    }
+    else
+    {
+        const std::uint32_t mant_odd = (bits >> 13) & 1u;
+
+        bits += (static_cast<std::uint32_t>(15 - 127) << 23) + 0xfffu;
+        bits += mant_odd;
+
+        out = static_cast<std::uint16_t>(bits >> 13);
+    }
+
+    return static_cast<std::uint16_t>(out | (sign >> 16));
+}
+
+float halfToFloat(const std::uint16_t & half)
+{
+    const std::uint32_t sign = static_cast<std::uint32_t>(half & 0x8000u) << 16;
+    const std::uint32_t exp  = (half >> 10) & 0x1fu;
+    const std::uint32_t mant = half & 0x3ffu;
+
+    if (!exp)
+    {
+        // нуль або денормалізоване: mant * 2^-24
+        const float magnitude = static_cast<float>(mant) * (1.f / 16777216.f);
+        return bitsFloat(sign | floatBits(magnitude));
+    }
+
+    if (exp == 0x1fu)
+        return bitsFloat(sign | 0x7f800000u | (mant << 13));
+
+    return bitsFloat(sign | ((exp + 112u) << 23) | (mant << 13));
+}
+
+// float -> bfloat16 з округленням до найближчого парного, NaN лишається NaN
+std::uint16_t floatToBfloat(const float & value)
+{
+    const std::uint32_t bits = floatBits(value);
+
+    if ((bits & 0x7fffffffu) > 0x7f800000u)
+        return static_cast<std::uint16_t>((bits >> 16) | 0x40u);
+
+    return static_cast<std::uint16_t>((bits + 0x7fffu + ((bits >> 16) & 1u)) >> 16);
+}
+
+std::int16_t floatToInt16(const float & value, const float & scale)
+{
+    const float scaled = std::min(32767.f, std::max(-32768.f, value * scale));
+    return static_cast<std::int16_t>(std::lrint(scaled));
+}
+
+void f16RecordScalar(const float * src, int n, char * dst, float)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        const std::uint16_t v = floatToHalf(src[i]);
+        memcpy(dst + i * INT16_SIZE, &v, INT16_SIZE);
+    }
+}
+
+void bf16RecordScalar(const float * src, int n, char * dst, float)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        const std::uint16_t v = floatToBfloat(src[i]);
+        memcpy(dst + i * INT16_SIZE, &v, INT16_SIZE);
+    }
+}
+
+void i16RecordScalar(const float * src, int n, char * dst, float scale)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        const std::int16_t v = floatToInt16(src[i], scale);
+        memcpy(dst + i * INT16_SIZE, &v, INT16_SIZE);
+    }
+}
+
+#ifdef DATA_SOURCE_X86_SIMD
+
+// --------------   SSE2   --------------------
+
+DATA_SOURCE_TARGET("sse2") void u8Sse2(const char * src, int n, float * dst)
+{
+    const __m128i zero   = _mm_setzero_si128();
+    const __m128 scale   = _mm_set1_ps(UINT8_SCALE);
+    const __m128 one     = _mm_set1_ps(1.f);
+    int i                = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        const __m128i lo = _mm_unpacklo_epi8(v, zero);
+        const __m128i hi = _mm_unpackhi_epi8(v, zero);
+
+        // (x * 1/128) - 1 == (x - 128) / 128
+        _mm_storeu_ps(dst + i, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale), one));
+        _mm_storeu_ps(dst + i + 4, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale), one));
+        _mm_storeu_ps(dst + i + 8, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale), one));
+        _mm_storeu_ps(dst + i + 12, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale), one));
+    }
+
+    u8Scalar(src + i, n - i, dst + i);
+}
+
+DATA_SOURCE_TARGET("sse2") void i16Sse2(const char * src, int n, float * dst)
+{
+    const __m128 scale = _mm_set1_ps(INT16_SCALE);
+    int i              = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * INT16_SIZE));
+
+        // розширення зі знаком: старші 16 біт заповнюємо копією і зсуваємо арифметично
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+
+    i16Scalar(src + i * INT16_SIZE, n - i, dst + i);
+}
+
+DATA_SOURCE_TARGET("sse2") void i32Sse2(const char * src, int n, float * dst)
+{
+    const __m128 scale = _mm_set1_ps(INT32_SCALE);
+    int i              = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * INT32_SIZE));
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(v), scale));
+    }
+
+    i32Scalar(src + i * INT32_SIZE, n - i, dst + i);
+}
+
+DATA_SOURCE_TARGET("sse2") void f32Sse2(const char * src, int n, float * dst)
+{
+    const __m128 lo = _mm_set1_ps(-1.f);
+    const __m128 hi = _mm_set1_ps(1.f);
+    int i           = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m128 v = _mm_loadu_ps(reinterpret_cast<const float *>(src + i * FLOAT_SIZE));
+        _mm_storeu_ps(dst + i, _mm_min_ps(_mm_max_ps(v, lo), hi));
+    }
+
+    f32Scalar(src + i * FLOAT_SIZE, n - i, dst + i);
+}
+
+// --------------   AVX2   --------------------
+
+DATA_SOURCE_TARGET("avx2") void u8Avx2(const char * src, int n, float * dst)
+{
+    const __m256 scale = _mm256_set1_ps(UINT8_SCALE);
+    const __m256 one   = _mm256_set1_ps(1.f);
+    int i              = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        const __m256i lo = _mm256_cvtepu8_epi32(v);
+        const __m256i hi = _mm256_cvtepu8_epi32(_mm_srli_si128(v, 8));
+
+        _mm256_storeu_ps(dst + i, _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(lo), scale), one));
+        _mm256_storeu_ps(dst + i + 8, _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(hi), scale), one));
+    }
+
+    u8Scalar(src + i, n - i, dst + i);
+}
+
+DATA_SOURCE_TARGET("avx2") void i16Avx2(const char * src, int n, float * dst)
+{
+    const __m256 scale = _mm256_set1_ps(INT16_SCALE);
+    int i              = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m256i v  = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * INT16_SIZE));
+        const __m256i lo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(v));
+        const __m256i hi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(v, 1));
+
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), scale));
+        _mm256_storeu_ps(dst + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), scale));
+    }
+
+    i16Scalar(src + i * INT16_SIZE, n - i, dst + i);
+}
+
+DATA_SOURCE_TARGET("avx2") void i32Avx2(const char * src, int n, float * dst)
+{
+    const __m256 scale = _mm256_set1_ps(INT32_SCALE);
+    int i              = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * INT32_SIZE));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+
+    i32Scalar(src + i * INT32_SIZE, n - i, dst + i);
+}
+
+DATA_SOURCE_TARGET("avx2") void f32Avx2(const char * src, int n, float * dst)
+{
+    const __m256 lo = _mm256_set1_ps(-1.f);
+    const __m256 hi = _mm256_set1_ps(1.f);
+    int i           = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m256 v = _mm256_loadu_ps(reinterpret_cast<const float *>(src + i * FLOAT_SIZE));
+        _mm256_storeu_ps(dst + i, _mm256_min_ps(_mm256_max_ps(v, lo), hi));
+    }
+
+    f32Scalar(src + i * FLOAT_SIZE, n - i, dst + i);
+}
+
+// --------------   AVX-512   --------------------
+
+// GCC 12 вважає невизначене джерело (_mm512_undefined_*) в немаскованих інтринсиках avx512fintrin.h
+// неініціалізованим (-Wmaybe-uninitialized), хоча всі елементи результату перезаписуються
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+DATA_SOURCE_TARGET("avx512f") void u8Avx512(const char * src, int n, float * dst)
+{
+    const __m512 scale = _mm512_set1_ps(UINT8_SCALE);
+    const __m512 one   = _mm512_set1_ps(1.f);
+    int i              = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m512i v = _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)));
+        _mm512_storeu_ps(dst + i, _mm512_sub_ps(_mm512_mul_ps(_mm512_cvtepi32_ps(v), scale), one));
+    }
+
+    u8Scalar(src + i, n - i, dst + i);
+}
+
+DATA_SOURCE_TARGET("avx512f") void i16Avx512(const char * src, int n, float * dst)
+{
+    const __m512 scale = _mm512_set1_ps(INT16_SCALE);
+    int i              = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m512i v = _mm512_cvtepi16_epi32(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * INT16_SIZE)));
+        _mm512_storeu_ps(dst + i, _mm512_mul_ps(_mm512_cvtepi32_ps(v), scale));
+    }
+
+    i16Scalar(src + i * INT16_SIZE, n - i, dst + i);
+}
+
+DATA_SOURCE_TARGET("avx512f") void i32Avx512(const char * src, int n, float * dst)
+{
+    const __m512 scale = _mm512_set1_ps(INT32_SCALE);
+    int i              = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m512i v = _mm512_loadu_si512(src + i * INT32_SIZE);
+        _mm512_storeu_ps(dst + i, _mm512_mul_ps(_mm512_cvtepi32_ps(v), scale));
+    }
+
+    i32Scalar(src + i * INT32_SIZE, n - i, dst + i);
+}
+
+DATA_SOURCE_TARGET("avx512f") void f32Avx512(const char * src, int n, float * dst)
+{
+    const __m512 lo = _mm512_set1_ps(-1.f);
+    const __m512 hi = _mm512_set1_ps(1.f);
+    int i           = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m512 v = _mm512_loadu_ps(src + i * FLOAT_SIZE);
+        _mm512_storeu_ps(dst + i, _mm512_min_ps(_mm512_max_ps(v, lo), hi));
+    }
+
+    f32Scalar(src + i * FLOAT_SIZE, n - i, dst + i);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+// --------------   Звуження до формату запису: SSE2, AVX2 + F16C   --------------------
+
+// bfloat16 з округленням до парного для 4 відліків, результат - 32 bit зі знаковим розширенням для packs
+DATA_SOURCE_TARGET("sse2") __m128i bfloatSse2(const __m128 v)
+{
+    const __m128i bits    = _mm_castps_si128(v);
+    const __m128i lsb     = _mm_and_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(1));
+    const __m128i rounded = _mm_add_epi32(bits, _mm_add_epi32(_mm_set1_epi32(0x7fff), lsb));
+    const __m128i nan     = _mm_or_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(0x40));
+    const __m128i is_nan  = _mm_castps_si128(_mm_cmpunord_ps(v, v));
+
+    const __m128i out = _mm_or_si128(_mm_and_si128(is_nan, nan), _mm_andnot_si128(is_nan, _mm_srli_epi32(rounded, 16)));
+
+    // packs_epi32 насичує знакові значення: зсув 16 -> 32 зберігає молодші 16 біт
+    return _mm_srai_epi32(_mm_slli_epi32(out, 16), 16);
+}
+
+DATA_SOURCE_TARGET("sse2") void bf16RecordSse2(const float * src, int n, char * dst, float scale)
+{
+    int i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m128i lo = bfloatSse2(_mm_loadu_ps(src + i));
+        const __m128i hi = bfloatSse2(_mm_loadu_ps(src + i + 4));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * INT16_SIZE), _mm_packs_epi32(lo, hi));
+    }
+
+    bf16RecordScalar(src + i, n - i, dst + i * INT16_SIZE, scale);
+}
+
+DATA_SOURCE_TARGET("sse2") void i16RecordSse2(const float * src, int n, char * dst, float scale)
+{
+    const __m128 factor = _mm_set1_ps(scale);
+    const __m128 lo     = _mm_set1_ps(-32768.f);
+    const __m128 hi     = _mm_set1_ps(32767.f);
+    int i               = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m128 a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i), factor), lo), hi);
+        const __m128 b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i + 4), factor), lo), hi);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * INT16_SIZE),
+                         _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+    }
+
+    i16RecordScalar(src + i, n - i, dst + i * INT16_SIZE, scale);
+}
+
+DATA_SOURCE_TARGET("avx2,f16c") void f16RecordAvx2(const float * src, int n, char * dst, float scale)
+{
+    int i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m128i v = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * INT16_SIZE), v);
+    }
+
+    f16RecordScalar(src + i, n - i, dst + i * INT16_SIZE, scale);
+}
+
+DATA_SOURCE_TARGET("avx2") __m256i bfloatAvx2(const __m256 v)
+{
+    const __m256i bits    = _mm256_castps_si256(v);
+    const __m256i lsb     = _mm256_and_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(1));
+    const __m256i rounded = _mm256_add_epi32(bits, _mm256_add_epi32(_mm256_set1_epi32(0x7fff), lsb));
+    const __m256i nan     = _mm256_or_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(0x40));
+    const __m256i is_nan  = _mm256_castps_si256(_mm256_cmp_ps(v, v, _CMP_UNORD_Q));
+
+    const __m256i out = _mm256_blendv_epi8(_mm256_srli_epi32(rounded, 16), nan, is_nan);
+
+    return _mm256_srai_epi32(_mm256_slli_epi32(out, 16), 16);
+}
+
+DATA_SOURCE_TARGET("avx2") void bf16RecordAvx2(const float * src, int n, char * dst, float scale)
+{
+    int i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m256i lo = bfloatAvx2(_mm256_loadu_ps(src + i));
+        const __m256i hi = bfloatAvx2(_mm256_loadu_ps(src + i + 8));
+
+        // packs працює в межах 128-бітних половин: [lo0 hi0 lo1 hi1] -> [lo0 lo1 hi0 hi1]
+        const __m256i v = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xd8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i * INT16_SIZE), v);
+    }
+
+    bf16RecordScalar(src + i, n - i, dst + i * INT16_SIZE, scale);
+}
+
+DATA_SOURCE_TARGET("avx2") void i16RecordAvx2(const float * src, int n, char * dst, float scale)
+{
+    const __m256 factor = _mm256_set1_ps(scale);
+    const __m256 lo     = _mm256_set1_ps(-32768.f);
+    const __m256 hi     = _mm256_set1_ps(32767.f);
+    int i               = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m256 a = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i), factor), lo), hi);
+        const __m256 b = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i + 8), factor), lo), hi);
+
+        const __m256i v =
+            _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b)), 0xd8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i * INT16_SIZE), v);
+    }
+
+    i16RecordScalar(src + i, n - i, dst + i * INT16_SIZE, scale);
+}
+
+#endif // DATA_SOURCE_X86_SIMD
+
+// Таблиця ядер, індекс - DATA_SOURCE_SIMD_LEVEL
+const convert_kernels g_kernels[static_cast<int>(DATA_SOURCE_SIMD_LEVEL::DATA_SOURCE_SIMD_LEVEL_SIZE)] = {
+    {u8Scalar, i16Scalar, i32Scalar, f32Scalar},
+#ifdef DATA_SOURCE_X86_SIMD
+    {u8Sse2, i16Sse2, i32Sse2, f32Sse2},
+    {u8Avx2, i16Avx2, i32Avx2, f32Avx2},
+    {u8Avx512, i16Avx512, i32Avx512, f32Avx512},
+#else
+    {u8Scalar, i16Scalar, i32Scalar, f32Scalar},
+    {u8Scalar, i16Scalar, i32Scalar, f32Scalar},
+    {u8Scalar, i16Scalar, i32Scalar, f32Scalar},
+#endif
+};
+
+// Таблиця ядер звуження, індекс - DATA_SOURCE_SIMD_LEVEL. AVX-512 використовує ядра AVX2.
+// float16 без F16C (SSE2) - скалярно; на рівні AVX2 F16C перевіряється окремо в recordKernels().
+const record_kernels g_record_kernels[static_cast<int>(DATA_SOURCE_SIMD_LEVEL::DATA_SOURCE_SIMD_LEVEL_SIZE)] = {
+    {f16RecordScalar, bf16RecordScalar, i16RecordScalar},
+#ifdef DATA_SOURCE_X86_SIMD
+    {f16RecordScalar, bf16RecordSse2, i16RecordSse2},
+    {f16RecordAvx2, bf16RecordAvx2, i16RecordAvx2},
+    {f16RecordAvx2, bf16RecordAvx2, i16RecordAvx2},
+#else
+    {f16RecordScalar, bf16RecordScalar, i16RecordScalar},
+    {f16RecordScalar, bf16RecordScalar, i16RecordScalar},
+    {f16RecordScalar, bf16RecordScalar, i16RecordScalar},
+#endif
+};
+
+bool detectF16c()
+{
+#ifdef DATA_SOURCE_X86_SIMD
+    __builtin_cpu_init();
+
+    return __builtin_cpu_supports("f16c");
+#else
+    return false;
+#endif
+}
+
+DATA_SOURCE_SIMD_LEVEL detectSimdLevel()
+{
+#ifdef DATA_SOURCE_X86_SIMD
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f"))
+        return DATA_SOURCE_SIMD_LEVEL::DATA_SOURCE_SIMD_LEVEL_AVX512;
+
+    if (__builtin_cpu_supports("avx2"))
+        return DATA_SOURCE_SIMD_LEVEL::DATA_SOURCE_SIMD_LEVEL_AVX2;
+
+    if (__builtin_cpu_supports("sse2"))
+        return DATA_SOURCE_SIMD_LEVEL::DATA_SOURCE_SIMD_LEVEL_SSE2;
+#endif
+    return DATA_SOURCE_SIMD_LEVEL::DATA_SOURCE_SIMD_LEVEL_SCALAR;
+}
+
+std::atomic<int> & activeLevel()
+{
+    static std::atomic<int> level {static_cast<int>(detectedSimdLevel())};
+    return level;
+}
+
+} // namespace
+
+DATA_SOURCE_SIMD_LEVEL detectedSimdLevel()
+{
+    static const DATA_SOURCE_SIMD_LEVEL level = detectSimdLevel();
+    return level;
+}
+
+DATA_SOURCE_SIMD_LEVEL simdLevel()
+{
+    return static_cast<DATA_SOURCE_SIMD_LEVEL>(activeLevel().load(std::memory_order_relaxed));
+}
+
+void setSimdLevel(const DATA_SOURCE_SIMD_LEVEL & level)
+{
+    activeLevel() = std::min(static_cast<int>(level), static_cast<int>(detectedSimdLevel()));
+}
+
+const char * simdLevelName(const DATA_SOURCE_SIMD_LEVEL & level)
+{
+    switch (level)
+    {
+    case DATA_SOURCE_SIMD_LEVEL::DATA_SOURCE_SIMD_LEVEL_SCALAR:
+        return "scalar";
+    case DATA_SOURCE_SIMD_LEVEL::DATA_SOURCE_SIMD_LEVEL_SSE2:
+        return "sse2";
+    case DATA_SOURCE_SIMD_LEVEL::DATA_SOURCE_SIMD_LEVEL_AVX2:
+        return "avx2";
+    case DATA_SOURCE_SIMD_LEVEL::DATA_SOURCE_SIMD_LEVEL_AVX512:
+        return "avx512";
+    default:
+        break;
+    }
+
+    return "unknown";
+}
+
+int payloadTypeSize(const PAYLOAD_TYPE & p_type)
+{
+    switch (p_type)
+    {
+    case PAYLOAD_TYPE::PAYLOAD_TYPE_8_BIT_UINT:
+        return UINT8_SIZE;
+    case PAYLOAD_TYPE::PAYLOAD_TYPE_16_BIT_INT:
+        return INT16_SIZE;
+    case PAYLOAD_TYPE::PAYLOAD_TYPE_32_BIT_INT:
+        return INT32_SIZE;
+    case PAYLOAD_TYPE::PAYLOAD_TYPE_32_BIT_IEEE_FLOAT:
+        return FLOAT_SIZE;
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+void convertFromFloat(const PAYLOAD_TYPE & p_type, const float * src, const int & count, char * dst)
+{
+    switch (p_type)
+    {
+    case PAYLOAD_TYPE::PAYLOAD_TYPE_8_BIT_UINT:
+        for (int i = 0; i < count; ++i)
+        {
+            const float scaled = std::min(255.f, std::max(0.f, src[i] / UINT8_SCALE + UINT8_OFFSET));
+            dst[i]             = static_cast<char>(static_cast<std::uint8_t>(std::lrint(scaled)));
+        }
+        break;
+    case PAYLOAD_TYPE::PAYLOAD_TYPE_16_BIT_INT:
+        for (int i = 0; i < count; ++i)
+        {
+            const float scaled   = std::min(32767.f, std::max(-32768.f, src[i] / INT16_SCALE));
+            const std::int16_t v = static_cast<std::int16_t>(std::lrint(scaled));
+            memcpy(dst + i * INT16_SIZE, &v, INT16_SIZE);
+        }
+        break;
+    case PAYLOAD_TYPE::PAYLOAD_TYPE_32_BIT_INT:
+        for (int i = 0; i < count; ++i)
+        {
+            // double: 2^31 - 1 не представляється у float
+            const double scaled  = std::min(2147483647., std::max(-2147483648., src[i] * 2147483648.));
+            const std::int32_t v = static_cast<std::int32_t>(std::llrint(scaled));
+            memcpy(dst + i * INT32_SIZE, &v, INT32_SIZE);
+        }
+        break;
+    case PAYLOAD_TYPE::PAYLOAD_TYPE_32_BIT_IEEE_FLOAT:
+        memcpy(dst, src, static_cast<std::size_t>(count) * FLOAT_SIZE);
+        break;
+    default:
+        break;
+    }
+}
+
+int recordFormatSize(const RECORD_FORMAT & format)
+{
+    switch (format)
+    {
+    case RECORD_FORMAT::RECORD_FORMAT_FLOAT32:
+        return FLOAT_SIZE;
+    case RECORD_FORMAT::RECORD_FORMAT_FLOAT16:
+    case RECORD_FORMAT::RECORD_FORMAT_BFLOAT16:
+    case RECORD_FORMAT::RECORD_FORMAT_INT16:
+        return INT16_SIZE;
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+const char * recordFormatName(const RECORD_FORMAT & format)
+{
+    switch (format)
+    {
+    case RECORD_FORMAT::RECORD_FORMAT_FLOAT32:
+        return "f32";
+    case RECORD_FORMAT::RECORD_FORMAT_FLOAT16:
+        return "f16";
+    case RECORD_FORMAT::RECORD_FORMAT_BFLOAT16:
+        return "bf16";
+    case RECORD_FORMAT::RECORD_FORMAT_INT16:
+        return "i16";
+    default:
+        break;
+    }
+
+    return "unknown";
+}
+
+void convertToRecord(
+    const RECORD_FORMAT & format,
+    const float * src,
+    const int & count,
+    char * dst,
+    const float & scale)
+{
+    static const bool has_f16c = detectF16c();
+
+    if (count <= 0)
+        return;
+
+    const int level                = activeLevel().load(std::memory_order_relaxed);
+    const record_kernels & kernels = g_record_kernels[level];
+
+    switch (format)
+    {
+    case RECORD_FORMAT::RECORD_FORMAT_FLOAT32:
+        memcpy(dst, src, static_cast<std::size_t>(count) * FLOAT_SIZE);
+        break;
+    case RECORD_FORMAT::RECORD_FORMAT_FLOAT16:
+        (has_f16c ? kernels.f16 : f16RecordScalar)(src, count, dst, scale);
+        break;
+    case RECORD_FORMAT::RECORD_FORMAT_BFLOAT16:
+        kernels.bf16(src, count, dst, scale);
+        break;
+    case RECORD_FORMAT::RECORD_FORMAT_INT16:
+        kernels.i16(src, count, dst, scale);
+        break;
+    default:
+        break;
+    }
+}
+
+void convertFromRecord(
+    const RECORD_FORMAT & format,
+    const char * src,
+    const int & count,
+    float * dst,
+    const float & scale)
+{
+    std::uint16_t v;
+
+    switch (format)
+    {
+    case RECORD_FORMAT::RECORD_FORMAT_FLOAT32:
+        memcpy(dst, src, static_cast<std::size_t>(std::max(count, 0)) * FLOAT_SIZE);
+        break;
+    case RECORD_FORMAT::RECORD_FORMAT_FLOAT16:
+        for (int i = 0; i < count; ++i)
+        {
+            memcpy(&v, src + i * INT16_SIZE, INT16_SIZE);
+            dst[i] = halfToFloat(v);
+        }
+        break;
+    case RECORD_FORMAT::RECORD_FORMAT_BFLOAT16:
+        for (int i = 0; i < count; ++i)
+        {
+            memcpy(&v, src + i * INT16_SIZE, INT16_SIZE);
+            dst[i] = bitsFloat(static_cast<std::uint32_t>(v) << 16);
+        }
+        break;
+    case RECORD_FORMAT::RECORD_FORMAT_INT16:
+        for (int i = 0; i < count; ++i)
+        {
+            memcpy(&v, src + i * INT16_SIZE, INT16_SIZE);
+            dst[i] = static_cast<float>(static_cast<std::int16_t>(v)) / scale;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+int convertToFloat(const PAYLOAD_TYPE & p_type, const char * src, const int & payload_size, float * dst)
+{
+    const convert_kernels & kernels = g_kernels[activeLevel().load(std::memory_order_relaxed)];
+
+    const int type_size = payloadTypeSize(p_type);
+
+    if (!type_size || payload_size <= 0)
+        return 0;
+
+    const int total_elements = payload_size / type_size;
+
+    switch (p_type)
+    {
+    case PAYLOAD_TYPE::PAYLOAD_TYPE_8_BIT_UINT:
+        kernels.u8(src, total_elements, dst);
+        break;
+    case PAYLOAD_TYPE::PAYLOAD_TYPE_16_BIT_INT:
+        kernels.i16(src, total_elements, dst);
+        break;
+    case PAYLOAD_TYPE::PAYLOAD_TYPE_32_BIT_INT:
+        kernels.i32(src, total_elements, dst);
+        break;
+    case PAYLOAD_TYPE::PAYLOAD_TYPE_32_BIT_IEEE_FLOAT:
+        kernels.f32(src, total_elements, dst);
+        break;
+    default:
+        return 0;
+    }
+
+    return total_elements;
+}
+
+} // namespace DATA_SOURCE_TASK
@@ -0,0 +1,182 @@
+#include "DataSourceDeframer.h"
+#include "DataSourceConvert.h"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace DATA_SOURCE_TASK
+{
+
+// Накопичувач вміщує кілька кадрів, щоб зсув залишку на початок був рідкісним
+static constexpr std::uint32_t DEFRAMER_BUFFER_FRAMES {4};
+
+int findMagicWord(const char * data, const int & size, const std::uint32_t & magic_word)
+{
+    constexpr int magic_size = sizeof(magic_word);
+
+    int i = 0;
+
+#if defined(__SSE2__)
+    // Кандидати - позиції, де збігаються два перших байти magic_word, далі перевіряємо всі 4 байти
+    const __m128i first  = _mm_set1_epi8(static_cast<char>(magic_word & 0xff));
+    const __m128i second = _mm_set1_epi8(static_cast<char>((magic_word >> 8) & 0xff));
+
+    for (; i + 16 + 1 <= size; i += 16)
+    {
+        const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + 1));
+
+        unsigned mask = static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(v0, first), _mm_cmpeq_epi8(v1, second))));
+
+        while (mask)
+        {
+            const int pos = i + __builtin_ctz(mask);
+
+            if (pos + magic_size <= size && memcmp(data + pos, &magic_word, magic_size) == 0)
+                return pos;
+
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    for (; i + magic_size <= size; ++i)
+    {
+        if (memcmp(data + i, &magic_word, magic_size) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+DataSourceDeframer::DataSourceDeframer(const std::uint32_t & max_frame_size, const std::uint32_t & magic_word):
+    m_max_frame_size {max_frame_size},
+    m_magic_word {magic_word}
+{
+    m_buffer.resize(DEFRAMER_BUFFER_FRAMES * m_max_frame_size);
+}
+
+bool DataSourceDeframer::isValidHeader(const struct frame & frm) const
+{
+    if (frm.magic_word != m_magic_word)
+        return false;
+
+    const int type_size = payloadTypeSize(frm.payload_type);
+
+    // розмір даних має бути кратним типу даних і вміщатись в кадр
+    return type_size && frm.payload_size && (frm.payload_size <= m_max_frame_size - FRAME_HEADER_SIZE)
+           && (frm.payload_size % type_size == 0);
+}
+
+int DataSourceDeframer::completeFrameSize(const char * data, const int & size) const
+{
+    if (size < static_cast<int>(FRAME_HEADER_SIZE))
+        return 0;
+
+    struct frame frm;
+    memcpy(&frm, data, FRAME_HEADER_SIZE);
+
+    if (!isValidHeader(frm))
+        return 0;
+
+    const int total = FRAME_HEADER_SIZE + frm.payload_size;
+
+    return total <= size ? total : 0;
+}
+
+void DataSourceDeframer::push(const char * data, const int & size)
+{
+    if (size <= 0)
+        return;
+
+    // не вистачає місця в кінці - зсуваємо залишок на початок
+    if (m_end + size > static_cast<int>(m_buffer.size()))
+    {
+        const int left = pending();
+
+        memmove(m_buffer.data(), m_buffer.data() + m_begin, left);
+
+        m_begin = 0;
+        m_end   = left;
+
+        if (m_end + size > static_cast<int>(m_buffer.size()))
+            m_buffer.resize(m_end + size);
+    }
+
+    memcpy(m_buffer.data() + m_end, data, size);
+    m_end += size;
+}
+
+void DataSourceDeframer::resync()
+{
+    constexpr int magic_size = sizeof(m_magic_word);
+
+    if (m_in_sync)
+    {
+        ++m_resyncs;
+        m_in_sync = false;
+    }
+
+    const char * data = m_buffer.data() + m_begin;
+
+    // поточна позиція вже перевірена, шукаємо з наступного байта
+    const int offset = findMagicWord(data + 1, pending() - 1, m_magic_word);
+
+    int skip = 0;
+
+    if (offset >= 0)
+        skip = offset + 1;
+    else
+        skip = pending() > magic_size - 1 ? pending() - (magic_size - 1) : 0; // хвіст може бути початком magic_word
+
+    m_begin += skip;
+    m_skipped_bytes += skip;
+}
+
+int DataSourceDeframer::next(DataSourceBufferInterface & frame)
+{
+    while (pending() >= static_cast<int>(FRAME_HEADER_SIZE))
+    {
+        const char * data = m_buffer.data() + m_begin;
+
+        struct frame frm;
+        memcpy(&frm, data, FRAME_HEADER_SIZE);
+
+        if (frm.magic_word != m_magic_word)
+        {
+            resync();
+            continue;
+        }
+
+        if (!isValidHeader(frm) || static_cast<int>(FRAME_HEADER_SIZE + frm.payload_size) > frame.size())
+        {
+            ++m_broken_headers;
+            resync();
+            continue;
+        }
+
+        const int total = FRAME_HEADER_SIZE + frm.payload_size;
+
+        // чекаємо решту корисних даних
+        if (pending() < total)
+            return 0;
+
+        memcpy(frame.data(), data, total);
+
+        m_begin += total;
+        m_in_sync = true;
+
+        if (m_begin == m_end)
+            m_begin = m_end = 0;
+
+        return total;
+    }
+
+    return 0;
+}
+
+} // namespace DATA_SOURCE_TASK
@@ -1,172 +1,301 @@
 #include "DataSourceEmulator.h"
+#include "DataSourceConvert.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <iostream>
 #include <mutex>
 
 namespace DATA_SOURCE_TASK
 {
 
-constexpr bool is_used_random {false};
+namespace
+{
+
+// Межа пропущених поспіль кадрів: сценарій, що губить все, не повинен зациклити читання
+constexpr int EMULATOR_MAX_LOSS_RUN {1 << 20};
+
+constexpr double TWO_PI {6.283185307179586};
 
-float randMinToMax(const float & min, const float & max)
+/// \brief splitmix64: власний генератор кожного емулятора, на відміну від rand() не має спільного стану
+std::uint64_t nextRandom(std::uint64_t & state)
 {
-    return min + (rand() / (RAND_MAX / (max - min)));
+    std::uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+
+    return z ^ (z >> 31);
 }
 
-DataSourceFileEmulator::DataSourceFileEmulator(const DATA_SOURCE_TASK::PAYLOAD_TYPE & p_type,
-                                               const int & frame_size):
-    DataSource()
+} // namespace
+
+std::vector<emulator_fault> defaultEmulatorFaults()
 {
-    try
-    {
-        m_buffer = std::make_shared<DATA_SOURCE_TASK::DataSourceBuffer<std::uint8_t>>(frame_size);
-    }
-    catch (const std::exception & e)
-    {
-        std::runtime_error(e.what()); // треба використовувати власні обгортки над стандартнимим виключеннями
-    }
+    emulator_fault short_read;
+    short_read.type  = EMULATOR_FAULT::EMULATOR_FAULT_SHORT_READ;
+    short_read.count = 5;
+    short_read.value = 2;
+
+    // лічильник 1000, 2000, ...
+    emulator_fault source_id;
+    source_id.frame  = 999;
+    source_id.type   = EMULATOR_FAULT::EMULATOR_FAULT_SOURCE_ID;
+    source_id.value  = 1;
+    source_id.period = 1000;
+
+    return {short_read, source_id};
+}
 
-    if (m_buffer->frame())
-    {
-        m_buffer->setHeader(0xf113); // file
-        m_buffer->setFrameCounter(0);
-        m_buffer->setSourceID(1);
-        m_buffer->setPayloadType(p_type);
-    }
-    else
-    {
-        std::cout << "DataSourceFileEmulator: no frame" << std::endl;
-    }
+DataSourceFileEmulator::DataSourceFileEmulator(
+    const DATA_SOURCE_TASK::PAYLOAD_TYPE & p_type,
+    const int & frame_size,
+    const emulator_config & config):
+    DataSource(),
+    m_config {config},
+    m_frame_size {std::max(frame_size, static_cast<int>(FRAME_HEADER_SIZE))},
+    m_source_id {config.source_id}
+{
+    // навантаження кожного шаблону вирівняне, заголовок - перед ним
+    m_stride = (static_cast<std::size_t>(m_frame_size) + EMULATOR_PAYLOAD_ALIGNMENT - 1) / EMULATOR_PAYLOAD_ALIGNMENT
+        * EMULATOR_PAYLOAD_ALIGNMENT;
+
+    const int template_count = std::max(m_config.template_count, 1);
+
+    m_templates.assign(EMULATOR_PAYLOAD_ALIGNMENT + m_stride * template_count, 0);
 
-    srand((unsigned int) time(NULL));
-    generateRandom();
+    generateTemplates(p_type);
+
+    // перший read() почне з нового кадру
+    m_stream_pos = m_frame_size;
 }
 
 DataSourceFileEmulator::~DataSourceFileEmulator() {}
 
-void DataSourceFileEmulator::generateRandom()
+void DataSourceFileEmulator::generateTemplates(const PAYLOAD_TYPE & p_type)
 {
-    float val = 1.f;
+    const int template_count = std::max(m_config.template_count, 1);
+    const int payload_size   = m_frame_size - static_cast<int>(FRAME_HEADER_SIZE);
+    const int type_size      = payloadTypeSize(p_type);
+    const int elements       = type_size ? payload_size / type_size : 0;
 
-    if (!is_used_random)
-        val += 1.f;
+    if (!type_size)
+        std::cout << "DataSourceFileEmulator: unsupported payload type, frames are zero" << std::endl;
 
-    switch (m_buffer->frame()->payload_type)
-    {
-    case PAYLOAD_TYPE::PAYLOAD_TYPE_8_BIT_UINT:
+    // сигнал безперервний через всі шаблони
+    const double total = static_cast<double>(elements) * template_count;
+    const double a     = std::min(1.f, std::max(0.f, m_config.amplitude));
+
+    std::uint64_t random_state = m_config.seed;
+    std::vector<float> samples(static_cast<std::size_t>(elements));
+
+    for (int k = 0; k < template_count; ++k)
     {
-        std::uint8_t * payload = reinterpret_cast<std::uint8_t *>(m_buffer->payload());
+        char * frame = m_templates.data() + EMULATOR_PAYLOAD_ALIGNMENT - FRAME_HEADER_SIZE + m_stride * k;
 
-        const uint32_t total_elements = m_buffer->payloadSize() / UINT8_SIZE;
+        struct frame * header = reinterpret_cast<struct frame *>(frame);
 
-        for (uint32_t i = 0; i < total_elements; ++i)
-        {
-            if (is_used_random)
-                val = randMinToMax(0, UINT8_MAX);
+        header->magic_word    = FRAME_MAGIC_WORD;
+        header->frame_counter = 0;
+        header->source_id     = m_source_id;
+        header->payload_type  = p_type;
+        header->payload_size  = static_cast<std::uint32_t>(payload_size);
 
-            payload[i] = static_cast<std::uint8_t>(val);
+        for (int i = 0; i < elements; ++i)
+        {
+            const double n = static_cast<double>(k) * elements + i;
+            double value   = a;
+
+            switch (m_config.signal)
+            {
+            case EMULATOR_SIGNAL::EMULATOR_SIGNAL_SINE:
+                value = a * std::sin(TWO_PI * m_config.frequency * n);
+                break;
+            case EMULATOR_SIGNAL::EMULATOR_SIGNAL_CHIRP:
+                value = a
+                    * std::sin(TWO_PI
+                               * (m_config.frequency * n
+                                  + (m_config.frequency_end - m_config.frequency) * n * n / (2. * total)));
+                break;
+            case EMULATOR_SIGNAL::EMULATOR_SIGNAL_NOISE:
+                // старші 24 біти -> [-1, 1)
+                value = a * (static_cast<double>(nextRandom(random_state) >> 40) / 8388608. - 1.);
+                break;
+            default:
+                break;
+            }
+
+            samples[i] = static_cast<float>(value);
         }
+
+        convertFromFloat(p_type, samples.data(), elements, frame + FRAME_HEADER_SIZE);
     }
-    break;
+}
 
-    case PAYLOAD_TYPE::PAYLOAD_TYPE_16_BIT_INT:
-    {
-        std::int16_t * payload = reinterpret_cast<std::int16_t *>(m_buffer->payload());
+bool DataSourceFileEmulator::isFaultAt(const emulator_fault & fault, const std::uint64_t & frame)
+{
+    if (frame < fault.frame)
+        return false;
 
-        const uint32_t total_elements = m_buffer->payloadSize() / INT16_SIZE;
+    const std::uint64_t offset = frame - fault.frame;
 
-        for (uint32_t i = 0; i < total_elements; ++i)
-        {
-            if (is_used_random)
-                val = randMinToMax(INT16_MIN, INT16_MAX);
+    return (fault.period ? offset % fault.period : offset) < fault.count;
+}
 
-            payload[i] = static_cast<std::int16_t>(val);
-        }
+void DataSourceFileEmulator::nextFrame()
+{
+    // попередній кадр-шаблон знову цілий
+    if (m_corrupt_offset >= 0)
+    {
+        m_frame[m_corrupt_offset] = m_corrupt_byte;
+        m_corrupt_offset          = -1;
     }
-    break;
 
-    case PAYLOAD_TYPE::PAYLOAD_TYPE_32_BIT_INT:
+    for (int run = 0; run < EMULATOR_MAX_LOSS_RUN; ++run)
     {
-        std::int32_t * payload = reinterpret_cast<std::int32_t *>(m_buffer->payload());
+        const bool is_lost =
+            std::any_of(m_config.faults.begin(), m_config.faults.end(), [this](const emulator_fault & f) {
+                return f.type == EMULATOR_FAULT::EMULATOR_FAULT_LOSS && isFaultAt(f, m_frame_index);
+            });
+
+        if (!is_lost)
+            break;
+
+        ++m_frame_index;
+        ++m_lost;
+    }
 
-        const uint32_t total_elements = m_buffer->payloadSize() / INT32_SIZE;
+    const std::size_t template_count = static_cast<std::size_t>(std::max(m_config.template_count, 1));
 
-        for (uint32_t i = 0; i < total_elements; ++i)
+    m_frame = m_templates.data() + EMULATOR_PAYLOAD_ALIGNMENT - FRAME_HEADER_SIZE
+        + m_stride * static_cast<std::size_t>(m_frame_index % template_count);
+
+    m_read_divider = 1;
+
+    for (const auto & fault : m_config.faults)
+    {
+        if (!isFaultAt(fault, m_frame_index))
+            continue;
+
+        switch (fault.type)
+        {
+        case EMULATOR_FAULT::EMULATOR_FAULT_SHORT_READ:
+            m_read_divider = std::max(m_read_divider, fault.value);
+            break;
+        case EMULATOR_FAULT::EMULATOR_FAULT_SOURCE_ID:
         {
-            if (is_used_random)
-                val = randMinToMax(INT32_MIN, INT32_MAX);
+            // діє на перший кадр кроку, далі ІД лишається
+            const std::uint64_t offset = m_frame_index - fault.frame;
 
-            payload[i] = static_cast<std::int32_t>(val);
+            if ((fault.period ? offset % fault.period : offset) == 0)
+                m_source_id = static_cast<std::uint8_t>(m_source_id + fault.value);
+        }
+        break;
+        default:
+            break;
         }
     }
-    break;
 
-    case PAYLOAD_TYPE::PAYLOAD_TYPE_32_BIT_IEEE_FLOAT:
-    {
-        float * payload = reinterpret_cast<float *>(m_buffer->payload());
-        const uint32_t total_elements = m_buffer->payloadSize() / FLOAT_SIZE;
+    struct frame * header = reinterpret_cast<struct frame *>(m_frame);
+
+    // лічильник першого кадру - 1
+    header->magic_word    = FRAME_MAGIC_WORD;
+    header->frame_counter = static_cast<std::uint16_t>(m_frame_index + 1);
+    header->source_id     = m_source_id;
 
-        for (uint32_t i = 0; i < total_elements; ++i)
+    for (const auto & fault : m_config.faults)
+    {
+        if (fault.type == EMULATOR_FAULT::EMULATOR_FAULT_CORRUPT && m_corrupt_offset < 0
+            && isFaultAt(fault, m_frame_index))
         {
-            if (is_used_random)
-                val = randMinToMax(INT32_MIN, INT32_MAX);
+            m_corrupt_offset = std::min(std::max(fault.value, 0), m_frame_size - 1);
+            m_corrupt_byte   = m_frame[m_corrupt_offset];
 
-            payload[i] = val;
+            m_frame[m_corrupt_offset] = static_cast<char>(~m_corrupt_byte);
         }
     }
-    break;
 
-    default:
-        break;
-    }
+    ++m_frame_index;
+    ++m_emitted;
 }
 
-void DataSourceFileEmulator::updateBufs()
+read_block DataSourceFileEmulator::nextBlock(int size)
 {
-    generateRandom();
+    // Як у реальному потоці (сокет, послідовний порт): непрочитані байти кадру
+    // видаються наступним читанням, за ними йде наступний кадр.
+    if (m_stream_pos >= m_frame_size)
+    {
+        nextFrame();
+        m_stream_pos = 0;
+    }
 
-    ++m_frm_counter;
-    if (m_frm_counter >= UINT16_MAX)
-        m_frm_counter = 0;
+    // - результат DataSource::read() непередбачуваний,
+    // близький до реальної ситуації, може варіюватись у межах 0..size;
+    const int ret_size = m_read_divider > 1 ? size / m_read_divider : size;
 
-    if (m_frm_counter % 1000 == 0)
-        m_buffer->setSourceID(m_buffer->sourceId() + 1);
+    read_block block;
 
-    m_buffer->setFrameCounter(m_frm_counter);
-}
+    block.data    = m_frame + m_stream_pos;
+    block.size    = std::max(0, std::min(ret_size, m_frame_size - m_stream_pos));
+    block.is_lent = true;
 
-Timer overall_timer; // між оновленням даних
-Timer diff_timer;    // для вирівнювання sleep До 200 Гц
+    return block;
+}
 
-int DataSourceFileEmulator::read(char * data, int size)
+read_block DataSourceFileEmulator::acquire(char * buffer, int size)
 {
+    (void) buffer;
+
     std::lock_guard<std::mutex> lock(m_read_lock);
 
-    int ret_size = size;
+    Timer timer;
 
-    double elapsed = 0.;
+    const read_block block = nextBlock(size);
 
-    overall_timer.reset();
-    diff_timer.reset();
+    m_elapsed = timer.elapsed();
 
-    updateBufs();
+    return block;
+}
+
+void DataSourceFileEmulator::commit(const read_block & block, int consumed)
+{
+    std::lock_guard<std::mutex> lock(m_read_lock);
+
+    m_stream_pos += std::max(0, std::min(consumed, block.size));
+}
+
+int DataSourceFileEmulator::readBatch(read_vector * frames, int count)
+{
+    std::lock_guard<std::mutex> lock(m_read_lock);
 
-    static int b = 0;
-    if (b < 10)
+    Timer timer;
+
+    for (int i = 0; i < count; ++i)
     {
-        // - результат DataSource::read() непередбачуваний,
-        // близький до реальної ситуації, може варіюватись у межах 0..size;
-        ret_size = size / 2;
-        ++b;
+        const read_block block = nextBlock(frames[i].size);
+
+        memcpy(frames[i].data, block.data, block.size);
+
+        frames[i].size = block.size;
+        m_stream_pos += block.size;
     }
 
-    memcpy(data, m_buffer->data(), ret_size);
+    m_elapsed = timer.elapsed();
+
+    return count;
+}
+
+int DataSourceFileEmulator::read(char * data, int size)
+{
+    const read_block block = acquire(data, size);
 
-    elapsed = overall_timer.elapsed();
+    if (block.size > 0)
+        memcpy(data, block.data, block.size);
 
-    m_elapsed = elapsed;
+    commit(block, block.size);
 
-    return ret_size;
+    return block.size;
 }
 
 } // namespace DATA_SOURCE_TASK
@@ -1,60 +1,282 @@
 #include "DataSourceFile.h"
 
-#include <fstream>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace DATA_SOURCE_TASK
 {
 
-DataSourceFile::DataSourceFile(const std::string & file_path):
+DataSourceFile::DataSourceFile(const std::string & file_path, const bool & is_looped):
     DataSource(),
-    m_file_path {file_path}
+    m_file_path {file_path},
+    m_is_looped {is_looped}
 {
+#ifdef WIN32
+    HANDLE file = CreateFileA(
+        m_file_path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        std::cout << "DataSourceFile: can't open " << m_file_path << std::endl;
+        return;
+    }
+
+    m_file_handle = file;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        std::cout << "DataSourceFile: empty file " << m_file_path << std::endl;
+        return;
+    }
+
+    m_file_size = static_cast<std::uint64_t>(size.QuadPart);
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+    if (!mapping)
+    {
+        std::cout << "DataSourceFile: can't map " << m_file_path << std::endl;
+        return;
+    }
+
+    m_mapping_handle = mapping;
+    m_map            = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+    m_fd = ::open(m_file_path.c_str(), O_RDONLY);
+
+    if (m_fd < 0)
+    {
+        std::cout << "DataSourceFile: can't open " << m_file_path << std::endl;
+        return;
+    }
+
+    struct stat st;
+    if (fstat(m_fd, &st) != 0 || st.st_size == 0)
+    {
+        std::cout << "DataSourceFile: empty file " << m_file_path << std::endl;
+        return;
+    }
+
+    m_file_size = static_cast<std::uint64_t>(st.st_size);
+
+    void * map = mmap(nullptr, m_file_size, PROT_READ, MAP_SHARED, m_fd, 0);
+
+    if (map == MAP_FAILED)
+    {
+        std::cout << "DataSourceFile: can't map " << m_file_path << std::endl;
+        return;
+    }
+
+    m_map = static_cast<const char *>(map);
+
+    // Читаємо послідовно: ядро збільшує вікно читання наперед і раніше звільняє прочитані сторінки
+    madvise(map, m_file_size, MADV_SEQUENTIAL);
+#endif
+
+    readAhead();
 }
 
-DataSourceFile::~DataSourceFile() {}
+DataSourceFile::~DataSourceFile()
+{
+    unmap();
+}
 
-int DataSourceFile::read(char * data, int size)
+void DataSourceFile::unmap()
+{
+#ifdef WIN32
+    if (m_map)
+        UnmapViewOfFile(m_map);
+
+    if (m_mapping_handle)
+        CloseHandle(m_mapping_handle);
+
+    if (m_file_handle)
+        CloseHandle(m_file_handle);
+
+    m_mapping_handle = nullptr;
+    m_file_handle    = nullptr;
+#else
+    if (m_map)
+        munmap(const_cast<char *>(m_map), m_file_size);
+
+    if (m_fd >= 0)
+        ::close(m_fd);
+
+    m_fd = -1;
+#endif
+    m_map = nullptr;
+}
+
+void DataSourceFile::readAhead()
+{
+    if (!m_map || m_ahead_pos >= m_file_size)
+        return;
+
+    // запит наступного вікна, коли курсор пройшов половину попереднього
+    if (m_ahead_pos > m_pos + FILE_READ_AHEAD_SIZE / 2)
+        return;
+
+    const std::uint64_t begin = std::max(m_ahead_pos, m_pos);
+    const std::uint64_t end   = std::min(m_file_size, m_pos + FILE_READ_AHEAD_SIZE);
+
+#ifndef WIN32
+    // madvise вимагає адресу, вирівняну на сторінку
+    static const std::uint64_t page_size = static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+
+    const std::uint64_t aligned_begin = begin & ~(page_size - 1);
+
+    if (end > aligned_begin)
+        madvise(const_cast<char *>(m_map) + aligned_begin, end - aligned_begin, MADV_WILLNEED);
+#endif
+
+    m_ahead_pos = end;
+}
+
+void DataSourceFile::rewind()
 {
     std::lock_guard<std::mutex> lock(m_data_mutex);
 
-    std::ifstream source_file(m_file_path, std::ios::in | std::ios::binary);
+    m_pos       = 0;
+    m_ahead_pos = 0;
 
-    if (!source_file)
-        return static_cast<int>(DATA_SOURCE_ERROR::READ_SOURCE_ERROR);
+    readAhead();
+}
 
-    if (!source_file.seekg(0, std::ios::beg))
-        return static_cast<int>(DATA_SOURCE_ERROR::READ_SOURCE_ERROR);
+int DataSourceFile::advance(int size, std::uint64_t & offset)
+{
+    if (!m_map || size <= 0)
+        return 0;
+
+    if (m_pos >= m_file_size)
+    {
+        if (!m_is_looped)
+            return 0;
+
+        m_pos       = 0;
+        m_ahead_pos = 0;
+    }
+
+    const int available = static_cast<int>(std::min<std::uint64_t>(size, m_file_size - m_pos));
+
+    offset = m_pos;
+    m_pos += available;
+
+    readAhead();
+
+    return available;
+}
+
+read_block DataSourceFile::acquire(char * buffer, int size)
+{
+    (void) buffer;
 
-    int index = 0;
-    char character;
+    std::lock_guard<std::mutex> lock(m_data_mutex);
 
-    while (index < size && (source_file.get(character)))
+    Timer timer;
+
+    read_block block;
+
+    if (!m_map)
     {
-        data[index++] = character;
+        block.size = static_cast<int>(DATA_SOURCE_ERROR::READ_SOURCE_ERROR);
+        return block;
     }
 
-    if (source_file.fail())
+    if (m_pos >= m_file_size && m_is_looped)
     {
-        std::ios_base::iostate state = source_file.rdstate();
+        m_pos       = 0;
+        m_ahead_pos = 0;
 
-        if (state & std::ios_base::eofbit)
-        {
-            std::cout << "DataSourceFile End of file reached." << std::endl;
-        }
-        if (state & std::ios_base::failbit)
-        {
-            std::cout << "DataSourceFile Non-fatal I/O error occurred." << std::endl;
-        }
-        if (state & std::ios_base::badbit)
-        {
-            std::cout << "DataSourceFile Fatal I/O error occurred." << std::endl;
-        }
+        readAhead();
+    }
 
+    block.data    = m_map + m_pos;
+    block.size    = size > 0 ? static_cast<int>(std::min<std::uint64_t>(size, m_file_size - m_pos)) : 0;
+    block.is_lent = true;
+
+    m_elapsed = timer.elapsed();
+
+    return block;
+}
+
+void DataSourceFile::commit(const read_block & block, int consumed)
+{
+    std::lock_guard<std::mutex> lock(m_data_mutex);
+
+    if (!m_map || !block.is_lent || consumed <= 0)
+        return;
+
+    m_pos += std::min(consumed, block.size);
+
+    readAhead();
+}
+
+int DataSourceFile::read(char * data, int size)
+{
+    const read_block block = acquire(data, size);
+
+    if (block.size > 0)
+        memcpy(data, block.data, block.size);
+
+    commit(block, block.size);
+
+    return block.size;
+}
+
+int DataSourceFile::readBatch(read_vector * frames, int count)
+{
+    std::lock_guard<std::mutex> lock(m_data_mutex);
+
+    Timer timer;
+
+    if (!m_map)
         return static_cast<int>(DATA_SOURCE_ERROR::READ_SOURCE_ERROR);
+
+    int filled = 0;
+
+    for (; filled < count; ++filled)
+    {
+        std::uint64_t offset = 0;
+
+        const int available = advance(frames[filled].size, offset);
+
+        if (available <= 0)
+            break;
+
+        memcpy(frames[filled].data, m_map + offset, available);
+        frames[filled].size = available;
     }
 
-    return index;
+    m_elapsed = timer.elapsed();
+
+    return filled;
+}
+
+int DataSourceFile::view(const char ** data, int size)
+{
+    std::lock_guard<std::mutex> lock(m_data_mutex);
+
+    if (!m_map)
+        return static_cast<int>(DATA_SOURCE_ERROR::READ_SOURCE_ERROR);
+
+    std::uint64_t offset = 0;
+
+    const int available = advance(size, offset);
+
+    *data = m_map + offset;
+
+    return available;
 }
 
 } // namespace DATA_SOURCE_TASK
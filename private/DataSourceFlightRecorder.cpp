@@ -0,0 +1,186 @@
+#include "DataSourceFlightRecorder.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace DATA_SOURCE_TASK
+{
+
+static_assert(sizeof(flight_ring_header) <= FLIGHT_RING_DATA_OFFSET, "flight ring header must fit into first page");
+static_assert(sizeof(std::atomic<std::uint64_t>) == sizeof(std::uint64_t), "atomic counters are shared with readers");
+
+namespace
+{
+
+// Вирівнювання блоків в кільці
+constexpr std::uint64_t FLIGHT_BLOCK_ALIGNMENT {8};
+
+// Непідтверджений блок: запис ще триває
+constexpr std::uint64_t FLIGHT_BLOCK_PENDING {UINT64_MAX};
+
+std::uint64_t alignBlock(const std::uint64_t & size)
+{
+    return (size + FLIGHT_BLOCK_ALIGNMENT - 1) & ~(FLIGHT_BLOCK_ALIGNMENT - 1);
+}
+
+std::uint64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+} // namespace
+
+DataSourceFlightRecorder::DataSourceFlightRecorder(
+    const std::string & file_name,
+    const std::uint64_t & ring_size,
+    const std::uint8_t & source_id):
+    m_file_name {file_name},
+    m_source_id {source_id},
+    m_capacity {alignBlock(ring_size)}
+{
+#ifdef WIN32
+    std::cout << "DataSourceFlightRecorder: not supported on this platform" << std::endl;
+#else
+    m_map_size = FLIGHT_RING_DATA_OFFSET + m_capacity;
+
+    m_fd = ::open(m_file_name.c_str(), O_RDWR | O_CREAT, 0644);
+
+    if (m_fd < 0)
+    {
+        std::cout << "DataSourceFlightRecorder: can't open " << m_file_name << std::endl;
+        return;
+    }
+
+    // Виділяємо місце на диску наперед, щоб запис у відображення не впирався в ENOSPC/SIGBUS
+    if (posix_fallocate(m_fd, 0, m_map_size) != 0 && ftruncate(m_fd, m_map_size) != 0)
+    {
+        std::cout << "DataSourceFlightRecorder: can't allocate " << m_file_name << std::endl;
+        close();
+        return;
+    }
+
+    void * map = mmap(nullptr, m_map_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+
+    if (map == MAP_FAILED)
+    {
+        std::cout << "DataSourceFlightRecorder: can't map " << m_file_name << std::endl;
+        close();
+        return;
+    }
+
+    m_map    = static_cast<char *>(map);
+    m_header = reinterpret_cast<flight_ring_header *>(m_map);
+    m_data   = m_map + FLIGHT_RING_DATA_OFFSET;
+
+    // Файл з іншою геометрією або новий - ініціалізуємо. Інакше продовжуємо з попередньої позиції.
+    if (m_header->magic != FLIGHT_RING_MAGIC || m_header->version != FLIGHT_RING_VERSION
+        || m_header->capacity != m_capacity || m_header->data_offset != FLIGHT_RING_DATA_OFFSET)
+    {
+        memset(static_cast<void *>(m_header), 0, sizeof(flight_ring_header));
+
+        m_header->version     = FLIGHT_RING_VERSION;
+        m_header->data_offset = FLIGHT_RING_DATA_OFFSET;
+        m_header->capacity    = m_capacity;
+        m_header->source_id   = m_source_id;
+        m_header->head.store(0, std::memory_order_relaxed);
+        m_header->sequence.store(0, std::memory_order_relaxed);
+
+        // magic останнім - читачі бачать тільки ініціалізований заголовок
+        std::atomic_thread_fence(std::memory_order_release);
+        m_header->magic = FLIGHT_RING_MAGIC;
+    }
+#endif
+}
+
+DataSourceFlightRecorder::~DataSourceFlightRecorder()
+{
+    close();
+}
+
+void DataSourceFlightRecorder::close()
+{
+#ifndef WIN32
+    if (m_map)
+        munmap(m_map, m_map_size);
+
+    if (m_fd >= 0)
+        ::close(m_fd);
+
+    m_fd = -1;
+#endif
+    m_map    = nullptr;
+    m_header = nullptr;
+    m_data   = nullptr;
+}
+
+std::uint64_t DataSourceFlightRecorder::blocksWritten() const
+{
+    return m_header ? m_header->sequence.load(std::memory_order_acquire) : 0;
+}
+
+bool DataSourceFlightRecorder::write(const char * data, const std::uint32_t & size, const std::uint16_t & frame_counter)
+{
+    if (!m_header)
+        return false;
+
+    const std::uint64_t total = alignBlock(sizeof(flight_block_header) + size);
+
+    if (total > m_capacity / 2)
+        return false;
+
+    std::uint64_t head = m_header->head.load(std::memory_order_relaxed);
+    std::uint64_t pos  = head % m_capacity;
+
+    // Блок не вміщається до кінця області - позначаємо перехід і пишемо з початку
+    if (pos + total > m_capacity)
+    {
+        if (m_capacity - pos >= sizeof(flight_block_header))
+        {
+            flight_block_header wrap {};
+            wrap.magic         = FLIGHT_BLOCK_MAGIC;
+            wrap.sequence      = FLIGHT_BLOCK_PENDING;
+            wrap.frame_counter = UINT16_MAX;
+            wrap.source_id     = m_source_id;
+
+            memcpy(m_data + pos, &wrap, sizeof(wrap));
+        }
+
+        head += m_capacity - pos;
+        pos = 0;
+    }
+
+    const std::uint64_t sequence = m_header->sequence.load(std::memory_order_relaxed);
+
+    flight_block_header * block = reinterpret_cast<flight_block_header *>(m_data + pos);
+
+    // Спочатку робимо блок недійсним, потім пишемо дані, номер блоку - останнім
+    block->sequence = FLIGHT_BLOCK_PENDING;
+    std::atomic_thread_fence(std::memory_order_release);
+
+    block->magic         = FLIGHT_BLOCK_MAGIC;
+    block->payload_size  = size;
+    block->timestamp_ns  = nowNs();
+    block->frame_counter = frame_counter;
+    block->source_id     = m_source_id;
+
+    memcpy(m_data + pos + sizeof(flight_block_header), data, size);
+
+    std::atomic_thread_fence(std::memory_order_release);
+    block->sequence = sequence;
+
+    m_header->sequence.store(sequence + 1, std::memory_order_release);
+    m_header->head.store(head + total, std::memory_order_release);
+
+    return true;
+}
+
+} // namespace DATA_SOURCE_TASK
@@ -0,0 +1,186 @@
+#include "DataSourceFramePool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace DATA_SOURCE_TASK
+{
+
+namespace
+{
+
+// Порожній індекс стеку вільних кадрів
+constexpr std::uint32_t FREE_LIST_END {UINT32_MAX};
+
+// Зсув заголовку в слоті: відліки починаються з FRAME_POOL_ALIGNMENT
+constexpr std::size_t HEADER_OFFSET {FRAME_POOL_ALIGNMENT - FRAME_HEADER_SIZE};
+
+static_assert(FRAME_HEADER_SIZE <= FRAME_POOL_ALIGNMENT, "frame header must fit into alignment padding");
+
+std::size_t alignUp(const std::size_t & value, const std::size_t & alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+std::uint64_t packHead(const std::uint32_t & index, const std::uint64_t & tag)
+{
+    return (tag << 32) | index;
+}
+
+} // namespace
+
+DataSourcePoolBuffer::DataSourcePoolBuffer(
+    DataSourceFramePool * pool,
+    char * data,
+    const std::uint32_t & index,
+    const std::uint32_t & frame_size,
+    const std::uint8_t & type_size):
+    DataSourceBufferInterface(),
+    m_pool {pool},
+    m_index {index},
+    m_next {FREE_LIST_END},
+    m_refs {0}
+{
+    m_frame_size   = frame_size;
+    m_type_size    = type_size;
+    m_elements_num = (m_frame_size - FRAME_HEADER_SIZE) / m_type_size;
+
+    attach(data);
+    m_frame->payload_size = (m_frame_size - FRAME_HEADER_SIZE);
+}
+
+void DataSourceFrameHandle::reset()
+{
+    if (m_buffer)
+    {
+        m_buffer->m_pool->release(m_buffer);
+        m_buffer = nullptr;
+    }
+}
+
+void DataSourceSharedFrame::reset()
+{
+    if (!m_buffer)
+        return;
+
+    // записи всіх власників в кадр видно тому, хто поверне його в пул
+    if (m_buffer->m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        m_buffer->m_pool->release(m_buffer);
+
+    m_buffer = nullptr;
+}
+
+DataSourceFramePool::DataSourceFramePool(
+    const std::uint32_t & frame_size,
+    const std::size_t & capacity,
+    const std::uint8_t & type_size,
+    const std::size_t & max_capacity):
+    m_frame_size {frame_size},
+    m_type_size {type_size},
+    m_max_capacity {std::max(capacity, max_capacity)},
+    m_free_head {packHead(FREE_LIST_END, 0)}
+{
+    if (frame_size < FRAME_HEADER_SIZE || !type_size || !capacity || m_max_capacity >= FREE_LIST_END)
+        throw std::invalid_argument("DataSourceFramePool: invalid frame size or capacity");
+
+    m_stride = alignUp(HEADER_OFFSET + frame_size, FRAME_POOL_ALIGNMENT);
+
+    m_buffers.reset(new std::unique_ptr<DataSourcePoolBuffer>[m_max_capacity]);
+
+    grow(capacity);
+}
+
+std::size_t DataSourceFramePool::grow(const std::size_t & count)
+{
+    std::lock_guard<std::mutex> lock(m_grow_lock);
+
+    return growLocked(count);
+}
+
+std::size_t DataSourceFramePool::reserve(const std::size_t & capacity)
+{
+    std::lock_guard<std::mutex> lock(m_grow_lock);
+
+    const std::size_t current = m_capacity.load(std::memory_order_relaxed);
+
+    return capacity > current ? growLocked(capacity - current) : 0;
+}
+
+std::size_t DataSourceFramePool::growLocked(const std::size_t & count)
+{
+    const std::size_t first = m_capacity.load(std::memory_order_relaxed);
+    const std::size_t added = std::min(count, m_max_capacity - first);
+
+    if (!added)
+        return 0;
+
+    // Запас на вирівнювання початку блоку. Без заповнення нулями: сторінки займаються при першому записі кадру,
+    // тому ріст пулу на ходу не зупиняє потік надовго.
+    std::unique_ptr<char[]> memory(new char[m_stride * added + FRAME_POOL_ALIGNMENT]);
+
+    char * base =
+        reinterpret_cast<char *>(alignUp(reinterpret_cast<std::uintptr_t>(memory.get()), FRAME_POOL_ALIGNMENT));
+
+    for (std::size_t i = 0; i < added; ++i)
+    {
+        m_buffers[first + i].reset(new DataSourcePoolBuffer(
+            this,
+            base + i * m_stride + HEADER_OFFSET,
+            static_cast<std::uint32_t>(first + i),
+            m_frame_size,
+            m_type_size));
+    }
+
+    m_memory.push_back(std::move(memory));
+    m_capacity.store(first + added, std::memory_order_release);
+
+    // Нові кадри вільні. Публікація в стеку (release) робить кадр видимим для acquire().
+    for (std::size_t i = first + added; i > first; --i)
+        release(m_buffers[i - 1].get());
+
+    return added;
+}
+
+DataSourceFramePool::~DataSourceFramePool() {}
+
+DataSourceFrameHandle DataSourceFramePool::acquire()
+{
+    std::uint64_t head = m_free_head.load(std::memory_order_acquire);
+
+    while (true)
+    {
+        const std::uint32_t index = static_cast<std::uint32_t>(head);
+
+        if (index == FREE_LIST_END)
+            return DataSourceFrameHandle();
+
+        DataSourcePoolBuffer * buffer = m_buffers[index].get();
+        const std::uint32_t next      = buffer->m_next.load(std::memory_order_relaxed);
+
+        if (m_free_head.compare_exchange_weak(
+                head, packHead(next, (head >> 32) + 1), std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            m_available.fetch_sub(1, std::memory_order_relaxed);
+            return DataSourceFrameHandle(buffer);
+        }
+    }
+}
+
+void DataSourceFramePool::release(DataSourcePoolBuffer * buffer)
+{
+    std::uint64_t head = m_free_head.load(std::memory_order_relaxed);
+
+    do
+    {
+        buffer->m_next.store(static_cast<std::uint32_t>(head), std::memory_order_relaxed);
+    } while (!m_free_head.compare_exchange_weak(
+        head, packHead(buffer->m_index, (head >> 32) + 1), std::memory_order_release, std::memory_order_relaxed));
+
+    m_available.fetch_add(1, std::memory_order_relaxed);
+
+    if (m_release_event)
+        m_release_event->notify();
+}
+
+} // namespace DATA_SOURCE_TASK
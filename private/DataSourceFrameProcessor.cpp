@@ -1,35 +1,84 @@
 #include "DataSourceFrameProcessor.h"
+#include "DataSourceConvert.h"
+
+#include <algorithm>
+#include <cstring>
 
 namespace DATA_SOURCE_TASK
 {
 
-DataSourceFrameProcessor::DataSourceFrameProcessor(const int & frame_size):
-    m_frame_size {frame_size},
-    m_packets_loss {0},
-    m_stream_broken {0},
-    m_bad_frames {0},
-    m_can_validate {false},
-    m_src_ready_buffer {-1},
-    m_active_buffer {0},
-    m_flt_ready_buffer {-1}
-{
-    // виділимо дані
-    for (std::size_t b = 0; b < BUFERIZATION_NUM; ++b)
-    {
-        for (std::size_t i = 0; i < MAX_PROCESSING_BUF_NUM; ++i)
-        {
-            m_source_buffer[b][i] = std::make_shared<DataSourceBuffer<std::uint8_t>>(frame_size);
-        }
-    }
+// Розмір float кадру для вхідного кадру frame_size: к-сть відліків максимальна (8 bit).
+std::uint32_t floatFrameSize(const int & frame_size)
+{
+    return FRAME_HEADER_SIZE + (frame_size - FRAME_HEADER_SIZE) * FLOAT_SIZE;
+}
 
-    const int max_total_elements = m_source_buffer[0][0]->totalElements();
-    const int float_frame_size   = FRAME_HEADER_SIZE + max_total_elements * sizeof(float);
+// Ємність резерву для політики черги
+std::size_t spillCapacity(const queue_config & queue)
+{
+    return queue.policy == QUEUE_POLICY::QUEUE_POLICY_SPILL ? queue.spill_capacity : 0;
+}
 
-    // float буфери. К-сть елементів максимальна.
-    for (std::size_t i = 0; i < MAX_PROCESSING_BUF_NUM; i++)
-    {
-        m_buffer.push_back(std::make_shared<DataSourceBuffer<float>>(float_frame_size));
-    }
+// Кадри, які потік обробки тримає пакетом: слоти черги вже звільнені, кадри ще не повернуті в пул
+std::size_t configBatchSize(const queue_config & queue)
+{
+    return std::max<std::size_t>(queue.batch_size, 1);
+}
+
+// Робоча глибина черги
+std::size_t configQueueDepth(const queue_config & queue)
+{
+    return std::max<std::size_t>(queue.depth, 1);
+}
+
+// Межа глибини черги: без автопідбору глибина не змінюється
+std::size_t configMaxQueueDepth(const queue_config & queue)
+{
+    return queue.auto_tune ? std::max(configQueueDepth(queue), queue.max_depth) : configQueueDepth(queue);
+}
+
+// Налаштування реєстраторів з урахуванням автопідбору
+recorder_config tunedRecorderConfig(const queue_config & queue, const recorder_config & rec_config)
+{
+    recorder_config config = rec_config;
+
+    if (queue.auto_tune && !config.max_buffer_count)
+        config.max_buffer_count = std::max(config.buffer_count, AUTO_TUNE_MAX_REC_BUF_NUM);
+
+    if (!config.writer_pool)
+        config.writer_pool = DataSourceRecordWriterPool::shared();
+
+    return config;
+}
+
+DataSourceFrameProcessor::DataSourceFrameProcessor(
+    const int & frame_size,
+    const queue_config & queue,
+    const recorder_config & rec_config,
+    const std::size_t & read_frames,
+    const shared_ring_config & shared_ring):
+    m_frame_size {frame_size},
+    m_queue_config {queue},
+    m_source_pool {
+        static_cast<std::uint32_t>(frame_size),
+        configQueueDepth(queue) + configBatchSize(queue) + std::max<std::size_t>(read_frames, 1)
+            + spillCapacity(queue),
+        UINT8_SIZE,
+        configMaxQueueDepth(queue) + configBatchSize(queue) + std::max<std::size_t>(read_frames, 1)
+            + spillCapacity(queue)},
+    m_source_ring {ceilPowerOfTwo(configMaxQueueDepth(queue))},
+    m_spill(spillCapacity(queue)),
+    m_deframer {static_cast<std::uint32_t>(frame_size)},
+    m_float_pool {floatFrameSize(frame_size),
+                  std::max<std::size_t>(queue.float_pool_size, 1),
+                  FLOAT_SIZE,
+                  std::max<std::size_t>(queue.float_pool_size, 1) + MAX_CONSUMER_FRAMES},
+    m_workers {queue.worker_pool ? queue.worker_pool : DataSourceWorkerPool::shared()},
+    m_recorder_config {tunedRecorderConfig(queue, rec_config)},
+    m_shared_ring_config {shared_ring}
+{
+    m_source_ring.setLimit(configQueueDepth(queue));
+    m_float_pool.setReleaseEvent(&m_frame_event);
 
     m_is_process_active = true;
     m_process_thread    = std::thread(&DataSourceFrameProcessor::frameProcess, this);
@@ -39,89 +88,326 @@ DataSourceFrameProcessor::~DataSourceFrameProcessor()
 {
     m_is_process_active = false;
 
+    m_frame_event.notify();
+    m_slot_event.notify();
+
     if (m_process_thread.joinable())
         m_process_thread.join();
+
+    // витіснені реєстратори пишуть в гістограми цього об'єкта
+    m_data_source_frame_recorders.clear();
+    m_recorder_config.writer_pool->waitRetired();
 }
 
 void DataSourceFrameProcessor::frameProcess()
 {
     Timer timer;
+    Timer stage_timer;
+
+    // вікно автопідбору
+    Timer tune_timer;
+    Timer evict_timer;
+    Timer metrics_timer;
+    bool is_metrics_dirty = true; // є зміни з останньої публікації
+    std::uint64_t window_frames = 0;
+    std::int64_t window_busy_ns = 0;
+    std::int64_t window_max_ns  = 0;
+
+    const std::size_t batch_size = configBatchSize(m_queue_config);
+    const std::uint32_t chunk    = std::max<std::uint32_t>(m_queue_config.chunk_size, CACHE_LINE_SIZE);
+
+    // Пакет кадрів: вхідний, float, розмір даних і перша задача пулу для кадру
+    struct batch_frame
+    {
+        DataSourceFrameHandle frame;
+        DataSourceFrameHandle flt_frame;
+        int payload_size;
+        int type_size;
+        int chunk_elements;
+        std::size_t first_task;
+    };
+
+    std::vector<batch_frame> batch(batch_size);
+    std::vector<std::size_t> task_frame; // задача пулу -> кадр пакету
+
+    const std::function<void(std::size_t)> convert_chunk = [&](std::size_t task) {
+        batch_frame & item = batch[task_frame[task]];
+
+        const int begin = static_cast<int>(task - item.first_task) * item.chunk_elements;
+        const int count = std::min(item.chunk_elements, item.payload_size / item.type_size - begin);
+
+        convertToFloat(
+            item.frame->payloadType(),
+            item.frame->payload() + static_cast<std::size_t>(begin) * item.type_size,
+            count * item.type_size,
+            reinterpret_cast<float *>(item.flt_frame->payload()) + begin);
+    };
 
     while (m_is_process_active)
     {
-        if (m_can_validate)
+        if (m_queue_config.auto_tune && tune_timer.elapsed() >= AUTO_TUNE_INTERVAL_MS)
+        {
+            autoTune(tune_timer.elapsedNs(), window_frames, window_busy_ns, window_max_ns);
+
+            tune_timer.reset();
+            window_frames  = 0;
+            window_busy_ns = 0;
+            window_max_ns  = 0;
+        }
+
+        if (m_recorder_config.idle_seconds && evict_timer.elapsed() >= RECORDER_EVICT_INTERVAL_MS)
+        {
+            evictIdleRecorders();
+            evict_timer.reset();
+            is_metrics_dirty = true;
+        }
+
+        if (is_metrics_dirty && metrics_timer.elapsed() >= METRICS_PUBLISH_INTERVAL_MS)
         {
-            timer.reset();
+            publishMetrics();
+            metrics_timer.reset();
+            is_metrics_dirty = false;
+        }
+
+        // Забираємо кадри і звільняємо слоти для потоку читання.
+        // Лічильники перевіряються в порядку черги, тут же рахуються частини для перетворення.
+        std::size_t frames = 0;
+        task_frame.clear();
+
+        timer.reset();
+
+        while (frames < batch_size)
+        {
+            batch_frame & item = batch[frames];
+
+            item.flt_frame = m_float_pool.acquire();
+
+            if (!item.flt_frame || !m_source_ring.pop(item.frame))
+            {
+                item.flt_frame.reset();
+                break;
+            }
+
+            item.payload_size   = validateHeader(*item.frame, *item.flt_frame);
+            item.type_size      = payloadTypeSize(item.frame->payloadType());
+            item.chunk_elements = 0;
+            item.first_task     = task_frame.size();
+
+            if (item.type_size && item.payload_size >= item.type_size)
+            {
+                // частина кратна кеш-лінії вихідних відліків, щоб потоки не писали в одну лінію
+                item.chunk_elements = static_cast<int>(std::max<std::uint32_t>(
+                    chunk / item.type_size / CACHE_LINE_SIZE * CACHE_LINE_SIZE, CACHE_LINE_SIZE));
 
-            for (std::size_t idx = 0; idx < MAX_PROCESSING_BUF_NUM; ++idx)
+                const int elements = item.payload_size / item.type_size;
+                const int chunks   = (elements + item.chunk_elements - 1) / item.chunk_elements;
+
+                task_frame.insert(task_frame.end(), chunks, frames);
+            }
+
+            ++frames;
+        }
+
+        // слоти звільнено - будимо потік читання, якщо він чекає (QUEUE_POLICY_BLOCK)
+        if (frames)
+            m_slot_event.notify();
+
+        if (!frames)
+        {
+            // знімок актуальний на час сну
+            if (is_metrics_dirty)
             {
-                int total_elements = 0;
-
-                // поточний буфер оновлюється, тому беремо попередній.
-                int ready_buffer = m_active_buffer - 1;
-
-                if (ready_buffer < 0)
-                {
-                    ready_buffer = BUFERIZATION_NUM - 1;
-                }
-
-                total_elements = validateFrame(m_source_buffer[ready_buffer][idx]);
-
-                if (total_elements)
-                {
-                    // Перевіримо ІД джерела і виокремимо для запису в файл
-                    const int source_id = static_cast<int>(m_buffer[m_flt_ready_buffer]->frame()->source_id);
-
-                    const auto & it = m_data_source_frame_recorders.find(source_id);
-
-                    if (it != m_data_source_frame_recorders.end())
-                    {
-                        // реєстрація блоків даних
-                        it->second->putNewFrame(m_buffer[m_flt_ready_buffer], total_elements);
-                    }
-                    else
-                    {
-                        // \TODO!! Треба заміряти пам'ять, треба знати коли зупинитись
-                        m_data_source_frame_recorders[source_id] = std::make_shared<DataSourceFrameRecorder>(
-                            "record_" + std::to_string(source_id), total_elements);
-                    }
-                }
+                publishMetrics();
+                metrics_timer.reset();
+                is_metrics_dirty = false;
             }
 
-            m_can_validate = false;
-            m_elapsed      = timer.elapsed();
+            // Спимо до нового кадру або до наступного автопідбору / перевірки реєстраторів.
+            // Кадри float можуть тримати споживачі: тоді чекаємо і вільний кадр, пул будить при поверненні.
+            const int timeout_ms = std::min(AUTO_TUNE_INTERVAL_MS, RECORDER_EVICT_INTERVAL_MS);
 
+            m_frame_event.waitFor(
+                [this]() { return (m_source_ring.size() && m_float_pool.available()) || !m_is_process_active; },
+                std::chrono::milliseconds(timeout_ms));
             continue;
         }
 
-        // Timeout
-        std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(MAX_FREQ_READ)));
+        stage_timer.reset();
+
+        m_workers->parallelFor(task_frame.size(), convert_chunk);
+
+        // пакет перетворюється разом: на кадр - частка часу пакету
+        const std::int64_t convert_ns = stage_timer.elapsedNs() / static_cast<std::int64_t>(frames);
+
+        std::uint64_t batch_bytes = 0;
+
+        for (std::size_t i = 0; i < frames; ++i)
+        {
+            batch_frame & item = batch[i];
+
+            const int total_elements = item.chunk_elements ? item.payload_size / item.type_size : 0;
+
+            batch_bytes += static_cast<std::uint64_t>(std::max(item.payload_size, 0));
+
+            // заголовок скопійовано з вхідного кадру: тип ще вхідний
+            const PAYLOAD_TYPE source_type = item.flt_frame->payloadType();
+
+            item.flt_frame->setPayloadType(PAYLOAD_TYPE::PAYLOAD_TYPE_32_BIT_IEEE_FLOAT);
+            item.flt_frame->setPayloadSize(total_elements * FLOAT_SIZE);
+
+            recordLatency(LATENCY_STAGE::LATENCY_STAGE_CONVERT, convert_ns);
+
+            // вхідний кадр більше не потрібен, повертаємо в пул
+            item.frame.reset();
+
+            if (total_elements)
+            {
+                recordFrame(*item.flt_frame, total_elements, source_type);
+
+                if (!m_shared_ring_config.name_prefix.empty())
+                    shareFrame(*item.flt_frame, total_elements, source_type);
+
+                // кадр переходить споживачам, в пул повернеться після останнього
+                if (m_consumers.hasConsumers())
+                    m_consumers.publish(item.flt_frame, total_elements, source_type);
+            }
+
+            item.flt_frame.reset();
+        }
+
+        const std::int64_t elapsed_ns = timer.elapsedNs();
+
+        m_metrics.add(METRIC_COUNTER::METRIC_COUNTER_FRAMES, frames);
+        m_metrics.add(METRIC_COUNTER::METRIC_COUNTER_BYTES, batch_bytes);
+        m_metrics.setGauge(METRIC_GAUGE::METRIC_GAUGE_PROCESS_NS, elapsed_ns / static_cast<std::int64_t>(frames));
+        is_metrics_dirty = true;
+
+        m_elapsed     = elapsed_ns / 1000000. / frames;
+        window_max_ns = std::max(window_max_ns, elapsed_ns);
+        window_busy_ns += elapsed_ns;
+        window_frames += frames;
     }
 }
 
-template<typename T>
-int convertToFloat(char * buf, const int payload_size, DataSourceBuffer<float> * cur_buf)
+void DataSourceFrameProcessor::recordFrame(
+    DataSourceBufferInterface & flt_frame,
+    const int & total_elements,
+    const PAYLOAD_TYPE & source_type)
 {
-    T * payload = reinterpret_cast<T *>(buf);
+    // Перевіримо ІД джерела і виокремимо для запису в файл
+    const int source_id = static_cast<int>(flt_frame.sourceId());
 
-    const int total_elements = payload_size / sizeof(T);
+    auto it = m_data_source_frame_recorders.find(source_id);
 
-    for (int i = 0; i < total_elements; ++i)
+    if (it == m_data_source_frame_recorders.end())
     {
-        cur_buf->payload()[i] = static_cast<float>(payload[i]);
+        // пам'ять буферів обмежена бюджетом пулу запису, реєстратори без кадрів витісняються
+        auto & segment_counter = m_segment_counters[source_id];
+
+        if (!segment_counter)
+            segment_counter = std::make_shared<std::atomic<std::uint32_t>>(0);
+
+        it = m_data_source_frame_recorders
+                 .emplace(
+                     source_id,
+                     std::make_shared<DataSourceFrameRecorder>(
+                         m_recorder_config.record_prefix + std::to_string(source_id),
+                         total_elements,
+                         m_recorder_config,
+                         &m_latency[static_cast<int>(LATENCY_STAGE::LATENCY_STAGE_DISK_WRITE)],
+                         &m_latency[static_cast<int>(LATENCY_STAGE::LATENCY_STAGE_ENCODE)],
+                         segment_counter))
+                 .first;
+
+        m_recorder_memory += it->second->memoryUsage();
     }
 
-    return total_elements;
+    Timer stage_timer;
+
+    // реєстрація блоків даних
+    it->second->putNewFrame(flt_frame, total_elements, source_type);
+
+    recordLatency(LATENCY_STAGE::LATENCY_STAGE_RECORD_ENQUEUE, stage_timer.elapsedNs());
+}
+
+int DataSourceFrameProcessor::addConsumer(
+    const std::shared_ptr<DataSourceConsumer> & consumer,
+    const consumer_config & config)
+{
+    const int id = m_consumers.add(consumer, config);
+
+    // Кадри, які тримають споживачі, не мають забирати кадри потоку обробки. Резерв рахується від усіх
+    // поточних споживачів, тож кадри прибраних споживачів (пул не зменшується) дістаються новим.
+    if (id >= 0)
+    {
+        m_float_pool.reserve(
+            std::max<std::size_t>(m_queue_config.float_pool_size, 1)
+            + std::min(m_consumers.heldFrames(), MAX_CONSUMER_FRAMES));
+    }
+
+    return id;
 }
 
-int DataSourceFrameProcessor::validateFrame(const std::shared_ptr<DataSourceBufferInterface> & buffer)
+void DataSourceFrameProcessor::shareFrame(
+    DataSourceBufferInterface & flt_frame,
+    const int & total_elements,
+    const PAYLOAD_TYPE & source_type)
 {
-    std::lock_guard<std::mutex> lock(m_process_mutex);
+    const int source_id = static_cast<int>(flt_frame.sourceId());
+
+    auto it = m_shared_rings.find(source_id);
+
+    if (it == m_shared_rings.end())
+    {
+        // ємність слоту - найбільша к-сть відліків кадру (8 bit)
+        it = m_shared_rings
+                 .emplace(source_id,
+                          std::unique_ptr<DataSourceSharedRingWriter>(new DataSourceSharedRingWriter(
+                              "/" + m_shared_ring_config.name_prefix + std::to_string(source_id),
+                              static_cast<std::uint8_t>(source_id),
+                              static_cast<std::uint32_t>(m_frame_size - FRAME_HEADER_SIZE),
+                              m_shared_ring_config.slots)))
+                 .first;
+    }
+
+    Timer stage_timer;
 
-    uint32_t total_elements = buffer->payloadSize() / FLOAT_SIZE;
+    it->second->publish(flt_frame, total_elements, source_type);
 
-    frame * frm = buffer->frame();
-    char * buf  = buffer->payload();
+    recordLatency(LATENCY_STAGE::LATENCY_STAGE_SHARED_PUBLISH, stage_timer.elapsedNs());
+}
+
+void DataSourceFrameProcessor::evictIdleRecorders()
+{
+    const double idle_ms = m_recorder_config.idle_seconds * 1000.;
+
+    for (auto it = m_data_source_frame_recorders.begin(); it != m_data_source_frame_recorders.end();)
+    {
+        if (it->second->idleMs() < idle_ms)
+        {
+            ++it;
+            continue;
+        }
+
+        const std::uint64_t memory = it->second->memoryUsage();
+
+        m_recorder_memory -= std::min<std::uint64_t>(memory, m_recorder_memory);
+        m_tune_dropped_samples.erase(it->first);
+
+        // неповний буфер, закриття сегменту і звільнення пам'яті - в потоці пулу запису
+        m_recorder_config.writer_pool->retire(std::move(it->second));
+        m_metrics.add(METRIC_COUNTER::METRIC_COUNTER_RECORDERS_EVICTED);
+
+        // читачі кільця побачать isWriterClosed() і відкриють нове, якщо джерело повернеться
+        m_shared_rings.erase(it->first);
+
+        it = m_data_source_frame_recorders.erase(it);
+    }
+}
+
+int DataSourceFrameProcessor::validateHeader(DataSourceBufferInterface & buffer, DataSourceBufferInterface & flt_buffer)
+{
+    frame * frm = buffer.frame();
 
     // розбираємось з лічильком кадру
     if (m_cur_frm_counter == -1)
@@ -135,85 +421,176 @@ int DataSourceFrameProcessor::validateFrame(const std::shared_ptr<DataSourceBuff
 
         if ((delta > 1) && (delta < UINT16_MAX))
         {
-            m_packets_loss += frm->frame_counter - m_cur_frm_counter - 1;
+            m_metrics.add(METRIC_COUNTER::METRIC_COUNTER_PACKETS_LOSS, frm->frame_counter - m_cur_frm_counter - 1);
         }
     }
 
     // Запам'ятовуємо лічильник.
     m_cur_frm_counter = frm->frame_counter;
 
-    // сформуємо float масиви
-    if (m_flt_ready_buffer >= static_cast<int>(MAX_PROCESSING_BUF_NUM) - 1)
-        m_flt_ready_buffer = -1;
-
-    // Поточний кадр для перетворення в float
-    ++m_flt_ready_buffer;
+    // оновимо заголовок
+    memcpy(flt_buffer.frame(), frm, FRAME_HEADER_SIZE);
 
-    DataSourceBuffer<float> * cur_buf = m_buffer[m_flt_ready_buffer].get();
+    // розмір із заголовку не повинен виходити за межі буфера
+    return std::min<int>(buffer.payloadSize(), buffer.size() - FRAME_HEADER_SIZE);
+}
 
-    // оновимо заголовок
-    std::copy(frm, frm + FRAME_HEADER_SIZE, cur_buf->frame());
+int DataSourceFrameProcessor::validateFrame(DataSourceBufferInterface & buffer, DataSourceBufferInterface & flt_buffer)
+{
+    const int payload_size = validateHeader(buffer, flt_buffer);
 
     // - реалізувати максимально обчислювально ефективне перетворення усіх даних
     // до єдиного типу 32 bit IEEE 754 float та приведення до діапазону +/-1.0;
-    if (frm->payload_type != PAYLOAD_TYPE::PAYLOAD_TYPE_32_BIT_IEEE_FLOAT)
-    {
-        switch (frm->payload_type)
-        {
-        case PAYLOAD_TYPE::PAYLOAD_TYPE_8_BIT_UINT:
-            return convertToFloat<std::uint8_t>(buf, buffer->payloadSize(), cur_buf);
+    const int total_elements = convertToFloat(
+        buffer.frame()->payload_type, buffer.payload(), payload_size, reinterpret_cast<float *>(flt_buffer.payload()));
 
-        case PAYLOAD_TYPE::PAYLOAD_TYPE_16_BIT_INT:
-            return convertToFloat<std::int16_t>(buf, buffer->payloadSize(), cur_buf);
+    flt_buffer.setPayloadType(PAYLOAD_TYPE::PAYLOAD_TYPE_32_BIT_IEEE_FLOAT);
+    flt_buffer.setPayloadSize(total_elements * FLOAT_SIZE);
 
-        case PAYLOAD_TYPE::PAYLOAD_TYPE_32_BIT_INT:
-            return convertToFloat<std::int32_t>(buf, buffer->payloadSize(), cur_buf);
+    return total_elements;
+}
 
-        default:
+void DataSourceFrameProcessor::drainSpill()
+{
+    std::size_t size = m_spill_size.load(std::memory_order_relaxed);
+
+    while (size)
+    {
+        DataSourceFrameHandle * slot = m_source_ring.writeSlot();
+
+        if (!slot)
             break;
-        }
-    }
 
-    // перекладемо дані якшо вони вже в форматі float
-    memcpy(cur_buf->payload(), buf, buffer->payloadSize());
+        *slot = std::move(m_spill[m_spill_head]);
+        m_source_ring.push();
 
-    return total_elements;
+        m_spill_head = (m_spill_head + 1) % m_spill.size();
+        m_spill_size.store(--size, std::memory_order_relaxed);
+
+        m_frame_event.notify();
+    }
 }
 
-void DataSourceFrameProcessor::putNewFrame(std::shared_ptr<DataSourceBufferInterface> & frame, int updated_size)
+bool DataSourceFrameProcessor::enqueueFrame(DataSourceFrameHandle & frame)
 {
-    std::lock_guard<std::mutex> lock(m_process_mutex);
+    // резерв зберігає порядок: поки він не порожній, нові кадри стають за ним
+    drainSpill();
 
-    if (!frame.get())
-        return;
+    DataSourceFrameHandle * slot = m_spill_size ? nullptr : m_source_ring.writeSlot();
 
-    // Заповнюємо буфери з масивами кадрів
-    if (m_src_ready_buffer >= static_cast<int>(MAX_PROCESSING_BUF_NUM) - 1)
+    if (slot)
     {
-        m_src_ready_buffer = -1;
+        *slot = std::move(frame);
+        m_source_ring.push();
+        m_frame_event.notify();
+        return true;
+    }
 
-        ++m_active_buffer;
+    // Потік обробки не встигає
+    m_metrics.add(METRIC_COUNTER::METRIC_COUNTER_OVERRUNS);
 
-        // міняєм буфер
-        if (m_active_buffer >= BUFERIZATION_NUM)
-            m_active_buffer = 0;
+    switch (m_queue_config.policy)
+    {
+    case QUEUE_POLICY::QUEUE_POLICY_BLOCK:
+    {
+        Timer timer;
+
+        m_metrics.add(METRIC_COUNTER::METRIC_COUNTER_BLOCKED);
+
+        while (!(slot = m_source_ring.writeSlot()))
+        {
+            // обробка зупинена - чекати нема на кого
+            if (!m_is_process_active)
+            {
+                m_metrics.add(METRIC_COUNTER::METRIC_COUNTER_DROPPED_NEWEST);
+                return false;
+            }
+
+            // потік обробки будить після кожного забраного пакету
+            m_slot_event.waitFor([this]() { return m_source_ring.writeSlot() || !m_is_process_active; },
+                                 std::chrono::milliseconds(static_cast<int>(MAX_FREQ_READ)));
+        }
 
-        // сигналізуємо про готовність масивів даних для обробки
-        m_can_validate = true;
+        m_metrics.add(METRIC_COUNTER::METRIC_COUNTER_BLOCKED_NS, timer.elapsedNs());
+        break;
     }
+    case QUEUE_POLICY::QUEUE_POLICY_DROP_OLDEST:
+    {
+        // Витісняємо найстаріший необроблений кадр, він повертається в пул
+        DataSourceFrameHandle oldest;
+
+        if (m_source_ring.pop(oldest))
+            m_metrics.add(METRIC_COUNTER::METRIC_COUNTER_DROPPED_OLDEST);
 
-    // Новий кадр для масиву даних
-    ++m_src_ready_buffer;
+        // потік читання - єдиний виробник, тому після звільнення слот лишається нашим
+        slot = m_source_ring.writeSlot();
+        break;
+    }
+    case QUEUE_POLICY::QUEUE_POLICY_SPILL:
+    {
+        const std::size_t size = m_spill_size.load(std::memory_order_relaxed);
 
-    const PAYLOAD_TYPE p_type = frame->frame()->payload_type;
+        if (size < m_spill.size())
+        {
+            m_spill[(m_spill_head + size) % m_spill.size()] = std::move(frame);
+            m_spill_size.store(size + 1, std::memory_order_relaxed);
 
-    // Обміняємо кадр для обробки
-    m_source_buffer[m_active_buffer][m_src_ready_buffer].swap(frame);
+            m_metrics.add(METRIC_COUNTER::METRIC_COUNTER_SPILLED);
+            return true;
+        }
+        break;
+    }
+    case QUEUE_POLICY::QUEUE_POLICY_DROP_NEWEST:
+    default:
+        break;
+    }
 
-    // розмір не відповідає необхідному.
-    if (updated_size != frameSize())
+    if (!slot)
     {
-        ++m_bad_frames;
+        // кадр не затираємо, лишається у викликаючого
+        m_metrics.add(METRIC_COUNTER::METRIC_COUNTER_DROPPED_NEWEST);
+        return false;
+    }
+
+    *slot = std::move(frame);
+    m_source_ring.push();
+    m_frame_event.notify();
+
+    return true;
+}
+
+DataSourceFrameHandle DataSourceFrameProcessor::acquireFrame()
+{
+    DataSourceFrameHandle frame = m_source_pool.acquire();
+
+    // Всі кадри в черзі, резерві або в обробці: читати нікуди, як і при заповненій черзі
+    if (!frame)
+        m_metrics.add(METRIC_COUNTER::METRIC_COUNTER_OVERRUNS);
+
+    return frame;
+}
+
+void DataSourceFrameProcessor::putNewFrame(DataSourceFrameHandle & frame, int updated_size)
+{
+    if (!frame)
+        return;
+
+    const PAYLOAD_TYPE p_type         = frame->payloadType();
+    const std::uint32_t declared_size = frame->payloadSize();
+    const std::uint32_t header        = frame->header();
+    const std::uint16_t counter       = frame->frameCounter();
+
+    // Передаємо кадр на обробку. Після постановки в чергу кадр належить потоку обробки.
+    if (!enqueueFrame(frame))
+        return;
+
+    m_last_header  = header;
+    m_last_counter = counter;
+
+    // кадр неповний: отримано менше, ніж заявлено в заголовку
+    if (updated_size < static_cast<int>(FRAME_HEADER_SIZE + declared_size))
+    {
+        m_metrics.add(METRIC_COUNTER::METRIC_COUNTER_BAD_FRAMES);
     }
 
     // перевірка цілісності даних. розмір даних має бути кратним типу даних
@@ -241,32 +618,261 @@ void DataSourceFrameProcessor::putNewFrame(std::shared_ptr<DataSourceBufferInter
 
         if (recieved_payload_size % payload_size != 0)
         {
-            ++m_stream_broken;
+            m_metrics.add(METRIC_COUNTER::METRIC_COUNTER_BROKEN_FRAMES);
         }
     }
     else
     {
-        ++m_stream_broken;
+        m_metrics.add(METRIC_COUNTER::METRIC_COUNTER_BROKEN_FRAMES);
     }
 }
 
-double DataSourceFrameProcessor::saveFrameElapsed()
+void DataSourceFrameProcessor::putNewData(DataSourceFrameHandle & frame, int updated_size)
+{
+    // кадри з резерву йдуть в чергу навіть коли нових повних кадрів немає
+    drainSpill();
+
+    if (!frame || updated_size <= 0)
+        return;
+
+    // Швидкий шлях: незавершених кадрів немає і прочитані дані починаються з повного кадру
+    const int frame_size = m_deframer.pending() ? 0 : m_deframer.completeFrameSize(frame->data(), updated_size);
+
+    if (frame_size)
+    {
+        // залишок - початок наступного кадру
+        m_deframer.push(frame->data() + frame_size, updated_size - frame_size);
+        putNewFrame(frame, frame_size);
+    }
+    else
+    {
+        m_deframer.push(frame->data(), updated_size);
+    }
+
+    drainDeframer(frame);
+}
+
+void DataSourceFrameProcessor::putNewData(DataSourceFrameHandle & frame, const char * data, int size)
+{
+    drainSpill();
+
+    if (!data || size <= 0)
+        return;
+
+    // Швидкий шлях: повні кадри копіюються з даних джерела одразу в кадр пулу, минаючи накопичувач
+    while (!m_deframer.pending() && size > 0)
+    {
+        const int frame_size = m_deframer.completeFrameSize(data, size);
+
+        if (!frame_size)
+            break;
+
+        if (!frame)
+            frame = acquireFrame();
+
+        if (!frame)
+            break;
+
+        memcpy(frame->data(), data, frame_size);
+        putNewFrame(frame, frame_size);
+
+        data += frame_size;
+        size -= frame_size;
+    }
+
+    m_deframer.push(data, size);
+
+    drainDeframer(frame);
+}
+
+void DataSourceFrameProcessor::putNewBatch(
+    DataSourceFrameHandle * frames,
+    const read_vector * sizes,
+    const int & count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        if (sizes[i].size > 0)
+            putNewData(frames[i], sizes[i].size);
+    }
+}
+
+void DataSourceFrameProcessor::drainDeframer(DataSourceFrameHandle & frame)
+{
+    // Повні кадри з накопичувача
+    while (m_deframer.pending())
+    {
+        if (!frame)
+            frame = acquireFrame();
+
+        if (!frame)
+            break;
+
+        const int size = m_deframer.next(*frame);
+
+        if (!size)
+            break;
+
+        putNewFrame(frame, size);
+    }
+
+    m_metrics.add(METRIC_COUNTER::METRIC_COUNTER_BAD_FRAMES, m_deframer.resyncs() - m_deframer_resyncs);
+    m_metrics.add(METRIC_COUNTER::METRIC_COUNTER_BROKEN_FRAMES, m_deframer.brokenHeaders() - m_deframer_broken);
+
+    m_deframer_resyncs = m_deframer.resyncs();
+    m_deframer_broken  = m_deframer.brokenHeaders();
+}
+
+std::uint64_t DataSourceFrameProcessor::memoryUsage() const
 {
-    double average_elapsed;
+    return m_source_pool.capacity() * m_source_pool.frameStride() + m_float_pool.capacity() * m_float_pool.frameStride()
+        + m_recorder_memory;
+}
+
+void DataSourceFrameProcessor::publishMetrics()
+{
+    m_metrics.setGauge(METRIC_GAUGE::METRIC_GAUGE_QUEUE_OCCUPANCY, static_cast<std::int64_t>(m_source_ring.size()));
+    m_metrics.setGauge(METRIC_GAUGE::METRIC_GAUGE_QUEUE_DEPTH, static_cast<std::int64_t>(m_source_ring.limit()));
+    m_metrics.setGauge(METRIC_GAUGE::METRIC_GAUGE_MEMORY_BYTES, static_cast<std::int64_t>(memoryUsage()));
+    m_metrics.setGauge(METRIC_GAUGE::METRIC_GAUGE_RECORDERS,
+                       static_cast<std::int64_t>(m_data_source_frame_recorders.size()));
+    m_metrics.setGauge(METRIC_GAUGE::METRIC_GAUGE_CONSUMERS, m_consumers.count());
+
+    // розсилка рахує відкинуті кадри сама, в метрики - приріст з минулої публікації
+    const std::uint64_t consumer_dropped = m_consumers.dropped();
+
+    m_metrics.add(METRIC_COUNTER::METRIC_COUNTER_CONSUMER_DROPPED, consumer_dropped - m_consumer_dropped);
+    m_consumer_dropped = consumer_dropped;
+
+    latency_snapshot latency[static_cast<int>(LATENCY_STAGE::LATENCY_STAGE_SIZE)];
+
+    for (int i = 0; i < static_cast<int>(LATENCY_STAGE::LATENCY_STAGE_SIZE); ++i)
+        latency[i] = m_latency[i].snapshot();
+
+    m_metrics.publish(latency);
+}
+
+std::uint64_t DataSourceFrameProcessor::memoryAvailable() const
+{
+    if (!m_queue_config.memory_budget)
+        return UINT64_MAX;
+
+    const std::uint64_t usage = memoryUsage();
+
+    return m_queue_config.memory_budget > usage ? m_queue_config.memory_budget - usage : 0;
+}
+
+void DataSourceFrameProcessor::autoTune(
+    const std::int64_t & window_ns,
+    const std::uint64_t & frames,
+    const std::int64_t & busy_ns,
+    const std::int64_t & max_stall_ns)
+{
+    const std::uint64_t overruns = m_metrics.counter(METRIC_COUNTER::METRIC_COUNTER_OVERRUNS);
+    const std::uint64_t missed   = overruns - m_tune_overruns;
+    m_tune_overruns              = overruns;
+
+    // середній інтервал надходження кадрів у вікні
+    const std::uint64_t arrivals   = frames + missed;
+    const std::int64_t interval_ns = arrivals ? std::max<std::int64_t>(window_ns / arrivals, 1) : 0;
 
-    average_elapsed = 0;
+    // --------------   Глибина черги   --------------------
+    const std::size_t depth  = m_source_ring.limit();
+    const bool is_overloaded = busy_ns >= window_ns / 10 * 9;
+    std::size_t target       = depth;
+
+    if (interval_ns)
+        target = std::max<std::size_t>(target, 2 * (max_stall_ns / interval_ns + 1));
+
+    target = std::min<std::size_t>(target + missed, configMaxQueueDepth(m_queue_config));
+
+    if (target > depth && !is_overloaded)
+    {
+        const std::size_t affordable = memoryAvailable() / m_source_pool.frameStride();
+        const std::size_t added      = m_source_pool.grow(std::min(target - depth, affordable));
+
+        if (added)
+        {
+            m_source_ring.setLimit(depth + added);
+            m_metrics.add(METRIC_COUNTER::METRIC_COUNTER_TUNE_STEPS);
+        }
+    }
+
+    // --------------   Буфери запису   --------------------
+    const std::int64_t write_ns = m_latency[static_cast<int>(LATENCY_STAGE::LATENCY_STAGE_DISK_WRITE)].percentile(99.9);
 
     for (const auto & recorder : m_data_source_frame_recorders)
     {
-        average_elapsed += recorder.second->elapsed();
+        DataSourceFrameRecorder & rec = *recorder.second;
+
+        const std::uint64_t dropped = rec.droppedSamples();
+        const bool is_dropped       = dropped > m_tune_dropped_samples[recorder.first];
+
+        m_tune_dropped_samples[recorder.first] = dropped;
+
+        std::size_t needed = rec.bufferCount() + (is_dropped ? 1 : 0);
+
+        // буфер заповнюється за fill_ns, за час запису одного буфера мають бути вільні наступні
+        if (interval_ns && rec.frameElements() > 0)
+        {
+            const std::int64_t fill_ns =
+                interval_ns * std::max<std::int64_t>(rec.bufferSize() / rec.frameElements(), 1);
+
+            needed = std::max<std::size_t>(needed, write_ns / fill_ns + 2);
+        }
+
+        if (needed <= rec.bufferCount())
+            continue;
+
+        const std::uint64_t buffer_bytes = rec.bufferBytes();
+        const std::size_t affordable     = memoryAvailable() / buffer_bytes;
+        const std::size_t added          = rec.addBuffers(std::min(needed - rec.bufferCount(), affordable));
+
+        if (added)
+        {
+            m_recorder_memory += added * buffer_bytes;
+            m_metrics.add(METRIC_COUNTER::METRIC_COUNTER_TUNE_STEPS);
+        }
     }
+}
+
+queue_stats DataSourceFrameProcessor::queueStats() const
+{
+    queue_stats stats;
+
+    stats.overruns        = m_metrics.counter(METRIC_COUNTER::METRIC_COUNTER_OVERRUNS);
+    stats.dropped_newest  = m_metrics.counter(METRIC_COUNTER::METRIC_COUNTER_DROPPED_NEWEST);
+    stats.dropped_oldest  = m_metrics.counter(METRIC_COUNTER::METRIC_COUNTER_DROPPED_OLDEST);
+    stats.spilled         = m_metrics.counter(METRIC_COUNTER::METRIC_COUNTER_SPILLED);
+    stats.blocked         = m_metrics.counter(METRIC_COUNTER::METRIC_COUNTER_BLOCKED);
+    stats.blocked_ns      = m_metrics.counter(METRIC_COUNTER::METRIC_COUNTER_BLOCKED_NS);
+    stats.spill_occupancy = m_spill_size;
+    stats.depth           = m_source_ring.limit();
+    stats.max_depth       = configMaxQueueDepth(m_queue_config);
+    stats.tune_steps      = m_metrics.counter(METRIC_COUNTER::METRIC_COUNTER_TUNE_STEPS);
+    stats.memory_bytes    = memoryUsage();
+
+    return stats;
+}
+
+latency_snapshot DataSourceFrameProcessor::latency(const LATENCY_STAGE & stage) const
+{
+    if (stage < LATENCY_STAGE::LATENCY_STAGE_READ || stage >= LATENCY_STAGE::LATENCY_STAGE_SIZE)
+        return latency_snapshot();
 
-    int num_toatal = m_data_source_frame_recorders.size();
+    return m_latency[static_cast<int>(stage)].snapshot();
+}
 
-    if (num_toatal)
-        average_elapsed /= num_toatal;
+void DataSourceFrameProcessor::resetLatency()
+{
+    for (auto & histogram : m_latency)
+        histogram.reset();
+}
 
-    return average_elapsed;
+double DataSourceFrameProcessor::saveFrameElapsed()
+{
+    // реєстратори створюються і витісняються потоком обробки - беремо гістограму запису, а не їх список
+    return m_latency[static_cast<int>(LATENCY_STAGE::LATENCY_STAGE_DISK_WRITE)].snapshot().mean_ns / 1000000.;
 }
 
 } // namespace DATA_SOURCE_TASK
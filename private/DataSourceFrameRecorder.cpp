@@ -1,10 +1,10 @@
 #include "DataSourceFrameRecorder.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
-#include <fstream>
-#include <iostream>
+#include <cstring>
 #include <mutex>
-#include <thread>
 
 namespace DATA_SOURCE_TASK
 {
@@ -18,145 +18,336 @@ size_t nearestPowerOfTwo(const size_t & n)
     return static_cast<size_t>(std::pow(2, std::ceil(std::log2(n))));
 }
 
-DataSourceFrameRecorder::DataSourceFrameRecorder(const std::string & record_name,
-                                                 const int & num_elements):
+// Межа к-сті буферів з налаштувань
+std::size_t configMaxBufferCount(const recorder_config & config)
+{
+    return std::max<std::size_t>(std::max(config.buffer_count, config.max_buffer_count), 1);
+}
+
+// Кодування блоків: без стиснення блоки все одно мають заголовок
+RECORD_CODEC configCodec(const recorder_config & config)
+{
+    if (config.codec == RECORD_CODEC::RECORD_CODEC_NONE)
+        return RECORD_CODEC::RECORD_CODEC_RAW;
+
+    return config.codec;
+}
+
+std::uint64_t systemNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+DataSourceFrameRecorder::DataSourceFrameRecorder(
+    const std::string & record_name,
+    const int & num_elements,
+    const recorder_config & config,
+    DataSourceLatencyHistogram * write_latency,
+    DataSourceLatencyHistogram * encode_latency,
+    const std::shared_ptr<std::atomic<std::uint32_t>> & segment_counter):
+    m_num_elements {num_elements},
     m_record_name {record_name},
-    m_need_record {false}
+    m_pool {config.writer_pool ? config.writer_pool : DataSourceRecordWriterPool::shared()},
+    m_write_latency {write_latency},
+    m_encode_latency {encode_latency},
+    m_max_buffer_count {configMaxBufferCount(config)},
+    m_free_buffers {ceilPowerOfTwo(configMaxBufferCount(config))},
+    m_ready_buffers {ceilPowerOfTwo(configMaxBufferCount(config))},
+    m_config {config},
+    m_writer {record_name,
+              config.segment_size,
+              config.segment_seconds,
+              static_cast<std::uint32_t>(std::max(num_elements, 0)),
+              config.codec,
+              segment_counter},
+    m_codec {configCodec(config)}
 {
     m_buffer_size = nearestPowerOfTwo(num_elements * RECORD_SIZE);
+    m_sample_size = std::max(recordFormatSize(config.format), 1);
+
+    // буфери кодування - мінімум, без якого запис не працює
+    const std::uint64_t codec_bytes = m_codec.codec() != RECORD_CODEC::RECORD_CODEC_NONE ? 2 * bufferBytes() : 0;
+
+    m_pool->reserveForced(codec_bytes);
+    m_reserved_bytes = codec_bytes;
 
     // Буфери для запису розміром кратним степеня двійки
-    for (std::size_t i = 0; i < MAX_REC_BUF_NUM; ++i)
+    m_frame_record.reserve(m_max_buffer_count);
+
+    if (!addBuffers(std::max<std::size_t>(config.buffer_count, 1)))
     {
-        struct record_buffer * buf = &m_frame_record[i];
-        buf->record_buffer.resize(m_buffer_size);
-        buf->available_size = m_buffer_size;
-        buf->id             = i + 1;
-    }
+        // бюджет вичерпано: один буфер понад бюджет, щоб джерело все ж писалось
+        m_pool->reserveForced(bufferBytes());
+        m_reserved_bytes += bufferBytes();
 
-    // Дані для запису в файл
-    m_record_buffer.resize(m_buffer_size);
+        std::lock_guard<std::mutex> lock(m_buf_lock);
 
-    // асинхронний потік запису в файл
-    m_record_to_file = std::thread(&DataSourceFrameRecorder::recordBlock, this);
+        appendBuffer();
+    }
 }
 
 DataSourceFrameRecorder::~DataSourceFrameRecorder()
 {
-    m_is_can_record_active = false;
+    stop();
+
+    m_pool->release(m_reserved_bytes);
+}
+
+void DataSourceFrameRecorder::stop()
+{
+    flush();
 
-    if (m_record_to_file.joinable())
-        m_record_to_file.join();
+    m_pool->wait(this);
 }
 
-void DataSourceFrameRecorder::recordBlock()
+void DataSourceFrameRecorder::flush()
 {
-    m_is_can_record_active = true;
+    {
+        std::lock_guard<std::mutex> lock(m_buf_lock);
 
+        if (!m_active_buffer || !m_active_buffer->pos)
+            return;
+
+        pushReady(m_active_buffer);
+
+        m_active_buffer = nullptr;
+    }
+
+    m_pool->submit(this);
+}
+
+void DataSourceFrameRecorder::pushReady(record_buffer * buf)
+{
+    // Слотів вистачає на всі буфери.
+    *m_ready_buffers.writeSlot() = buf;
+    m_ready_buffers.push();
+}
+
+std::size_t DataSourceFrameRecorder::addBuffers(const std::size_t & count)
+{
+    std::lock_guard<std::mutex> lock(m_buf_lock);
+
+    const std::size_t added =
+        m_pool->reserve(bufferBytes(), std::min(count, m_max_buffer_count - m_frame_record.size()));
+
+    m_reserved_bytes += added * bufferBytes();
+
+    for (std::size_t i = 0; i < added; ++i)
+        appendBuffer();
+
+    return added;
+}
+
+void DataSourceFrameRecorder::appendBuffer()
+{
+    std::unique_ptr<record_buffer> buf(new record_buffer());
+    buf->record_buffer.resize(bufferBytes());
+    buf->available_size = m_buffer_size;
+    buf->id             = static_cast<int>(m_frame_record.size() + 1);
+
+    m_spare_buffers.push_back(buf.get());
+    m_frame_record.push_back(std::move(buf));
+
+    m_buffer_count = m_frame_record.size();
+}
+
+void DataSourceFrameRecorder::writeReady()
+{
     Timer timer;
-    while (m_is_can_record_active)
+    record_buffer * buf = nullptr;
+
+    // Пишемо всі заповнені буфери в порядку заповнення
+    while (m_ready_buffers.pop(buf))
     {
-        if (m_need_record)
+        block_header meta;
+
+        meta.element_size = static_cast<std::uint8_t>(m_sample_size);
+        meta.format       = static_cast<std::uint8_t>(m_config.format);
+        meta.payload_type = static_cast<std::uint8_t>(buf->payload_type);
+        meta.source_id    = buf->source_id;
+        meta.scale        = m_config.int16_scale;
+        meta.sample_count = buf->pos;
+        meta.first_frame  = buf->first_frame;
+        meta.last_frame   = buf->last_frame;
+        meta.first_ns     = buf->first_ns;
+        meta.last_ns      = buf->last_ns;
+        meta.frame_offset = buf->frame_offset;
+
+        timer.reset();
+
+        // неповний буфер (flush()) - лише заповнена частина
+        const std::size_t sz =
+            m_codec.encode(buf->record_buffer.data(), static_cast<std::uint32_t>(buf->pos * m_sample_size), meta);
+
+        if (m_encode_latency)
+            m_encode_latency->record(timer.elapsedNs());
+
+        timer.reset();
+
+        if (m_writer.write(m_codec.encoded(), sz))
         {
-            timer.reset();
+            m_bytes_written += sz;
+            m_raw_bytes_written += static_cast<std::uint64_t>(buf->pos) * FLOAT_SIZE;
+        }
 
-            // Будемо просто перезаписувати поточний файл.
-            std::ofstream source_file(m_record_name, std::ios::out | std::ios::binary);
+        const std::int64_t elapsed_ns = timer.elapsedNs();
 
-            if (!source_file)
-                continue;
+        m_elapsed = elapsed_ns / 1000000.;
 
-            char * wbuf  = reinterpret_cast<char *>(m_record_buffer.data());
-            int buz_size = m_record_buffer.size()  * FLOAT_SIZE;
+        if (m_write_latency)
+            m_write_latency->record(elapsed_ns);
 
-            source_file.write(wbuf, buz_size);
+        // вивільняємо буфер для заповнення. Слотів вистачає на всі буфери.
+        buf->pos            = 0;
+        buf->available_size = m_buffer_size;
 
-            m_need_record = false;
+        *m_free_buffers.writeSlot() = buf;
+        m_free_buffers.push();
+    }
+}
 
-            if (source_file.fail())
-            {
-                std::ios_base::iostate state = source_file.rdstate();
-
-                if (state & std::ios_base::eofbit)
-                {
-                    std::cout << "DataSourceFrameRecorder: End of file reached." << std::endl;
-                }
-                if (state & std::ios_base::failbit)
-                {
-                    std::cout << "DataSourceFrameRecorder: Non-fatal I/O error occurred." << std::endl;
-                }
-                if (state & std::ios_base::badbit)
-                {
-                    std::cout << "DataSourceFrameRecorder: Fatal I/O error occurred." << std::endl;
-                }
-            }
+void DataSourceFrameRecorder::putNewFrame(
+    const DataSourceBufferInterface & frame,
+    const int & total_elements,
+    const PAYLOAD_TYPE & source_type)
+{
+    m_idle_timer.reset();
 
-            m_elapsed = timer.elapsed();
+    bool is_ready = false;
 
-            continue;
-        }
+    {
+        std::lock_guard<std::mutex> lock(m_buf_lock);
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        is_ready = fillBuffers(frame, total_elements, source_type);
     }
+
+    // буфер заповнено - в чергу пулу запису
+    if (is_ready)
+        m_pool->submit(this);
 }
 
-void DataSourceFrameRecorder::putNewFrame(const std::shared_ptr<DataSourceBuffer<float>> & frame,
-                                          const int & total_elements)
+bool DataSourceFrameRecorder::fillBuffers(
+    const DataSourceBufferInterface & frame,
+    const int & total_elements,
+    const PAYLOAD_TYPE & source_type)
 {
-    std::lock_guard<std::mutex> lock(m_buf_lock);
+    bool is_ready = false;
 
-    if (!frame.get())
-        return;
+    // лічильник кадрів без переповнення: пропуски враховуються, 16-бітний лічильник - ні
+    const std::uint16_t counter = frame.frameCounter();
 
-    // Реальний розмір оброблених даних
-    std::size_t av_in_data = total_elements * FLOAT_SIZE;
+    if (m_is_first_frame)
+        m_frame = counter;
+    else
+        m_frame += static_cast<std::uint16_t>(counter - static_cast<std::uint16_t>(m_frame));
 
-    // Заповнимо масиви під запис
-    for (std::uint8_t i = 0; i < MAX_REC_BUF_NUM; ++i)
+    m_is_first_frame = false;
+
+    const std::uint64_t now_ns = systemNs();
+
+    const float * src = reinterpret_cast<const float *>(frame.payload());
+
+    // Реальний розмір оброблених даних, відліків
+    std::uint32_t av_in_data = total_elements > 0 ? total_elements : 0;
+
+    if (m_config.mode != RECORD_MODE::RECORD_MODE_ARCHIVE)
+    {
+        // кільцевий файл створюємо з першим кадром, щоб знати ІД джерела
+        if (!m_flight_recorder)
+        {
+            m_flight_recorder.reset(
+                new DataSourceFlightRecorder(m_record_name + ".ring", m_config.flight_ring_size, frame.sourceId()));
+        }
+
+        m_flight_recorder->write(frame.payload(), av_in_data * FLOAT_SIZE, frame.frameCounter());
+
+        if (m_config.mode == RECORD_MODE::RECORD_MODE_FLIGHT_RING)
+            return false;
+    }
+
+    // Кадр пишеться цілим або не пишеться: обрізаний кадр зсунув би всі наступні при відтворенні
+    const std::size_t free_buffers = m_spare_buffers.size() + m_free_buffers.size();
+    const std::uint64_t free_space = (m_active_buffer ? m_active_buffer->available_size : 0)
+        + static_cast<std::uint64_t>(free_buffers) * m_buffer_size;
+
+    if (free_space < av_in_data)
     {
-        struct record_buffer * buf = &m_frame_record[i];
+        // потік запису не встигає - всі буфери чекають запису
+        m_dropped_samples += av_in_data;
 
-        // перевіримо чи буфер не повний і чи є що записати ще
-        if (!buf->is_full && av_in_data > 0)
+        // пропуск кадрів - між блоками: кадри блоку йдуть підряд від first_frame
+        if (m_active_buffer && m_active_buffer->pos)
         {
-            // вільне місце в буфері
-            std::size_t num_data_store = buf->available_size;
+            pushReady(m_active_buffer);
+
+            m_active_buffer = nullptr;
+            is_ready        = true;
+        }
+
+        return is_ready;
+    }
 
-            if (av_in_data < num_data_store)
+    const float * const frame_src = src;
+
+    // Заповнимо масиви під запис
+    while (av_in_data > 0)
+    {
+        if (!m_active_buffer)
+        {
+            // спочатку нові буфери, потім повернуті потоком запису
+            if (!m_spare_buffers.empty())
             {
-                num_data_store = av_in_data;
+                m_active_buffer = m_spare_buffers.back();
+                m_spare_buffers.pop_back();
             }
-            else
+            else if (!m_free_buffers.pop(m_active_buffer))
             {
-                num_data_store = buf->available_size;
+                break; // місце перевірено вище
             }
+        }
 
-            memcpy(buf->record_buffer.data() + buf->pos, frame->payload(), num_data_store);
+        record_buffer * buf = m_active_buffer;
 
-            buf->pos += num_data_store;                 // зміщуємо позицію в буфері для наступного дозапису
-            buf->available_size -= num_data_store;      // оновлюємо розмір вільного місця
-            buf->is_full = (buf->pos >= m_buffer_size); // ставим прапорець заповненості буферу
+        // опис джерела для заголовку блоку: потік запису читає лише буфер
+        if (!buf->pos)
+        {
+            buf->first_frame  = m_frame;
+            buf->first_ns     = now_ns;
+            buf->source_id    = frame.sourceId();
+            buf->payload_type = source_type;
+            buf->frame_offset = src != frame_src ? std::min(av_in_data, buf->available_size) : 0;
+        }
 
-            if (buf->is_full)
-            {
-                // Обміняємо буфери для запису
-                m_record_buffer.swap(buf->record_buffer);
+        buf->last_frame = m_frame;
+        buf->last_ns    = now_ns;
 
-                // дозволяємо запис в файл
-                m_need_record = true;
-            }
+        // вільне місце в буфері
+        const std::uint32_t num_data_store = std::min(av_in_data, buf->available_size);
 
-            // зменшуємо розмір даних для копіювання в буфери запису
-            av_in_data -= num_data_store;
-        }
-        else
+        // звуження до формату запису в тому ж проході, що й копіювання
+        convertToRecord(m_config.format,
+                        src,
+                        static_cast<int>(num_data_store),
+                        buf->record_buffer.data() + static_cast<std::size_t>(buf->pos) * m_sample_size,
+                        m_config.int16_scale);
+
+        buf->pos += num_data_store;            // зміщуємо позицію в буфері для наступного дозапису
+        buf->available_size -= num_data_store; // оновлюємо розмір вільного місця
+        src += num_data_store;                 // решта кадру піде в наступний буфер
+        av_in_data -= num_data_store;
+
+        if (!buf->available_size)
         {
-            // вивільняємо дані
-            buf->is_full        = false;
-            buf->available_size = buf->record_buffer.size();
-            buf->pos            = 0;
+            // віддаємо буфер потоку запису і переходимо до наступного
+            pushReady(buf);
+
+            m_active_buffer = nullptr;
+            is_ready        = true;
         }
     }
+
+    return is_ready;
 }
 
 } // namespace DATA_SOURCE_TASK
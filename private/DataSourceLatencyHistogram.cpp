@@ -0,0 +1,163 @@
+#include "DataSourceLatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace DATA_SOURCE_TASK
+{
+
+const char * latencyStageName(const LATENCY_STAGE & stage)
+{
+    switch (stage)
+    {
+    case LATENCY_STAGE::LATENCY_STAGE_READ:
+        return "read";
+    case LATENCY_STAGE::LATENCY_STAGE_DEFRAME:
+        return "deframe";
+    case LATENCY_STAGE::LATENCY_STAGE_CONVERT:
+        return "validate/convert";
+    case LATENCY_STAGE::LATENCY_STAGE_RECORD_ENQUEUE:
+        return "recorder enqueue";
+    case LATENCY_STAGE::LATENCY_STAGE_SHARED_PUBLISH:
+        return "shared ring publish";
+    case LATENCY_STAGE::LATENCY_STAGE_ENCODE:
+        return "encode";
+    case LATENCY_STAGE::LATENCY_STAGE_DISK_WRITE:
+        return "disk write";
+    default:
+        break;
+    }
+
+    return "unknown";
+}
+
+DataSourceLatencyHistogram::DataSourceLatencyHistogram()
+{
+    for (auto & count : m_counts)
+        count.store(0, std::memory_order_relaxed);
+}
+
+std::size_t DataSourceLatencyHistogram::bucketIndex(const std::uint64_t & value)
+{
+    // перша степінь двійки пишеться як є
+    if (value < LATENCY_SUB_BUCKETS)
+        return static_cast<std::size_t>(value);
+
+    const unsigned msb   = 63 - __builtin_clzll(value);
+    const unsigned shift = msb - LATENCY_SUB_BUCKET_BITS;
+
+    // старший біт відкидаємо, наступні LATENCY_SUB_BUCKET_BITS - номер піддіапазону
+    return (shift + 1) * LATENCY_SUB_BUCKETS + ((value >> shift) & (LATENCY_SUB_BUCKETS - 1));
+}
+
+std::uint64_t DataSourceLatencyHistogram::bucketUpperBound(const std::size_t & index)
+{
+    if (index < LATENCY_SUB_BUCKETS)
+        return index;
+
+    const std::size_t shift = index / LATENCY_SUB_BUCKETS - 1;
+    const std::uint64_t sub = index % LATENCY_SUB_BUCKETS;
+
+    return ((LATENCY_SUB_BUCKETS + sub) << shift) + ((std::uint64_t(1) << shift) - 1);
+}
+
+void DataSourceLatencyHistogram::record(std::int64_t value_ns)
+{
+    if (value_ns < 0)
+        value_ns = 0;
+
+    m_counts[bucketIndex(static_cast<std::uint64_t>(value_ns))].fetch_add(1, std::memory_order_relaxed);
+    m_sum_ns.fetch_add(static_cast<std::uint64_t>(value_ns), std::memory_order_relaxed);
+
+    std::int64_t cur = m_max_ns.load(std::memory_order_relaxed);
+    while (value_ns > cur && !m_max_ns.compare_exchange_weak(cur, value_ns, std::memory_order_relaxed))
+    {
+    }
+
+    cur = m_min_ns.load(std::memory_order_relaxed);
+    while (value_ns < cur && !m_min_ns.compare_exchange_weak(cur, value_ns, std::memory_order_relaxed))
+    {
+    }
+}
+
+std::int64_t DataSourceLatencyHistogram::percentile(
+    const std::uint64_t * counts,
+    const std::uint64_t & total,
+    const double & percentile) const
+{
+    if (!total)
+        return 0;
+
+    // ранг виміру, який має бути не більшим за шукане значення
+    const double q     = std::min(std::max(percentile, 0.), 100.) / 100.;
+    std::uint64_t rank = static_cast<std::uint64_t>(std::ceil(q * total));
+    rank               = std::max<std::uint64_t>(rank, 1);
+
+    const std::int64_t max_ns = m_max_ns.load(std::memory_order_relaxed);
+
+    std::uint64_t accumulated = 0;
+
+    for (std::size_t i = 0; i < LATENCY_BUCKETS; ++i)
+    {
+        accumulated += counts[i];
+
+        if (accumulated >= rank)
+            return std::min(static_cast<std::int64_t>(bucketUpperBound(i)), max_ns);
+    }
+
+    return max_ns;
+}
+
+std::int64_t DataSourceLatencyHistogram::percentile(const double & percentile) const
+{
+    std::uint64_t counts[LATENCY_BUCKETS];
+    std::uint64_t total = 0;
+
+    for (std::size_t i = 0; i < LATENCY_BUCKETS; ++i)
+    {
+        counts[i] = m_counts[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+
+    return this->percentile(counts, total, percentile);
+}
+
+latency_snapshot DataSourceLatencyHistogram::snapshot() const
+{
+    latency_snapshot snapshot;
+
+    std::uint64_t counts[LATENCY_BUCKETS];
+    std::uint64_t total = 0;
+
+    for (std::size_t i = 0; i < LATENCY_BUCKETS; ++i)
+    {
+        counts[i] = m_counts[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+
+    if (!total)
+        return snapshot;
+
+    snapshot.count   = total;
+    snapshot.min_ns  = m_min_ns.load(std::memory_order_relaxed);
+    snapshot.max_ns  = m_max_ns.load(std::memory_order_relaxed);
+    snapshot.mean_ns = static_cast<std::int64_t>(m_sum_ns.load(std::memory_order_relaxed) / total);
+    snapshot.p50_ns  = percentile(counts, total, 50.);
+    snapshot.p90_ns  = percentile(counts, total, 90.);
+    snapshot.p99_ns  = percentile(counts, total, 99.);
+    snapshot.p999_ns = percentile(counts, total, 99.9);
+
+    return snapshot;
+}
+
+void DataSourceLatencyHistogram::reset()
+{
+    for (auto & count : m_counts)
+        count.store(0, std::memory_order_relaxed);
+
+    m_sum_ns.store(0, std::memory_order_relaxed);
+    m_min_ns.store(std::numeric_limits<std::int64_t>::max(), std::memory_order_relaxed);
+    m_max_ns.store(0, std::memory_order_relaxed);
+}
+
+} // namespace DATA_SOURCE_TASK
@@ -0,0 +1,147 @@
+#include "DataSourceMetrics.h"
+
+#include <chrono>
+#include <cstring>
+#include <type_traits>
+
+namespace DATA_SOURCE_TASK
+{
+
+static_assert(std::is_trivially_copyable<metrics_snapshot>::value, "metrics_snapshot is copied word by word");
+
+const char * metricCounterName(const METRIC_COUNTER & counter)
+{
+    switch (counter)
+    {
+    case METRIC_COUNTER::METRIC_COUNTER_FRAMES:
+        return "frames";
+    case METRIC_COUNTER::METRIC_COUNTER_BYTES:
+        return "bytes";
+    case METRIC_COUNTER::METRIC_COUNTER_PACKETS_LOSS:
+        return "packets_loss";
+    case METRIC_COUNTER::METRIC_COUNTER_BAD_FRAMES:
+        return "bad_frames";
+    case METRIC_COUNTER::METRIC_COUNTER_BROKEN_FRAMES:
+        return "broken_frames";
+    case METRIC_COUNTER::METRIC_COUNTER_OVERRUNS:
+        return "queue_overruns";
+    case METRIC_COUNTER::METRIC_COUNTER_DROPPED_NEWEST:
+        return "queue_dropped_newest";
+    case METRIC_COUNTER::METRIC_COUNTER_DROPPED_OLDEST:
+        return "queue_dropped_oldest";
+    case METRIC_COUNTER::METRIC_COUNTER_SPILLED:
+        return "queue_spilled";
+    case METRIC_COUNTER::METRIC_COUNTER_BLOCKED:
+        return "queue_blocked";
+    case METRIC_COUNTER::METRIC_COUNTER_BLOCKED_NS:
+        return "queue_blocked_ns";
+    case METRIC_COUNTER::METRIC_COUNTER_TUNE_STEPS:
+        return "tune_steps";
+    case METRIC_COUNTER::METRIC_COUNTER_RECORDERS_EVICTED:
+        return "recorders_evicted";
+    case METRIC_COUNTER::METRIC_COUNTER_CONSUMER_DROPPED:
+        return "consumer_dropped";
+    default:
+        break;
+    }
+
+    return "unknown";
+}
+
+const char * metricGaugeName(const METRIC_GAUGE & gauge)
+{
+    switch (gauge)
+    {
+    case METRIC_GAUGE::METRIC_GAUGE_QUEUE_OCCUPANCY:
+        return "queue_occupancy";
+    case METRIC_GAUGE::METRIC_GAUGE_QUEUE_DEPTH:
+        return "queue_depth";
+    case METRIC_GAUGE::METRIC_GAUGE_MEMORY_BYTES:
+        return "memory_bytes";
+    case METRIC_GAUGE::METRIC_GAUGE_RECORDERS:
+        return "recorders";
+    case METRIC_GAUGE::METRIC_GAUGE_CONSUMERS:
+        return "consumers";
+    case METRIC_GAUGE::METRIC_GAUGE_PROCESS_NS:
+        return "process_ns";
+    case METRIC_GAUGE::METRIC_GAUGE_READ_NS:
+        return "read_ns";
+    default:
+        break;
+    }
+
+    return "unknown";
+}
+
+DataSourceMetrics::DataSourceMetrics()
+{
+    for (auto & word : m_snapshot)
+        word.store(0, std::memory_order_relaxed);
+}
+
+void DataSourceMetrics::publish(const latency_snapshot * latency)
+{
+    std::uint64_t words[SNAPSHOT_WORDS] = {};
+    metrics_snapshot snapshot;
+
+    snapshot.time_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+            .count();
+
+    for (int i = 0; i < static_cast<int>(METRIC_COUNTER::METRIC_COUNTER_SIZE); ++i)
+        snapshot.counters[i] = m_counters[i].value.load(std::memory_order_relaxed);
+
+    for (int i = 0; i < static_cast<int>(METRIC_GAUGE::METRIC_GAUGE_SIZE); ++i)
+        snapshot.gauges[i] = static_cast<std::int64_t>(m_gauges[i].value.load(std::memory_order_relaxed));
+
+    if (latency)
+    {
+        for (int i = 0; i < static_cast<int>(LATENCY_STAGE::LATENCY_STAGE_SIZE); ++i)
+            snapshot.latency[i] = latency[i];
+    }
+
+    memcpy(words, &snapshot, sizeof(snapshot));
+
+    // непарний номер: читачі, що застануть копіювання, повторять спробу
+    const std::uint64_t sequence = m_sequence.load(std::memory_order_relaxed);
+
+    m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (std::size_t i = 0; i < SNAPSHOT_WORDS; ++i)
+        m_snapshot[i].store(words[i], std::memory_order_relaxed);
+
+    m_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+metrics_snapshot DataSourceMetrics::snapshot() const
+{
+    std::uint64_t words[SNAPSHOT_WORDS];
+    std::uint64_t sequence = 0;
+
+    for (;;)
+    {
+        sequence = m_sequence.load(std::memory_order_acquire);
+
+        if (sequence & 1)
+            continue;
+
+        for (std::size_t i = 0; i < SNAPSHOT_WORDS; ++i)
+            words[i] = m_snapshot[i].load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (m_sequence.load(std::memory_order_relaxed) == sequence)
+            break;
+    }
+
+    metrics_snapshot snapshot;
+
+    memcpy(&snapshot, words, sizeof(snapshot));
+
+    snapshot.sequence = sequence / 2;
+
+    return snapshot;
+}
+
+} // namespace DATA_SOURCE_TASK
@@ -0,0 +1,334 @@
+#include "DataSourceMetricsExporter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifndef WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace DATA_SOURCE_TASK
+{
+
+namespace
+{
+
+// Скільки чекаємо на запит клієнта сокета перед відповіддю, мс
+constexpr int METRICS_REQUEST_TIMEOUT_MS {100};
+
+/// \brief Значення мітки: \, " і перенесення рядка екрануються
+std::string escapeLabel(const std::string & value)
+{
+    std::string escaped;
+
+    escaped.reserve(value.size());
+
+    for (const char c : value)
+    {
+        if (c == '\\' || c == '"')
+            escaped += '\\';
+
+        if (c == '\n')
+        {
+            escaped += "\\n";
+            continue;
+        }
+
+        escaped += c;
+    }
+
+    return escaped;
+}
+
+} // namespace
+
+DataSourceMetricsExporter::DataSourceMetricsExporter(const exporter_config & config):
+    m_config {config}
+{
+    if (!m_config.socket_path.empty())
+        openSocket();
+
+    m_thread = std::thread(&DataSourceMetricsExporter::exportLoop, this);
+}
+
+DataSourceMetricsExporter::~DataSourceMetricsExporter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_is_active = false;
+    }
+
+    m_wake.notify_all();
+
+#ifndef WIN32
+    // будимо poll() потоку експорту
+    if (m_socket >= 0)
+        shutdown(m_socket, SHUT_RDWR);
+#endif
+
+    if (m_thread.joinable())
+        m_thread.join();
+
+#ifndef WIN32
+    if (m_socket >= 0)
+    {
+        close(m_socket);
+        unlink(m_config.socket_path.c_str());
+    }
+#endif
+}
+
+void DataSourceMetricsExporter::add(const std::string & source, const DataSourceMetrics * metrics)
+{
+    if (!metrics)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    m_sources.emplace_back(source, metrics);
+}
+
+void DataSourceMetricsExporter::remove(const DataSourceMetrics * metrics)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    m_sources.erase(std::remove_if(m_sources.begin(),
+                                   m_sources.end(),
+                                   [metrics](const std::pair<std::string, const DataSourceMetrics *> & source) {
+                                       return source.second == metrics;
+                                   }),
+                    m_sources.end());
+}
+
+std::string DataSourceMetricsExporter::text() const
+{
+    std::vector<std::pair<std::string, metrics_snapshot>> snapshots;
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        snapshots.reserve(m_sources.size());
+
+        for (const auto & source : m_sources)
+            snapshots.emplace_back(source.first, source.second->snapshot());
+    }
+
+    return format(snapshots);
+}
+
+std::string DataSourceMetricsExporter::format(const std::vector<std::pair<std::string, metrics_snapshot>> & sources)
+{
+    std::ostringstream out;
+
+    out.precision(9);
+
+    for (int i = 0; i < static_cast<int>(METRIC_COUNTER::METRIC_COUNTER_SIZE); ++i)
+    {
+        const std::string name =
+            std::string("datasource_") + metricCounterName(static_cast<METRIC_COUNTER>(i)) + "_total";
+
+        out << "# TYPE " << name << " counter\n";
+
+        for (const auto & source : sources)
+            out << name << "{source=\"" << escapeLabel(source.first) << "\"} " << source.second.counters[i] << "\n";
+    }
+
+    for (int i = 0; i < static_cast<int>(METRIC_GAUGE::METRIC_GAUGE_SIZE); ++i)
+    {
+        const std::string name = std::string("datasource_") + metricGaugeName(static_cast<METRIC_GAUGE>(i));
+
+        out << "# TYPE " << name << " gauge\n";
+
+        for (const auto & source : sources)
+            out << name << "{source=\"" << escapeLabel(source.first) << "\"} " << source.second.gauges[i] << "\n";
+    }
+
+    // затримки етапів - summary з перцентилями гістограм, секунди
+    const char * name = "datasource_stage_latency_seconds";
+
+    out << "# TYPE " << name << " summary\n";
+
+    for (const auto & source : sources)
+    {
+        for (int i = 0; i < static_cast<int>(LATENCY_STAGE::LATENCY_STAGE_SIZE); ++i)
+        {
+            const latency_snapshot & lat = source.second.latency[i];
+
+            const std::string labels = "source=\"" + escapeLabel(source.first) + "\",stage=\""
+                + escapeLabel(latencyStageName(static_cast<LATENCY_STAGE>(i))) + "\"";
+
+            const std::pair<const char *, std::int64_t> quantiles[] = {
+                {"0.5", lat.p50_ns}, {"0.9", lat.p90_ns}, {"0.99", lat.p99_ns}, {"0.999", lat.p999_ns}};
+
+            for (const auto & quantile : quantiles)
+                out << name << "{" << labels << ",quantile=\"" << quantile.first << "\"} " << quantile.second / 1e9
+                    << "\n";
+
+            out << name << "_sum{" << labels << "} " << static_cast<double>(lat.mean_ns) * lat.count / 1e9 << "\n";
+            out << name << "_count{" << labels << "} " << lat.count << "\n";
+        }
+    }
+
+    return out.str();
+}
+
+void DataSourceMetricsExporter::writeFile(const std::string & text) const
+{
+    const std::string temp_path = m_config.file_path + ".tmp";
+
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+
+        if (!file)
+        {
+            std::cout << "DataSourceMetricsExporter: can't write " << temp_path << std::endl;
+            return;
+        }
+
+        file << text;
+    }
+
+#ifdef WIN32
+    // rename() не замінює наявний файл
+    std::remove(m_config.file_path.c_str());
+#endif
+
+    if (std::rename(temp_path.c_str(), m_config.file_path.c_str()) != 0)
+        std::cout << "DataSourceMetricsExporter: can't rename " << temp_path << std::endl;
+}
+
+void DataSourceMetricsExporter::openSocket()
+{
+#ifdef WIN32
+    std::cout << "DataSourceMetricsExporter: local socket is not supported" << std::endl;
+#else
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+
+    address.sun_family = AF_UNIX;
+
+    if (m_config.socket_path.size() >= sizeof(address.sun_path))
+    {
+        std::cout << "DataSourceMetricsExporter: socket path is too long" << std::endl;
+        return;
+    }
+
+    memcpy(address.sun_path, m_config.socket_path.c_str(), m_config.socket_path.size());
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd < 0)
+        return;
+
+    // сокет попереднього запуску
+    unlink(m_config.socket_path.c_str());
+
+    if (bind(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 || listen(fd, 8) != 0)
+    {
+        std::cout << "DataSourceMetricsExporter: can't listen on " << m_config.socket_path << std::endl;
+        close(fd);
+        return;
+    }
+
+    m_socket = fd;
+#endif
+}
+
+void DataSourceMetricsExporter::serveClient()
+{
+#ifndef WIN32
+    const int client = accept(m_socket, nullptr, nullptr);
+
+    if (client < 0)
+        return;
+
+    // запит (HTTP від збирача) дочитуємо, щоб закриття не скинуло з'єднання; клієнт може й не писати нічого
+    char request[4096];
+    std::size_t received = 0;
+
+    pollfd wait_request {client, POLLIN, 0};
+
+    while (received < sizeof(request) && poll(&wait_request, 1, METRICS_REQUEST_TIMEOUT_MS) > 0)
+    {
+        const ssize_t size = recv(client, request + received, sizeof(request) - received, 0);
+
+        if (size <= 0)
+            break;
+
+        received += static_cast<std::size_t>(size);
+
+        if (std::string(request, received).find("\r\n\r\n") != std::string::npos)
+            break;
+    }
+
+    const std::string body = text();
+    const std::string response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+        + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+
+    std::size_t sent = 0;
+
+    while (sent < response.size())
+    {
+        const ssize_t size = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+
+        if (size <= 0)
+            break;
+
+        sent += static_cast<std::size_t>(size);
+    }
+
+    close(client);
+#endif
+}
+
+void DataSourceMetricsExporter::exportLoop()
+{
+    const auto interval = std::chrono::milliseconds(std::max(m_config.interval_ms, 1));
+
+    for (;;)
+    {
+        if (!m_config.file_path.empty())
+            writeFile(text());
+
+        const auto deadline = std::chrono::steady_clock::now() + interval;
+
+#ifndef WIN32
+        // до наступного запису файлу відповідаємо клієнтам сокета
+        while (m_socket >= 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+
+                if (!m_is_active)
+                    return;
+            }
+
+            const auto remaining =
+                std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+
+            if (remaining.count() <= 0)
+                break;
+
+            pollfd wait_client {m_socket, POLLIN, 0};
+
+            if (poll(&wait_client, 1, static_cast<int>(remaining.count())) > 0 && (wait_client.revents & POLLIN))
+                serveClient();
+        }
+#endif
+
+        std::unique_lock<std::mutex> lock(m_lock);
+
+        if (m_wake.wait_until(lock, deadline, [this]() { return !m_is_active; }))
+            return;
+    }
+}
+
+} // namespace DATA_SOURCE_TASK
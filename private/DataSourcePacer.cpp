@@ -0,0 +1,141 @@
+#include "DataSourcePacer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <thread>
+
+#ifdef WIN32
+#include <chrono>
+#else
+#include <time.h>
+#endif
+
+namespace DATA_SOURCE_TASK
+{
+
+namespace
+{
+
+constexpr std::int64_t NS_IN_SEC {1000000000};
+
+std::int64_t monotonicNs()
+{
+#ifdef WIN32
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return static_cast<std::int64_t>(ts.tv_sec) * NS_IN_SEC + ts.tv_nsec;
+#endif
+}
+
+/// \brief Сон до абсолютного моменту на монотонному годиннику
+void sleepUntil(const std::int64_t & deadline_ns)
+{
+#ifdef WIN32
+    std::this_thread::sleep_until(std::chrono::steady_clock::time_point(
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(deadline_ns))));
+#else
+    struct timespec ts;
+    ts.tv_sec  = deadline_ns / NS_IN_SEC;
+    ts.tv_nsec = deadline_ns % NS_IN_SEC;
+
+    // сигнал перериває сон - досипаємо до того ж дедлайну
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+    {
+    }
+#endif
+}
+
+} // namespace
+
+DataSourcePacer::DataSourcePacer(const pacer_config & config):
+    m_config {config}
+{
+    start();
+}
+
+void DataSourcePacer::start()
+{
+    m_deadline_ns = monotonicNs() + m_config.period_ns;
+}
+
+void DataSourcePacer::wait()
+{
+    // без темпу - тільки рахуємо такти
+    if (m_config.period_ns <= 0)
+    {
+        ++m_ticks;
+        return;
+    }
+
+    std::int64_t now = monotonicNs();
+
+    if (now > m_deadline_ns)
+    {
+        // такт вже прострочено
+        ++m_overruns;
+
+        const std::int64_t missed = (now - m_deadline_ns) / m_config.period_ns;
+
+        switch (m_config.catch_up)
+        {
+        case PACER_CATCH_UP::PACER_CATCH_UP_BURST:
+            // дедлайн не зсуваємо, наступні такти підуть без паузи, доки не наздоженемо розклад
+            break;
+        case PACER_CATCH_UP::PACER_CATCH_UP_SKIP:
+            m_deadline_ns += missed * m_config.period_ns;
+            m_missed_ticks += missed;
+            break;
+        case PACER_CATCH_UP::PACER_CATCH_UP_RESET:
+            m_deadline_ns = now;
+            m_missed_ticks += missed;
+            break;
+        }
+    }
+    else
+    {
+        // спимо до моменту активного очікування
+        const std::int64_t wake_ns = m_deadline_ns - m_config.spin_ns;
+
+        if (wake_ns > now)
+            sleepUntil(wake_ns);
+
+        now = monotonicNs();
+
+        while (now < m_deadline_ns)
+            now = monotonicNs();
+
+        const std::int64_t jitter = now - m_deadline_ns;
+
+        m_last_jitter_ns = jitter;
+        m_sum_jitter_ns += jitter;
+
+        if (jitter > m_max_jitter_ns)
+            m_max_jitter_ns = jitter;
+    }
+
+    ++m_ticks;
+    m_deadline_ns += m_config.period_ns;
+}
+
+pacer_stats DataSourcePacer::stats() const
+{
+    pacer_stats stats;
+
+    stats.ticks          = m_ticks;
+    stats.overruns       = m_overruns;
+    stats.missed_ticks   = m_missed_ticks;
+    stats.last_jitter_ns = m_last_jitter_ns;
+    stats.max_jitter_ns  = m_max_jitter_ns;
+
+    const std::uint64_t waited = stats.ticks - stats.overruns;
+
+    stats.mean_jitter_ns = waited ? m_sum_jitter_ns / static_cast<std::int64_t>(waited) : 0;
+
+    return stats;
+}
+
+} // namespace DATA_SOURCE_TASK
@@ -0,0 +1,220 @@
+#include "DataSourceRecordWriterPool.h"
+#include "DataSourceFrameRecorder.h"
+
+#include <algorithm>
+
+namespace DATA_SOURCE_TASK
+{
+
+DataSourceRecordWriterPool::DataSourceRecordWriterPool(
+    const std::size_t & threads,
+    const std::uint64_t & memory_budget):
+    m_memory_budget {memory_budget}
+{
+    const std::size_t count = std::max<std::size_t>(threads, 1);
+
+    m_threads.reserve(count);
+
+    for (std::size_t i = 0; i < count; ++i)
+        m_threads.emplace_back(&DataSourceRecordWriterPool::writerLoop, this);
+}
+
+DataSourceRecordWriterPool::~DataSourceRecordWriterPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_is_active = false;
+    }
+
+    m_wake.notify_all();
+
+    for (auto & thread : m_threads)
+    {
+        if (thread.joinable())
+            thread.join();
+    }
+
+    // потоки дописали чергу перед виходом
+    m_retired.clear();
+}
+
+std::shared_ptr<DataSourceRecordWriterPool> DataSourceRecordWriterPool::shared()
+{
+    static std::shared_ptr<DataSourceRecordWriterPool> pool = std::make_shared<DataSourceRecordWriterPool>();
+
+    return pool;
+}
+
+bool DataSourceRecordWriterPool::isBusy(const DataSourceFrameRecorder * recorder) const
+{
+    return std::find(m_queue.begin(), m_queue.end(), recorder) != m_queue.end()
+        || std::find(m_running.begin(), m_running.end(), recorder) != m_running.end();
+}
+
+void DataSourceRecordWriterPool::submit(DataSourceFrameRecorder * recorder)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        if (std::find(m_running.begin(), m_running.end(), recorder) != m_running.end())
+        {
+            // пишеться зараз: повторимо після, щоб не писати один реєстратор з двох потоків
+            if (std::find(m_rerun.begin(), m_rerun.end(), recorder) == m_rerun.end())
+                m_rerun.push_back(recorder);
+
+            return;
+        }
+
+        if (std::find(m_queue.begin(), m_queue.end(), recorder) != m_queue.end())
+            return;
+
+        m_queue.push_back(recorder);
+    }
+
+    m_wake.notify_one();
+}
+
+void DataSourceRecordWriterPool::wait(DataSourceFrameRecorder * recorder)
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    m_done.wait(lock, [this, recorder]() { return !isBusy(recorder); });
+}
+
+void DataSourceRecordWriterPool::retire(std::shared_ptr<DataSourceFrameRecorder> recorder)
+{
+    if (!recorder)
+        return;
+
+    // неповний буфер теж в запис
+    recorder->flush();
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        DataSourceFrameRecorder * retired = recorder.get();
+
+        m_retired.push_back(std::move(recorder));
+
+        // потік, що зараз його пише, знищить його сам; інакше - через чергу
+        if (isBusy(retired))
+            return;
+
+        m_queue.push_back(retired);
+    }
+
+    m_wake.notify_one();
+}
+
+void DataSourceRecordWriterPool::waitRetired()
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    m_done.wait(lock, [this]() { return m_retired.empty() && !m_destroying; });
+}
+
+std::size_t DataSourceRecordWriterPool::retiredCount() const
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    return m_retired.size() + m_destroying;
+}
+
+std::size_t DataSourceRecordWriterPool::reserve(const std::uint64_t & bytes, const std::size_t & count)
+{
+    if (!bytes || !m_memory_budget)
+    {
+        m_memory_used += bytes * count;
+        return count;
+    }
+
+    std::uint64_t used = m_memory_used;
+
+    for (;;)
+    {
+        const std::uint64_t available = m_memory_budget > used ? m_memory_budget - used : 0;
+        const std::size_t granted     = static_cast<std::size_t>(std::min<std::uint64_t>(count, available / bytes));
+
+        if (!granted || m_memory_used.compare_exchange_weak(used, used + granted * bytes))
+            return granted;
+    }
+}
+
+void DataSourceRecordWriterPool::reserveForced(const std::uint64_t & bytes)
+{
+    m_memory_used += bytes;
+}
+
+void DataSourceRecordWriterPool::release(const std::uint64_t & bytes)
+{
+    m_memory_used -= std::min<std::uint64_t>(bytes, m_memory_used);
+}
+
+void DataSourceRecordWriterPool::writerLoop()
+{
+    for (;;)
+    {
+        DataSourceFrameRecorder * recorder = nullptr;
+
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+
+            m_wake.wait(lock, [this]() { return !m_is_active || !m_queue.empty(); });
+
+            // перед виходом дописуємо чергу
+            if (m_queue.empty())
+                return;
+
+            recorder = m_queue.front();
+            m_queue.pop_front();
+            m_running.push_back(recorder);
+        }
+
+        recorder->writeReady();
+
+        std::shared_ptr<DataSourceFrameRecorder> finished;
+
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+
+            m_running.erase(std::find(m_running.begin(), m_running.end(), recorder));
+
+            const auto rerun = std::find(m_rerun.begin(), m_rerun.end(), recorder);
+
+            if (rerun != m_rerun.end())
+            {
+                m_rerun.erase(rerun);
+                m_queue.push_back(recorder);
+            }
+            else
+            {
+                const auto retired = std::find_if(
+                    m_retired.begin(), m_retired.end(), [recorder](const std::shared_ptr<DataSourceFrameRecorder> & r) {
+                        return r.get() == recorder;
+                    });
+
+                if (retired != m_retired.end())
+                {
+                    finished = std::move(*retired);
+                    m_retired.erase(retired);
+                    ++m_destroying;
+                }
+            }
+        }
+
+        m_wake.notify_one();
+
+        if (finished)
+        {
+            // витіснений реєстратор дописано: закриття сегменту і звільнення буферів - поза блокуванням
+            finished.reset();
+
+            std::lock_guard<std::mutex> lock(m_lock);
+            --m_destroying;
+        }
+
+        m_done.notify_all();
+    }
+}
+
+} // namespace DATA_SOURCE_TASK
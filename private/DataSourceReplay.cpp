@@ -0,0 +1,428 @@
+#include "DataSourceReplay.h"
+#include "DataSourceConvert.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+namespace DATA_SOURCE_TASK
+{
+
+namespace
+{
+
+/// \brief Тип кадрів відтворення: тип джерела з заголовку контейнера, невідомий - float
+PAYLOAD_TYPE capturePayloadType(const capture_file_header & header)
+{
+    const PAYLOAD_TYPE type = static_cast<PAYLOAD_TYPE>(header.payload_type);
+
+    return payloadTypeSize(type) ? type : PAYLOAD_TYPE::PAYLOAD_TYPE_32_BIT_IEEE_FLOAT;
+}
+
+bool isCaptureFile(const std::string & file_name)
+{
+    std::FILE * file = std::fopen(file_name.c_str(), "rb");
+
+    if (!file)
+        return false;
+
+    std::uint32_t magic = 0;
+
+    const bool is_read = std::fread(&magic, sizeof(magic), 1, file) == 1;
+
+    std::fclose(file);
+
+    return is_read && magic == CAPTURE_FILE_MAGIC;
+}
+
+std::int64_t steadyNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+} // namespace
+
+DataSourceReplay::DataSourceReplay(const std::vector<std::string> & files, const replay_config & config):
+    m_config {config},
+    m_files {files}
+{
+    m_elapsed = 0.;
+
+    // розмір кадру - найбільший з файлів, щоб контролер виділив достатні буфери
+    for (const auto & file_name : m_files)
+    {
+        if (isCaptureFile(file_name))
+        {
+            DataSourceCaptureReader reader(file_name);
+
+            if (!reader.isOpen())
+                continue;
+
+            const int frame_bytes = static_cast<int>(FRAME_HEADER_SIZE
+                                                     + reader.header().frame_elements
+                                                           * payloadTypeSize(capturePayloadType(reader.header())));
+
+            m_frame_size = std::max(m_frame_size, frame_bytes);
+        }
+        else
+        {
+            DataSourceFile raw(file_name);
+            const char * header = nullptr;
+
+            if (raw.view(&header, FRAME_HEADER_SIZE) != static_cast<int>(FRAME_HEADER_SIZE))
+            {
+                std::cout << "DataSourceReplay: can't read " << file_name << std::endl;
+                continue;
+            }
+
+            const struct frame * first = reinterpret_cast<const struct frame *>(header);
+
+            m_frame_size = std::max(m_frame_size, static_cast<int>(FRAME_HEADER_SIZE + first->payload_size));
+        }
+    }
+
+    if (!m_frame_size)
+        m_is_finished = true;
+}
+
+DataSourceReplay::~DataSourceReplay() = default;
+
+std::vector<std::string> DataSourceReplay::captureSegments(const std::string & record_name)
+{
+    std::vector<std::string> segments;
+
+    for (std::uint32_t index = 0;; ++index)
+    {
+        char suffix[16];
+        snprintf(suffix, sizeof(suffix), "_%06u", index);
+
+        const std::string name = record_name + suffix + ".bin";
+
+        std::FILE * file = std::fopen(name.c_str(), "rb");
+
+        if (!file)
+            break;
+
+        std::fclose(file);
+        segments.push_back(name);
+    }
+
+    return segments;
+}
+
+pacer_config DataSourceReplay::pacing(const pacer_config & pacing)
+{
+    pacer_config config = pacing;
+
+    // темп задає час кадрів в записі
+    config.period_ns = 0;
+    config.spin_ns   = 0;
+
+    return config;
+}
+
+bool DataSourceReplay::openFile()
+{
+    m_reader.reset();
+    m_raw.reset();
+    m_samples.clear();
+    m_sample_pos  = 0;
+    m_block_index = 0;
+
+    while (m_file_index < m_files.size())
+    {
+        const std::string & file_name = m_files[m_file_index];
+
+        if (isCaptureFile(file_name))
+        {
+            m_reader.reset(new DataSourceCaptureReader(file_name));
+
+            if (m_reader->isOpen())
+                return true;
+
+            m_reader.reset();
+        }
+        else
+        {
+            m_raw.reset(new DataSourceFile(file_name));
+
+            if (m_raw->isOpen())
+                return true;
+
+            m_raw.reset();
+        }
+
+        std::cout << "DataSourceReplay: skip " << file_name << std::endl;
+        ++m_file_index;
+    }
+
+    return false;
+}
+
+bool DataSourceReplay::nextBlock()
+{
+    while (m_reader)
+    {
+        if (m_block_index < m_reader->blockCount())
+        {
+            if (m_reader->readBlock(m_block_index++, m_samples, &m_block))
+            {
+                m_sample_pos = 0;
+
+                if (!m_samples.empty())
+                    return true;
+            }
+
+            continue;
+        }
+
+        // сегмент вичерпано - кадр доскладаємо з наступного, якщо це теж контейнер
+        if (m_file_index + 1 >= m_files.size() || !isCaptureFile(m_files[m_file_index + 1]))
+            return false;
+
+        ++m_file_index;
+
+        if (!openFile())
+            return false;
+    }
+
+    return false;
+}
+
+bool DataSourceReplay::nextCaptureFrame(std::uint64_t & time_ns)
+{
+    const capture_file_header header   = m_reader->header(); // копія: nextBlock() може відкрити наступний сегмент
+    const PAYLOAD_TYPE type            = capturePayloadType(header);
+    const int type_size                = payloadTypeSize(type);
+    const std::size_t elements         = header.frame_elements;
+
+    if (!elements)
+        return false;
+
+    m_frame_buffer.resize(FRAME_HEADER_SIZE + elements * type_size);
+
+    std::size_t filled = 0;
+
+    while (filled < elements)
+    {
+        if (m_sample_pos >= m_samples.size())
+        {
+            if (!nextBlock())
+                return false; // неповний хвіст запису не видаємо
+
+            // Кадр доскладається з нового блоку, лише якщо блок починається з його хвоста. Інакше між блоками
+            // пропуск (реєстратор відкидав кадри, блок не прочитано): недоскладений кадр відкидаємо,
+            // хвіст кадру, початок якого не прочитано, пропускаємо.
+            if (!filled || !m_block.frame_offset || m_block.first_frame != m_frame_index)
+            {
+                filled       = 0;
+                m_sample_pos = std::min<std::size_t>(m_block.frame_offset, m_samples.size());
+                continue;
+            }
+        }
+
+        if (!filled)
+        {
+            // Кадри блоку йдуть підряд з першого, що починається в блоці: лічильник - з діапазону блоку,
+            // тож пропуски кадрів в записі видно і при відтворенні
+            const std::size_t offset = std::min<std::size_t>(m_block.frame_offset, m_samples.size());
+            const std::size_t index  = m_sample_pos > offset ? (m_sample_pos - offset) / elements : 0;
+
+            m_frame_index = m_block.first_frame + (offset ? 1 : 0) + index;
+
+            const std::uint64_t span = m_block.last_ns > m_block.first_ns ? m_block.last_ns - m_block.first_ns : 0;
+
+            time_ns = m_block.first_ns + static_cast<std::uint64_t>(static_cast<double>(span) * m_sample_pos
+                                                                    / std::max<std::size_t>(m_samples.size(), 1));
+        }
+
+        const std::size_t count = std::min(elements - filled, m_samples.size() - m_sample_pos);
+
+        convertFromFloat(type,
+                         m_samples.data() + m_sample_pos,
+                         static_cast<int>(count),
+                         m_frame_buffer.data() + FRAME_HEADER_SIZE + filled * type_size);
+
+        m_sample_pos += count;
+        filled += count;
+    }
+
+    struct frame * out = reinterpret_cast<struct frame *>(m_frame_buffer.data());
+
+    out->magic_word    = FRAME_MAGIC_WORD;
+    out->frame_counter = static_cast<std::uint16_t>(m_frame_index);
+    out->source_id     = static_cast<std::uint8_t>(header.source_id);
+    out->payload_type  = type;
+    out->payload_size  = static_cast<std::uint32_t>(elements * type_size);
+
+    m_frame       = m_frame_buffer.data();
+    m_frame_bytes = static_cast<int>(m_frame_buffer.size());
+
+    return true;
+}
+
+bool DataSourceReplay::nextRawFrame(std::uint64_t & time_ns)
+{
+    const char * data = nullptr;
+
+    // кадр лежить у відображенні суцільно: заголовок, за ним навантаження
+    if (m_raw->view(&data, FRAME_HEADER_SIZE) != static_cast<int>(FRAME_HEADER_SIZE))
+        return false;
+
+    const struct frame * header = reinterpret_cast<const struct frame *>(data);
+
+    if (header->magic_word != FRAME_MAGIC_WORD)
+    {
+        std::cout << "DataSourceReplay: bad frame at " << m_raw->position() - FRAME_HEADER_SIZE << std::endl;
+        return false;
+    }
+
+    const char * payload = nullptr;
+    const int size       = static_cast<int>(header->payload_size);
+
+    if (size < 0 || (size && m_raw->view(&payload, size) != size))
+        return false;
+
+    time_ns = static_cast<std::uint64_t>(static_cast<double>(m_frame_index) * 1e9 / m_config.frame_rate);
+    ++m_frame_index;
+
+    m_frame       = data;
+    m_frame_bytes = static_cast<int>(FRAME_HEADER_SIZE) + size;
+
+    return true;
+}
+
+bool DataSourceReplay::nextFrame()
+{
+    for (int attempt = 0; attempt < 2; ++attempt)
+    {
+        if (!m_reader && !m_raw && !openFile())
+        {
+            if (!m_config.is_looped || m_files.empty())
+                break;
+
+            // повтор: спочатку, з новою прив'язкою часу
+            m_file_index = 0;
+            m_is_timed   = false;
+
+            if (!openFile())
+                break;
+        }
+
+        while (m_reader || m_raw)
+        {
+            std::uint64_t time_ns = 0;
+
+            const bool is_ready = m_reader ? nextCaptureFrame(time_ns) : nextRawFrame(time_ns);
+
+            if (is_ready)
+            {
+                waitDue(time_ns);
+
+                m_frame_pos = 0;
+                ++m_frames;
+
+                return true;
+            }
+
+            // файл вичерпано
+            if (m_raw)
+                m_frame_index = 0;
+
+            m_reader.reset();
+            m_raw.reset();
+            ++m_file_index;
+
+            if (!openFile())
+                break;
+        }
+    }
+
+    m_is_finished = true;
+
+    return false;
+}
+
+void DataSourceReplay::waitDue(const std::uint64_t & time_ns)
+{
+    if (m_config.speed <= 0.)
+        return;
+
+    // час в записі пішов назад (новий файл сирого запису, повтор) - нова прив'язка
+    if (!m_is_timed || time_ns < m_start_time)
+    {
+        m_is_timed   = true;
+        m_start_time = time_ns;
+        m_start_ns   = steadyNs();
+        return;
+    }
+
+    const std::int64_t due =
+        m_start_ns + static_cast<std::int64_t>(static_cast<double>(time_ns - m_start_time) / m_config.speed);
+
+    const std::int64_t wait_ns = due - steadyNs();
+
+    if (wait_ns > 0)
+        std::this_thread::sleep_for(std::chrono::nanoseconds(wait_ns));
+}
+
+read_block DataSourceReplay::acquire(char * buffer, int size)
+{
+    (void) buffer;
+
+    read_block block;
+
+    {
+        std::lock_guard<std::mutex> lock(m_read_lock);
+
+        Timer timer;
+
+        if (!m_is_finished && m_frame_pos >= m_frame_bytes)
+            nextFrame();
+
+        if (!m_is_finished)
+        {
+            block.data    = m_frame + m_frame_pos;
+            block.size    = std::max(0, std::min(size, m_frame_bytes - m_frame_pos));
+            block.is_lent = true;
+        }
+
+        m_elapsed = timer.elapsed();
+    }
+
+    // кінець запису: контролер без пауз не має крутитись вхолосту
+    if (m_is_finished)
+        std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int>(MAX_FREQ_READ * 1000.)));
+
+    return block;
+}
+
+void DataSourceReplay::commit(const read_block & block, int consumed)
+{
+    std::lock_guard<std::mutex> lock(m_read_lock);
+
+    if (!block.is_lent || consumed <= 0)
+        return;
+
+    const int advance = std::min(consumed, block.size);
+
+    m_frame_pos += advance;
+    m_bytes += static_cast<std::uint64_t>(advance);
+}
+
+int DataSourceReplay::read(char * data, int size)
+{
+    const read_block block = acquire(data, size);
+
+    if (block.size > 0)
+        memcpy(data, block.data, block.size);
+
+    commit(block, block.size);
+
+    return block.size;
+}
+
+} // namespace DATA_SOURCE_TASK
@@ -0,0 +1,209 @@
+#include "DataSourceSegmentWriter.h"
+#include "DataSourceAlignedAllocator.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <iostream>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace DATA_SOURCE_TASK
+{
+
+namespace
+{
+
+bool isAligned(const char * data, const std::size_t & size)
+{
+    return (reinterpret_cast<std::uintptr_t>(data) % DIRECT_IO_ALIGNMENT == 0) && (size % DIRECT_IO_ALIGNMENT == 0);
+}
+
+} // namespace
+
+DataSourceSegmentWriter::DataSourceSegmentWriter(
+    const std::string & base_name,
+    const std::uint64_t & segment_size,
+    const std::uint32_t & segment_seconds,
+    const bool & use_direct_io,
+    const std::shared_ptr<std::atomic<std::uint32_t>> & segment_counter):
+    m_base_name {base_name},
+    m_segment_size {segment_size},
+    m_segment_seconds {segment_seconds},
+    m_use_direct_io {use_direct_io},
+    m_segment_counter {segment_counter}
+{
+    if (m_segment_counter)
+        m_segment_index = m_segment_counter->load();
+}
+
+DataSourceSegmentWriter::~DataSourceSegmentWriter()
+{
+    close();
+}
+
+bool DataSourceSegmentWriter::openSegment()
+{
+    // номер зі спільного лічильника: сегменти попередників не перезаписуються
+    if (m_segment_counter)
+        m_segment_index = m_segment_counter->fetch_add(1);
+
+    char index[16];
+    snprintf(index, sizeof(index), "_%06u", m_segment_index);
+
+    m_segment_name = m_base_name + index + ".bin";
+    m_offset       = 0;
+    m_is_direct    = false;
+
+#ifdef WIN32
+    m_file = std::fopen(m_segment_name.c_str(), "wb");
+
+    if (!m_file)
+    {
+        std::cout << "DataSourceSegmentWriter: can't open " << m_segment_name << std::endl;
+        return false;
+    }
+#else
+    const int flags = O_WRONLY | O_CREAT | O_TRUNC;
+
+#ifdef O_DIRECT
+    if (m_use_direct_io)
+    {
+        m_fd        = ::open(m_segment_name.c_str(), flags | O_DIRECT, 0644);
+        m_is_direct = (m_fd >= 0);
+    }
+#endif
+
+    // файлова система без O_DIRECT (tmpfs тощо)
+    if (m_fd < 0)
+        m_fd = ::open(m_segment_name.c_str(), flags, 0644);
+
+    if (m_fd < 0)
+    {
+        std::cout << "DataSourceSegmentWriter: can't open " << m_segment_name << std::endl;
+        return false;
+    }
+#endif
+
+    m_segment_timer.reset();
+
+    return true;
+}
+
+void DataSourceSegmentWriter::close()
+{
+#ifdef WIN32
+    if (m_file)
+        std::fclose(m_file);
+
+    m_file = nullptr;
+#else
+    if (m_fd >= 0)
+        ::close(m_fd);
+
+    m_fd = -1;
+#endif
+}
+
+void DataSourceSegmentWriter::rotate()
+{
+    if (isOpen())
+    {
+        close();
+        ++m_segment_index;
+    }
+}
+
+bool DataSourceSegmentWriter::isOpen() const
+{
+#ifdef WIN32
+    return m_file != nullptr;
+#else
+    return m_fd >= 0;
+#endif
+}
+
+void DataSourceSegmentWriter::dropDirect()
+{
+#if !defined(WIN32) && defined(O_DIRECT)
+    if (m_is_direct)
+    {
+        const int flags = fcntl(m_fd, F_GETFL);
+        fcntl(m_fd, F_SETFL, flags & ~O_DIRECT);
+    }
+#endif
+    m_is_direct = false;
+}
+
+bool DataSourceSegmentWriter::needRotate(const std::size_t & size)
+{
+    if (!m_offset)
+        return false;
+
+    if (m_offset + size > m_segment_size)
+        return true;
+
+    return m_segment_seconds && m_segment_timer.elapsed() >= m_segment_seconds * 1000.;
+}
+
+bool DataSourceSegmentWriter::write(const char * data, const std::size_t & size)
+{
+    if (isOpen() && needRotate(size))
+        rotate();
+
+    return append(data, size);
+}
+
+bool DataSourceSegmentWriter::append(const char * data, const std::size_t & size)
+{
+#ifdef WIN32
+    if (!m_file && !openSegment())
+        return false;
+
+    if (std::fwrite(data, 1, size, m_file) != size)
+    {
+        std::cout << "DataSourceSegmentWriter: write error " << m_segment_name << std::endl;
+        return false;
+    }
+#else
+    if (m_fd < 0 && !openSegment())
+        return false;
+
+    if (m_is_direct && !isAligned(data, size))
+        dropDirect();
+
+    std::size_t written = 0;
+
+    while (written < size)
+    {
+        const ssize_t ret = pwrite(m_fd, data + written, size - written, m_offset + written);
+
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            // ядро відмовило в O_DIRECT для цього запису - продовжуємо через page cache
+            if (errno == EINVAL && m_is_direct)
+            {
+                dropDirect();
+                continue;
+            }
+
+            std::cout << "DataSourceSegmentWriter: write error " << m_segment_name << std::endl;
+            return false;
+        }
+
+        written += static_cast<std::size_t>(ret);
+    }
+#endif
+
+    m_offset += size;
+    m_bytes_written += size;
+
+    return true;
+}
+
+} // namespace DATA_SOURCE_TASK
@@ -0,0 +1,406 @@
+#include "DataSourceSharedRing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#ifndef WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace DATA_SOURCE_TASK
+{
+
+namespace
+{
+
+// Розмітка: заголовок, курсори читачів, слоти
+constexpr std::size_t SHARED_READERS_OFFSET {sizeof(shared_ring_header)};
+constexpr std::size_t SHARED_SLOTS_OFFSET {SHARED_READERS_OFFSET
+                                           + MAX_SHARED_RING_READERS * sizeof(shared_ring_reader)};
+
+static_assert(SHARED_SLOTS_OFFSET % CACHE_LINE_SIZE == 0, "shared ring slots must start on a cache line");
+
+// Розмір слоту: заголовок і відліки, кратно кеш-лінії
+std::uint32_t sharedSlotSize(const std::uint32_t & max_elements)
+{
+    const std::size_t size = sizeof(shared_slot_header) + static_cast<std::size_t>(max_elements) * FLOAT_SIZE;
+
+    return static_cast<std::uint32_t>((size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE);
+}
+
+std::uint64_t publishTimeNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+} // namespace
+
+DataSourceSharedRingWriter::DataSourceSharedRingWriter(
+    const std::string & name,
+    const std::uint8_t & source_id,
+    const std::uint32_t & max_elements,
+    const std::uint32_t & slots):
+    m_name {name}
+{
+#ifdef WIN32
+    std::cout << "DataSourceSharedRingWriter: shared memory is not supported" << std::endl;
+#else
+    const std::uint32_t slot_count = static_cast<std::uint32_t>(ceilPowerOfTwo(std::max<std::uint32_t>(slots, 2)));
+    const std::uint32_t slot_size  = sharedSlotSize(max_elements);
+    const std::size_t size         = SHARED_SLOTS_OFFSET + static_cast<std::size_t>(slot_count) * slot_size;
+
+    // об'єкт попереднього запуску: його читачі дочитають своє відображення
+    shm_unlink(m_name.c_str());
+
+    const int fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+
+    if (fd < 0)
+    {
+        std::cout << "DataSourceSharedRingWriter: can't create " << m_name << std::endl;
+        return;
+    }
+
+    void * memory = MAP_FAILED;
+
+    if (ftruncate(fd, static_cast<off_t>(size)) == 0)
+        memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if (memory == MAP_FAILED)
+    {
+        std::cout << "DataSourceSharedRingWriter: can't map " << m_name << std::endl;
+        shm_unlink(m_name.c_str());
+        return;
+    }
+
+    m_size  = size;
+    m_slots = static_cast<char *>(memory) + SHARED_SLOTS_OFFSET;
+
+    // пам'ять після ftruncate нульова: слоти порожні, курсори вільні
+    m_header = static_cast<shared_ring_header *>(memory);
+
+    m_header->version      = SHARED_RING_VERSION;
+    m_header->slot_count   = slot_count;
+    m_header->slot_size    = slot_size;
+    m_header->max_elements = max_elements;
+    m_header->source_id    = source_id;
+    m_header->created_ns   = publishTimeNs();
+
+    // читач перевіряє magic останнім: решта заголовку вже видна
+    m_header->magic.store(SHARED_RING_MAGIC, std::memory_order_release);
+#endif
+}
+
+DataSourceSharedRingWriter::~DataSourceSharedRingWriter()
+{
+#ifndef WIN32
+    if (!m_header)
+        return;
+
+    m_header->closed.store(1, std::memory_order_release);
+
+    munmap(m_header, m_size);
+    shm_unlink(m_name.c_str());
+#endif
+}
+
+void DataSourceSharedRingWriter::publish(
+    DataSourceBufferInterface & flt_frame,
+    const int & total_elements,
+    const PAYLOAD_TYPE & source_type)
+{
+    if (!m_header)
+        return;
+
+    const std::uint32_t elements = std::min<std::uint32_t>(std::max(total_elements, 0), m_header->max_elements);
+
+    auto * slot = reinterpret_cast<shared_slot_header *>(
+        m_slots + (m_sequence & (m_header->slot_count - 1)) * m_header->slot_size);
+
+    // слот зайнято: читачі старого кадру в release() побачать зміну номера
+    slot->sequence.store(2 * m_sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->timestamp_ns  = publishTimeNs();
+    slot->magic_word    = flt_frame.header();
+    slot->frame_counter = flt_frame.frameCounter();
+    slot->source_id     = flt_frame.sourceId();
+    slot->source_type   = source_type;
+    slot->elements      = elements;
+
+    // відліки одразу за заголовком слоту
+    float * samples = reinterpret_cast<float *>(slot + 1);
+
+    memcpy(samples, flt_frame.payload(), static_cast<std::size_t>(elements) * FLOAT_SIZE);
+
+    slot->sequence.store(2 * m_sequence + 2, std::memory_order_release);
+
+    ++m_sequence;
+
+    m_header->write_sequence.store(m_sequence, std::memory_order_release);
+}
+
+std::uint64_t DataSourceSharedRingWriter::published() const
+{
+    return m_header ? m_header->write_sequence.load(std::memory_order_acquire) : 0;
+}
+
+std::vector<shared_reader_stats> DataSourceSharedRingWriter::readers() const
+{
+    std::vector<shared_reader_stats> stats;
+
+    if (!m_header)
+        return stats;
+
+    auto * readers = reinterpret_cast<shared_ring_reader *>(reinterpret_cast<char *>(m_header) + SHARED_READERS_OFFSET);
+
+    const std::uint64_t written = published();
+
+    for (std::uint32_t i = 0; i < MAX_SHARED_RING_READERS; ++i)
+    {
+        shared_reader_stats reader;
+
+        reader.pid = readers[i].pid.load(std::memory_order_relaxed);
+
+        if (!reader.pid)
+            continue;
+
+        const std::uint64_t cursor = readers[i].cursor.load(std::memory_order_relaxed);
+
+        reader.lag  = written > cursor ? written - cursor : 0;
+        reader.lost = readers[i].lost.load(std::memory_order_relaxed);
+
+        stats.push_back(reader);
+    }
+
+    return stats;
+}
+
+DataSourceSharedRingReader::DataSourceSharedRingReader(const std::string & name, const bool & from_oldest)
+{
+#ifndef WIN32
+    const int fd = shm_open(name.c_str(), O_RDWR, 0);
+
+    if (fd < 0)
+        return;
+
+    struct stat info;
+    void * memory = MAP_FAILED;
+
+    if (fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) >= SHARED_SLOTS_OFFSET)
+        memory = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if (memory == MAP_FAILED)
+        return;
+
+    auto * header = static_cast<shared_ring_header *>(memory);
+
+    const std::size_t size = static_cast<std::size_t>(info.st_size);
+
+    // записувач ще не дописав заголовок або інша версія розмітки
+    if (header->magic.load(std::memory_order_acquire) != SHARED_RING_MAGIC || header->version != SHARED_RING_VERSION
+        || size < SHARED_SLOTS_OFFSET + static_cast<std::size_t>(header->slot_count) * header->slot_size)
+    {
+        munmap(memory, size);
+        return;
+    }
+
+    m_size   = size;
+    m_header = header;
+    m_slots  = static_cast<char *>(memory) + SHARED_SLOTS_OFFSET;
+
+    const std::uint64_t written = m_header->write_sequence.load(std::memory_order_acquire);
+
+    m_cursor = written;
+
+    if (from_oldest)
+        m_cursor = written > m_header->slot_count ? written - m_header->slot_count : 0;
+
+    registerReader();
+#else
+    (void)name;
+    (void)from_oldest;
+#endif
+}
+
+DataSourceSharedRingReader::~DataSourceSharedRingReader()
+{
+#ifndef WIN32
+    if (!m_header)
+        return;
+
+    if (m_reader)
+        m_reader->pid.store(0, std::memory_order_release);
+
+    munmap(m_header, m_size);
+#endif
+}
+
+shared_slot_header * DataSourceSharedRingReader::slot(const std::uint64_t & sequence) const
+{
+    return reinterpret_cast<shared_slot_header *>(
+        m_slots + (sequence & (m_header->slot_count - 1)) * m_header->slot_size);
+}
+
+bool DataSourceSharedRingReader::acquire(shared_frame_view & view)
+{
+    if (!m_header)
+        return false;
+
+    for (;;)
+    {
+        const std::uint64_t written = m_header->write_sequence.load(std::memory_order_acquire);
+
+        if (m_cursor >= written)
+            return false;
+
+        // відстали більше ніж на кільце: кадри курсора вже перезаписано
+        if (written - m_cursor > m_header->slot_count)
+        {
+            const std::uint64_t oldest = written - m_header->slot_count;
+
+            m_lost += oldest - m_cursor;
+            m_cursor = oldest;
+            ++m_overruns;
+
+            updateCursor();
+        }
+
+        shared_slot_header * header = slot(m_cursor);
+
+        const std::uint64_t sequence = header->sequence.load(std::memory_order_acquire);
+
+        if (sequence == 2 * m_cursor + 2)
+        {
+            view.sequence      = m_cursor;
+            view.timestamp_ns  = header->timestamp_ns;
+            view.magic_word    = header->magic_word;
+            view.frame_counter = header->frame_counter;
+            view.source_id     = header->source_id;
+            view.source_type   = header->source_type;
+            view.elements      = std::min(header->elements, m_header->max_elements);
+            view.samples       = reinterpret_cast<const float *>(header + 1);
+
+            // заголовок слоту цілий - кадр наш, відліки перевірить release()
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (header->sequence.load(std::memory_order_relaxed) == sequence)
+            {
+                ++m_cursor;
+                updateCursor();
+
+                return true;
+            }
+        }
+
+        // записувач обігнав курсор між перевірками: кадр втрачено, беремо наступний
+        ++m_lost;
+        ++m_cursor;
+
+        updateCursor();
+    }
+}
+
+bool DataSourceSharedRingReader::release(const shared_frame_view & view)
+{
+    if (!m_header)
+        return false;
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    if (slot(view.sequence)->sequence.load(std::memory_order_relaxed) == 2 * view.sequence + 2)
+        return true;
+
+    ++m_lost;
+
+    if (m_reader)
+        m_reader->lost.store(m_lost, std::memory_order_relaxed);
+
+    return false;
+}
+
+bool DataSourceSharedRingReader::read(shared_frame_view & view, std::vector<float> & samples)
+{
+    for (;;)
+    {
+        if (!acquire(view))
+            return false;
+
+        samples.assign(view.samples, view.samples + view.elements);
+
+        if (release(view))
+        {
+            view.samples = samples.data();
+            return true;
+        }
+    }
+}
+
+std::uint64_t DataSourceSharedRingReader::lag() const
+{
+    if (!m_header)
+        return 0;
+
+    const std::uint64_t written = m_header->write_sequence.load(std::memory_order_acquire);
+
+    return written > m_cursor ? written - m_cursor : 0;
+}
+
+bool DataSourceSharedRingReader::isWriterClosed() const
+{
+    return !m_header || m_header->closed.load(std::memory_order_acquire);
+}
+
+void DataSourceSharedRingReader::registerReader()
+{
+#ifndef WIN32
+    auto * readers = reinterpret_cast<shared_ring_reader *>(reinterpret_cast<char *>(m_header) + SHARED_READERS_OFFSET);
+
+    const std::int64_t pid = static_cast<std::int64_t>(getpid());
+
+    for (std::uint32_t i = 0; i < MAX_SHARED_RING_READERS; ++i)
+    {
+        std::int64_t owner = readers[i].pid.load(std::memory_order_relaxed);
+
+        // курсор процесу, що завершився без деструктора
+        if (owner && kill(static_cast<pid_t>(owner), 0) != 0 && errno == ESRCH)
+        {
+            if (!readers[i].pid.compare_exchange_strong(owner, 0, std::memory_order_relaxed))
+                continue;
+
+            owner = 0;
+        }
+
+        if (owner || !readers[i].pid.compare_exchange_strong(owner, pid, std::memory_order_acquire))
+            continue;
+
+        m_reader = &readers[i];
+        m_reader->lost.store(0, std::memory_order_relaxed);
+        updateCursor();
+
+        return;
+    }
+#endif
+}
+
+void DataSourceSharedRingReader::updateCursor()
+{
+    if (!m_reader)
+        return;
+
+    m_reader->cursor.store(m_cursor, std::memory_order_relaxed);
+    m_reader->lost.store(m_lost, std::memory_order_relaxed);
+}
+
+} // namespace DATA_SOURCE_TASK
@@ -0,0 +1,176 @@
+#include "DataSourceWorkerPool.h"
+
+#include <algorithm>
+
+namespace DATA_SOURCE_TASK
+{
+
+DataSourceWorkerPool::DataSourceWorkerPool(const std::size_t & threads)
+{
+    m_queues.reserve(threads);
+
+    for (std::size_t i = 0; i < threads; ++i)
+        m_queues.emplace_back(new worker_queue());
+
+    m_threads.reserve(threads);
+
+    for (std::size_t i = 0; i < threads; ++i)
+        m_threads.emplace_back(&DataSourceWorkerPool::workerLoop, this, i);
+}
+
+DataSourceWorkerPool::~DataSourceWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_wake_lock);
+        m_is_active = false;
+    }
+
+    m_wake.notify_all();
+
+    for (auto & thread : m_threads)
+    {
+        if (thread.joinable())
+            thread.join();
+    }
+}
+
+std::shared_ptr<DataSourceWorkerPool> DataSourceWorkerPool::shared()
+{
+    static std::shared_ptr<DataSourceWorkerPool> pool = std::make_shared<DataSourceWorkerPool>(
+        std::max<unsigned>(std::thread::hardware_concurrency(), 1) - 1);
+
+    return pool;
+}
+
+void DataSourceWorkerPool::parallelFor(const std::size_t & count, const std::function<void(std::size_t)> & fn)
+{
+    if (!count)
+        return;
+
+    // Без потоків або одна задача - виконуємо на місці
+    if (m_queues.empty() || count == 1)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            fn(i);
+
+        m_executed.fetch_add(count, std::memory_order_relaxed);
+        return;
+    }
+
+    task_group group;
+    group.fn        = &fn;
+    group.remaining = count;
+
+    // Лічильник - до публікації задач: потік, що вкрав задачу, не має зменшити його раніше, ніж він виріс
+    {
+        std::lock_guard<std::mutex> lock(m_wake_lock);
+        m_pending.fetch_add(count, std::memory_order_release);
+    }
+
+    // Суцільні блоки по чергах: кожен потік бере сусідні частини, решту розбирають крадіжкою
+    const std::size_t queues = m_queues.size();
+
+    for (std::size_t q = 0; q < queues; ++q)
+    {
+        const std::size_t begin = q * count / queues;
+        const std::size_t end   = (q + 1) * count / queues;
+
+        if (begin == end)
+            continue;
+
+        std::lock_guard<std::mutex> lock(m_queues[q]->lock);
+
+        for (std::size_t i = begin; i < end; ++i)
+            m_queues[q]->tasks.push_back(task {&group, i});
+    }
+
+    m_wake.notify_all();
+
+    // Викликаючий потік допомагає, поки є задачі, потім чекає чужі
+    task t;
+
+    while (group.remaining.load(std::memory_order_acquire))
+    {
+        if (takeTask(queues, t))
+            run(t);
+        else
+            std::this_thread::yield();
+    }
+}
+
+bool DataSourceWorkerPool::takeTask(const std::size_t & id, task & out)
+{
+    const std::size_t queues = m_queues.size();
+
+    if (id < queues)
+    {
+        worker_queue & own = *m_queues[id];
+        std::lock_guard<std::mutex> lock(own.lock);
+
+        if (!own.tasks.empty())
+        {
+            out = own.tasks.back();
+            own.tasks.pop_back();
+            m_pending.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    // Крадемо з початку чужих черг, починаючи з сусідньої
+    for (std::size_t i = 1; i <= queues; ++i)
+    {
+        const std::size_t victim = (id + i) % queues;
+
+        if (victim == id)
+            continue;
+
+        worker_queue & other = *m_queues[victim];
+        std::lock_guard<std::mutex> lock(other.lock);
+
+        if (!other.tasks.empty())
+        {
+            out = other.tasks.front();
+            other.tasks.pop_front();
+            m_pending.fetch_sub(1, std::memory_order_relaxed);
+
+            if (id < queues)
+                m_stolen.fetch_add(1, std::memory_order_relaxed);
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void DataSourceWorkerPool::run(const task & t)
+{
+    (*t.group->fn)(t.index);
+
+    m_executed.fetch_add(1, std::memory_order_relaxed);
+
+    // Після цього група може бути знищена викликаючим потоком
+    t.group->remaining.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void DataSourceWorkerPool::workerLoop(const std::size_t & id)
+{
+    task t;
+
+    while (true)
+    {
+        if (takeTask(id, t))
+        {
+            run(t);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_wake_lock);
+        m_wake.wait(lock, [this]() { return !m_is_active || m_pending.load(std::memory_order_acquire) > 0; });
+
+        if (!m_is_active)
+            break;
+    }
+}
+
+} // namespace DATA_SOURCE_TASK
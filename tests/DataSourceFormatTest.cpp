@@ -0,0 +1,436 @@
+#include "DataSourceCaptureFile.h"
+#include "DataSourceCodec.h"
+#include "DataSourceConvert.h"
+#include "DataSourceReplay.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Перевірка формату запису: кодування блоків туди і назад, файл-контейнер з футером, індекс з файлу .idx
+// незавершеного сегменту, сканування блоків обрізаного сегменту, відтворення кадрів з пропущеними блоками.
+// Без параметрів, файли створюються в поточному каталозі і видаляються. Код повернення 0 - всі перевірки пройдено.
+
+using namespace DATA_SOURCE_TASK;
+
+namespace
+{
+
+// Префікс файлів, які створює тест
+const std::string TEST_FILE_PREFIX {"format_test_"};
+
+// Відліків в кадрі для перевірок відтворення
+constexpr int TEST_FRAME_ELEMENTS {10};
+
+int g_failures = 0;
+
+#define TEST_CHECK(condition)                                                                                          \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(condition))                                                                                              \
+        {                                                                                                              \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": FAILED: " #condition << std::endl;                          \
+            ++g_failures;                                                                                              \
+        }                                                                                                              \
+    } while (0)
+
+/// \brief Ім'я першого сегменту запису base_name
+std::string segmentName(const std::string & base_name)
+{
+    return base_name + "_000000.bin";
+}
+
+/// \brief Копія файлу: знімок сегменту, який ще пишеться
+bool copyFile(const std::string & from, const std::string & to)
+{
+    std::ifstream in(from, std::ios::binary);
+    std::ofstream out(to, std::ios::binary | std::ios::trunc);
+
+    out << in.rdbuf();
+
+    return in.good() && out.good();
+}
+
+/// \brief Обрізаємо файл до size байт
+bool truncateFile(const std::string & name, const std::size_t & size)
+{
+    std::vector<char> data(size);
+    std::ifstream in(name, std::ios::binary);
+
+    if (!in.read(data.data(), static_cast<std::streamsize>(size)))
+        return false;
+
+    in.close();
+
+    std::ofstream out(name, std::ios::binary | std::ios::trunc);
+
+    return static_cast<bool>(out.write(data.data(), static_cast<std::streamsize>(size)));
+}
+
+/// \brief Записуємо size байт поверх файлу з offset
+bool overwriteFile(const std::string & name, const std::uint64_t & offset, const char * data, const std::size_t & size)
+{
+    std::fstream file(name, std::ios::binary | std::ios::in | std::ios::out);
+
+    file.seekp(static_cast<std::streamoff>(offset));
+
+    return static_cast<bool>(file.write(data, static_cast<std::streamsize>(size)));
+}
+
+/// \brief Опис блоку відліків float
+block_header floatMeta(const std::size_t & samples, const std::uint64_t & first, const std::uint64_t & last)
+{
+    block_header meta;
+
+    meta.element_size = FLOAT_SIZE;
+    meta.format       = static_cast<std::uint8_t>(RECORD_FORMAT::RECORD_FORMAT_FLOAT32);
+    meta.payload_type = static_cast<std::uint8_t>(PAYLOAD_TYPE::PAYLOAD_TYPE_32_BIT_IEEE_FLOAT);
+    meta.source_id    = 3;
+    meta.sample_count = static_cast<std::uint32_t>(samples);
+    meta.first_frame  = first;
+    meta.last_frame   = last;
+    meta.first_ns     = 1000 + first;
+    meta.last_ns      = 1000 + last;
+
+    return meta;
+}
+
+/// \brief Кодуємо і декодуємо size байт, очікуване кодування - expected
+void checkRoundTrip(
+    const std::vector<char> & data,
+    const std::size_t & size,
+    const std::uint8_t & element_size,
+    const RECORD_CODEC & codec,
+    const RECORD_CODEC & expected)
+{
+    DataSourceBlockCodec encoder(codec);
+    DataSourceBlockCodec decoder(codec);
+
+    block_header meta;
+
+    meta.element_size = element_size;
+
+    const std::size_t block_size = encoder.encode(data.data(), static_cast<std::uint32_t>(size), meta);
+
+    block_header header;
+
+    TEST_CHECK(block_size % DIRECT_IO_ALIGNMENT == 0);
+    TEST_CHECK(DataSourceBlockCodec::readHeader(encoder.encoded(), block_size, header));
+    TEST_CHECK(header.codec == static_cast<std::uint8_t>(expected));
+    TEST_CHECK(header.raw_size == size);
+    TEST_CHECK(header.block_size == block_size);
+
+    std::vector<char> out;
+
+    TEST_CHECK(decoder.decode(encoder.encoded(), block_size, out));
+    TEST_CHECK(out.size() == size && std::equal(out.begin(), out.end(), data.begin()));
+
+    // пошкоджений блок не декодується в сміття
+    if (header.encoded_size)
+    {
+        std::vector<char> broken(encoder.encoded(), encoder.encoded() + block_size);
+
+        reinterpret_cast<block_header *>(broken.data())->raw_size = static_cast<std::uint32_t>(size + 1);
+
+        TEST_CHECK(!decoder.decode(broken.data(), broken.size(), out));
+    }
+}
+
+/// \brief Кодування: повільний сигнал стискається, шум - RAW, розмір не кратний відліку, відліки 2 і 4 байти
+void testCodec()
+{
+    std::mt19937 random(12345);
+
+    for (const std::uint8_t element_size : {std::uint8_t(2), std::uint8_t(4)})
+    {
+        for (const std::size_t size : {std::size_t(0), std::size_t(1), std::size_t(3), std::size_t(4093),
+                                       std::size_t(65536), std::size_t(200003)})
+        {
+            std::vector<char> smooth(size);
+            std::vector<char> noise(size);
+
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                // старші байти відліку змінюються повільно
+                smooth[i] = static_cast<char>(i % element_size ? (i / 4096) : (i / element_size) & 0x0f);
+                noise[i]  = static_cast<char>(random());
+            }
+
+            const bool is_compressible = size >= 4093;
+
+            checkRoundTrip(
+                smooth,
+                size,
+                element_size,
+                RECORD_CODEC::RECORD_CODEC_SHUFFLE_LZ,
+                is_compressible ? RECORD_CODEC::RECORD_CODEC_SHUFFLE_LZ : RECORD_CODEC::RECORD_CODEC_RAW);
+            checkRoundTrip(
+                noise, size, element_size, RECORD_CODEC::RECORD_CODEC_SHUFFLE_LZ, RECORD_CODEC::RECORD_CODEC_RAW);
+            checkRoundTrip(smooth, size, element_size, RECORD_CODEC::RECORD_CODEC_RAW, RECORD_CODEC::RECORD_CODEC_RAW);
+        }
+    }
+}
+
+/// \brief Пишемо blocks блоків по block_samples відліків float: відлік - номер блоку і відліку
+void writeBlocks(DataSourceCaptureWriter & writer, const int & blocks, const std::size_t & block_samples)
+{
+    DataSourceBlockCodec codec;
+    std::vector<float> samples(block_samples);
+
+    for (int b = 0; b < blocks; ++b)
+    {
+        for (std::size_t i = 0; i < block_samples; ++i)
+            samples[i] = static_cast<float>(b) + static_cast<float>(i % 100) / 100.f;
+
+        const std::size_t size = codec.encode(
+            reinterpret_cast<const char *>(samples.data()),
+            static_cast<std::uint32_t>(samples.size() * FLOAT_SIZE),
+            floatMeta(block_samples, b * 10, b * 10 + 9));
+
+        TEST_CHECK(writer.write(codec.encoded(), size));
+    }
+}
+
+/// \brief Перевіряємо blocks блоків, записаних writeBlocks()
+void checkBlocks(const DataSourceCaptureReader & reader, const std::size_t & blocks, const std::size_t & block_samples)
+{
+    TEST_CHECK(reader.isOpen());
+    TEST_CHECK(reader.blockCount() == blocks);
+
+    std::vector<float> samples;
+    block_header header;
+
+    for (std::size_t b = 0; b < reader.blockCount(); ++b)
+    {
+        TEST_CHECK(reader.entry(b).first_frame == b * 10);
+        TEST_CHECK(reader.readBlock(b, samples, &header));
+        TEST_CHECK(samples.size() == block_samples);
+        TEST_CHECK(header.source_id == 3);
+
+        for (std::size_t i = 0; i < samples.size(); ++i)
+        {
+            if (samples[i] != static_cast<float>(b) + static_cast<float>(i % 100) / 100.f)
+            {
+                TEST_CHECK(samples[i] == static_cast<float>(b) + static_cast<float>(i % 100) / 100.f);
+                break;
+            }
+        }
+    }
+
+    if (blocks > 2)
+    {
+        TEST_CHECK(reader.findFrame(15) == 1);
+        TEST_CHECK(reader.findFrame(blocks * 10) == blocks);
+        TEST_CHECK(reader.findTime(1000 + 25) == 2);
+    }
+}
+
+/// \brief Записувач -> читач: індекс з футера, з файлу .idx незавершеного сегменту і скануванням блоків
+void testCaptureFile()
+{
+    const std::string base       = TEST_FILE_PREFIX + "capture";
+    const std::string crash_base = TEST_FILE_PREFIX + "crash";
+    const std::string cut_base   = TEST_FILE_PREFIX + "cut";
+
+    constexpr int BLOCKS                = 5;
+    constexpr std::size_t BLOCK_SAMPLES = 3001;
+
+    {
+        DataSourceCaptureWriter writer(base, DEFAULT_SEGMENT_SIZE, 0, TEST_FRAME_ELEMENTS);
+
+        writeBlocks(writer, BLOCKS, BLOCK_SAMPLES);
+
+        // знімок відкритого сегменту - як після аварії: блоки і .idx, футера немає
+        TEST_CHECK(copyFile(segmentName(base), segmentName(crash_base)));
+        TEST_CHECK(copyFile(captureIndexName(segmentName(base)), captureIndexName(segmentName(crash_base))));
+        TEST_CHECK(copyFile(segmentName(base), segmentName(cut_base)));
+
+        writer.close();
+    }
+
+    {
+        DataSourceCaptureReader reader(segmentName(base));
+
+        TEST_CHECK(reader.isComplete());
+        TEST_CHECK(reader.header().frame_elements == TEST_FRAME_ELEMENTS);
+        checkBlocks(reader, BLOCKS, BLOCK_SAMPLES);
+    }
+
+    // файл індексу видаляється разом з записом футера
+    TEST_CHECK(!std::ifstream(captureIndexName(segmentName(base))).good());
+
+    {
+        DataSourceCaptureReader reader(segmentName(crash_base));
+
+        TEST_CHECK(!reader.isComplete());
+        checkBlocks(reader, BLOCKS, BLOCK_SAMPLES);
+
+        // індекс справді з .idx: сканування зупинилось би на пошкодженому заголовку другого блоку
+        TEST_CHECK(overwriteFile(segmentName(crash_base), reader.entry(1).offset, "XXXX", 4));
+    }
+
+    {
+        DataSourceCaptureReader reader(segmentName(crash_base));
+        std::vector<float> samples;
+
+        TEST_CHECK(reader.blockCount() == BLOCKS);
+        TEST_CHECK(!reader.readBlock(1, samples));
+        TEST_CHECK(reader.readBlock(2, samples));
+    }
+
+    {
+        DataSourceCaptureReader reader(segmentName(cut_base));
+
+        TEST_CHECK(reader.blockCount() == BLOCKS);
+
+        // останній блок записано не повністю: сканування зупиняється перед ним
+        const capture_index_entry last = reader.entry(BLOCKS - 1);
+
+        TEST_CHECK(truncateFile(segmentName(cut_base), static_cast<std::size_t>(last.offset + last.block_size / 2)));
+    }
+
+    {
+        DataSourceCaptureReader reader(segmentName(cut_base));
+
+        TEST_CHECK(!reader.isComplete());
+        checkBlocks(reader, BLOCKS - 1, BLOCK_SAMPLES);
+    }
+
+    for (const std::string & name : {base, crash_base, cut_base})
+    {
+        std::remove(segmentName(name).c_str());
+        std::remove(captureIndexName(segmentName(name)).c_str());
+    }
+}
+
+/// \brief Частина кадру в блоці: кадр і к-сть відліків
+struct frame_part
+{
+    int frame;
+    int samples;
+};
+
+/// \brief Блок для відтворення: частини кадрів, діапазон кадрів і хвіст кадру попереднього блоку
+struct replay_block
+{
+    std::vector<frame_part> parts;
+    int first_frame;
+    int last_frame;
+    int frame_offset;
+};
+
+/// \brief Відтворюємо запис: лічильники кадрів, відліки кожного кадру - номер кадру / 100
+std::vector<int> replayFrames(const std::string & base, const std::vector<replay_block> & blocks)
+{
+    {
+        DataSourceCaptureWriter writer(base, DEFAULT_SEGMENT_SIZE, 0, TEST_FRAME_ELEMENTS);
+        DataSourceBlockCodec codec;
+
+        for (const replay_block & block : blocks)
+        {
+            std::vector<float> samples;
+
+            for (const frame_part & part : block.parts)
+                samples.insert(samples.end(), part.samples, static_cast<float>(part.frame) / 100.f);
+
+            block_header meta = floatMeta(samples.size(), block.first_frame, block.last_frame);
+
+            meta.frame_offset = static_cast<std::uint32_t>(block.frame_offset);
+
+            const std::size_t size = codec.encode(
+                reinterpret_cast<const char *>(samples.data()),
+                static_cast<std::uint32_t>(samples.size() * FLOAT_SIZE),
+                meta);
+
+            TEST_CHECK(writer.write(codec.encoded(), size));
+        }
+    }
+
+    replay_config config;
+
+    config.speed = 0;
+
+    DataSourceReplay replay({segmentName(base)}, config);
+
+    std::vector<int> frames;
+    std::vector<char> buffer(FRAME_HEADER_SIZE + TEST_FRAME_ELEMENTS * FLOAT_SIZE);
+
+    // межа на випадок, якщо відтворення не завершиться
+    for (int i = 0; i < 100 && !replay.isFinished(); ++i)
+    {
+        const read_block block = replay.acquire(buffer.data(), static_cast<int>(buffer.size()));
+
+        if (block.size <= 0)
+        {
+            replay.commit(block, 0);
+            continue;
+        }
+
+        const frame * header  = reinterpret_cast<const frame *>(block.data);
+        const float * samples = reinterpret_cast<const float *>(block.data + FRAME_HEADER_SIZE);
+
+        TEST_CHECK(block.size == static_cast<int>(buffer.size()));
+
+        for (int s = 0; s < TEST_FRAME_ELEMENTS; ++s)
+        {
+            if (std::lround(samples[s] * 100.f) != header->frame_counter)
+            {
+                TEST_CHECK(std::lround(samples[s] * 100.f) == header->frame_counter);
+                break;
+            }
+        }
+
+        frames.push_back(header->frame_counter);
+
+        replay.commit(block, block.size);
+    }
+
+    std::remove(segmentName(base).c_str());
+
+    return frames;
+}
+
+/// \brief Кадри, що переходять між блоками, і пропущені кадри та блоки (frame_offset)
+void testReplayFrames()
+{
+    // кадри 4 і 5 відкинуті реєстратором, кадр 3 закрито неповним блоком
+    const std::vector<replay_block> blocks = {
+        {{{0, 10}, {1, 6}}, 0, 1, 0},
+        {{{1, 4}, {2, 10}, {3, 2}}, 1, 3, 4},
+        {{{3, 8}}, 3, 3, 8},
+        {{{6, 10}, {7, 6}}, 6, 7, 0},
+        {{{7, 4}}, 7, 7, 4},
+    };
+
+    TEST_CHECK(replayFrames(TEST_FILE_PREFIX + "replay", blocks) == std::vector<int>({0, 1, 2, 3, 6, 7}));
+
+    // другого блоку немає: початок кадру 1 відкидається, хвіст кадру 3 пропускається за frame_offset
+    const std::vector<replay_block> gap = {blocks[0], blocks[2], blocks[3], blocks[4]};
+
+    TEST_CHECK(replayFrames(TEST_FILE_PREFIX + "gap", gap) == std::vector<int>({0, 6, 7}));
+}
+
+} // namespace
+
+int main()
+{
+    testCodec();
+    testCaptureFile();
+    testReplayFrames();
+
+    if (g_failures)
+    {
+        std::cerr << g_failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+
+    std::cout << "all checks passed" << std::endl;
+
+    return 0;
+}